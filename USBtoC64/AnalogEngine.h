@@ -0,0 +1,187 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: AnalogEngine.h
+// Description: DB9 output modes (C64 Paddles / Amiga Duty-Cycle Joystick / CD32 Pad / Stick Mouse switching) and stick -> 8-way mapping
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "Globals.h"
+#include "Hardware.h"
+#include "StickMouse.h"
+
+// ==========================================
+// 🎛️ PART 1: CALIBRATION TABLES
+// ==========================================
+// Every raw axis byte (0-255) is translated once at boot, so a report update is
+// just a table lookup and a 32-bit store that the SID/frame ISRs pick up on their next cycle.
+
+static int8_t   paddle_curve[256];    // Signed deflection (-127..127) after deadzone and curve
+static uint32_t paddle_delay_x[256];  // C64: SID timer delay for POT X
+static uint32_t paddle_delay_y[256];  // C64: SID timer delay for POT Y
+static uint32_t duty_ticks_lut[256];  // Amiga: direction pulse width in timer ticks
+
+inline void build_paddle_tables() {
+    for (int raw = 0; raw < 256; raw++) {
+        int v = raw - 128;
+        int mag = abs(v);
+        if (mag > 127) mag = 127;
+
+        // Deadzone + calibration curve
+        int out = 0;
+        if (mag > PADDLE_CENTER_DEADZONE) {
+            float n = (float)(mag - PADDLE_CENTER_DEADZONE) / (float)(127 - PADDLE_CENTER_DEADZONE);
+            if (PADDLE_CURVE_EXP == 2) n = n * n;
+            out = (int)(n * 127.0f + 0.5f);
+        }
+        int defl = (v < 0) ? -out : out;
+        paddle_curve[raw] = (int8_t)defl;
+
+        // C64: spread the deflection across the calibrated SID window
+        float pos = (float)(defl + 127) / 254.0f;
+        float pos_y = PADDLE_Y_INVERT ? (1.0f - pos) : pos;
+        paddle_delay_x[raw] = (uint32_t)(MINdelayOnX + pos * (float)(MAXdelayOnX - MINdelayOnX));
+        paddle_delay_y[raw] = (uint32_t)(MINdelayOnY + pos_y * (float)(MAXdelayOnY - MINdelayOnY));
+
+        // Amiga: direction held for a time proportional to the deflection (10 ticks per microsecond)
+        duty_ticks_lut[raw] = (uint32_t)((float)out * AMIGA_DUTY_PULSE_SCALE * 10.0f);
+    }
+}
+
+
+// ==========================================
+// 🕹️ PART 2: OUTPUT MODE SWITCHING
+// ==========================================
+
+inline void set_output_mode(OutputMode mode) {
+    active_output_mode = mode;
+    duty_x_mask = 0;
+    duty_y_mask = 0;
+
+    // Leaving stick-mouse mode: the quadrature / 1351 button lines go back to released
+    bool stick_mouse_was_on = sm_running;
+    stick_mouse_enable(mode == OUT_MOUSE);
+    if (stick_mouse_was_on && mode != OUT_MOUSE && !is_mouse_connected) {
+        set_joy_pin(GP_UP, false); set_joy_pin(GP_DOWN, false);
+        set_joy_pin(GP_LEFT, false); set_joy_pin(GP_RIGHT, false);
+        set_joy_pin(GP_FIRE1, false);
+        if (is_amiga) { set_joy_pin(GP_FIRE2, false); set_fire3_pin(false); }
+    }
+
+    if (is_amiga) {
+        // Duty-cycle direction lines are handled frame by frame by amigaDutyFrame()
+        static bool cd32_was_on = false;
+        bool cd32_on = (mode == OUT_CD32);
+        if (cd32_on != cd32_was_on) {
+            cd32_enable(cd32_on);
+            if (!cd32_on) {
+                set_joy_pin(GP_FIRE1, false); set_joy_pin(GP_FIRE2, false);
+                set_fire3_pin(false);
+            }
+            cd32_was_on = cd32_on;
+        }
+        return;
+    }
+
+    if (mode == OUT_PADDLE || mode == OUT_MOUSE) {
+        // POT lines must float: the hardware timers inject the paddle / 1351 position
+        pinMode(GP_FIRE2, INPUT);
+        pinMode(GP_POTY, INPUT);
+        delayOnX = paddle_delay_x[128];
+        delayOnY = paddle_delay_y[128];
+    } else if (!is_mouse_connected) {
+        // Back to digital Fire 2 / Fire 3 (released)
+        set_joy_pin(GP_FIRE2, false);
+        set_fire3_pin(false);
+    }
+}
+
+
+// ==========================================
+// 🎚️ PART 3: PER-REPORT UPDATE (CONSTANT TIME)
+// ==========================================
+// dpad_x / dpad_y: the digital pad is pressing that axis, so it owns the line on Amiga.
+
+inline void paddle_update(uint8_t raw_x, uint8_t raw_y, bool dpad_x, bool dpad_y) {
+    if (!is_amiga) {
+        delayOnX = paddle_delay_x[raw_x];
+        delayOnY = paddle_delay_y[raw_y];
+        return;
+    }
+
+    int dx = paddle_curve[raw_x];
+    int dy = AMIGA_DUTY_Y_INVERT ? -paddle_curve[raw_y] : paddle_curve[raw_y];
+
+    // Ticks first, then the mask: the frame ISR only arms a pulse when the mask is set
+    duty_x_ticks = duty_ticks_lut[raw_x];
+    duty_y_ticks = duty_ticks_lut[raw_y];
+    duty_x_mask = (dpad_x || dx == 0) ? 0 : (1UL << (dx < 0 ? GP_LEFT : GP_RIGHT));
+    duty_y_mask = (dpad_y || dy == 0) ? 0 : (1UL << (dy < 0 ? GP_UP : GP_DOWN));
+    if (dpad_x && duty_x_armed) duty_cancel_pulse(timerOffX, duty_x_armed);
+    if (dpad_y && duty_y_armed) duty_cancel_pulse(timerOffY, duty_y_armed);
+}
+
+// Converts a signed 16-bit axis (HYBRID_16BIT_BITMASK pads) to the 0-255 raw scale
+inline uint8_t axis16_to_raw(int16_t axis, bool invert) {
+    int v = (axis >> 8) + 128;
+    if (invert) v = 255 - v;
+    return (uint8_t)constrain(v, 0, 255);
+}
+
+
+// ==========================================
+// 🧭 PART 4: ANALOG STICK -> 8-WAY DIRECTIONS
+// ==========================================
+// Radial deadzone + 8 angular sectors, shared by the native and the HTML engine.
+// Everything is precomputed at boot: a report costs two square lookups, one compare
+// for the deadzone and one table compare for the sector (octant + slope), no trig.
+//
+// Sector test in the X-dominant octant (|x| >= |y|): the stick is a pure LEFT/RIGHT while
+// |y| < |x| * tan(STICK_CARDINAL_DEG), a diagonal otherwise (same with x/y swapped).
+
+static uint16_t stick_sq[128];        // v^2 for v = 0..127
+static uint8_t  stick_lim[3][128];    // |minor| limit of a cardinal sector for each |major|: [nominal, widened, narrowed]
+static uint16_t stick_dz_out2, stick_dz_in2;
+
+#define STICK_LIM_NOMINAL 0
+#define STICK_LIM_STAY    1  // Was on this cardinal: sector widened by the hysteresis
+#define STICK_LIM_LEAVE   2  // Was on the neighbouring diagonal: sector narrowed
+
+inline void build_stick_tables() {
+    const float deg[3] = { STICK_CARDINAL_DEG, STICK_CARDINAL_DEG + STICK_HYST_DEG, STICK_CARDINAL_DEG - STICK_HYST_DEG };
+    for (int t = 0; t < 3; t++) {
+        float d = constrain(deg[t], 1.0f, 44.0f);
+        float slope = tanf(d * (float)M_PI / 180.0f);
+        for (int v = 0; v < 128; v++) stick_lim[t][v] = (uint8_t)ceilf(v * slope);
+    }
+    for (int v = 0; v < 128; v++) stick_sq[v] = v * v;
+
+    int dz_out = STICK_DEADZONE, dz_in = STICK_DEADZONE - STICK_DEADZONE_HYST;
+    if (dz_in < 0) dz_in = 0;
+    stick_dz_out2 = dz_out * dz_out;
+    stick_dz_in2 = dz_in * dz_in;
+}
+
+// x / y: signed deflection (-128..127, negative y = up). 'dir' keeps the last JS_* directions
+// of this stick for the hysteresis. Returns JS_UP / JS_DOWN / JS_LEFT / JS_RIGHT bits.
+inline uint8_t stick_to_dirs(uint8_t &dir, int x, int y) {
+    int ax = abs(x); if (ax > 127) ax = 127;
+    int ay = abs(y); if (ay > 127) ay = 127;
+
+    // Radial deadzone: leave the centre beyond the outer radius, come back inside the inner one
+    uint16_t r2 = stick_sq[ax] + stick_sq[ay];
+    if (r2 < (dir ? stick_dz_in2 : stick_dz_out2)) { dir = 0; return 0; }
+
+    uint8_t h = (x < 0) ? JS_LEFT : JS_RIGHT;
+    uint8_t v = (y < 0) ? JS_UP : JS_DOWN;
+    uint8_t major = (ax >= ay) ? h : v;
+    int a_major = (ax >= ay) ? ax : ay;
+    int a_minor = (ax >= ay) ? ay : ax;
+
+    int t = STICK_LIM_NOMINAL;
+    if (dir == major) t = STICK_LIM_STAY;
+    else if (dir == (h | v)) t = STICK_LIM_LEAVE;
+
+    dir = (a_minor < stick_lim[t][a_major]) ? major : (h | v);
+    return dir;
+}
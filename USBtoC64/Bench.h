@@ -0,0 +1,155 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: Bench.h
+// Description: On-device micro-benchmark of the decode stages ('bench'), timed with the CPU cycle counter
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_cpu.h"
+#include "Globals.h"
+#include "InputEngine.h"
+#include "UsbDevices.h"
+#include "PowerGovernor.h"
+#include "CoreTasks.h"
+
+// ==========================================
+// ⏱️ PART 1: SYNTHETIC REPORTS AND STATS
+// ==========================================
+// Every stage gets the same pseudo-random reports (fixed seed), so the numbers can be compared
+// across firmware versions. The loop runs the benchmark itself: the stages see the same core,
+// caches and interrupts as in play, and nothing else touches their state meanwhile.
+// Output pins and the LED are stubbed (pins_stubbed): only the decode and routing cost is measured.
+
+#define BENCH_ITERATIONS  256
+#define BENCH_REPORT_LEN  64
+#define BENCH_SEED        0xC64A1200UL
+
+struct BenchStat {
+    uint32_t n, min, max;
+    uint64_t sum;
+};
+
+static uint32_t bench_rng;
+
+inline uint32_t bench_rand() {
+    bench_rng = bench_rng * 1664525UL + 1013904223UL; // LCG: identical sequence on every run
+    return bench_rng >> 8;
+}
+
+inline void bench_fill_report(uint8_t *r) {
+    for (int i = 0; i < BENCH_REPORT_LEN; i++) r[i] = (uint8_t)bench_rand();
+}
+
+inline void bench_add(BenchStat &s, uint32_t cycles) {
+    if (!s.n || cycles < s.min) s.min = cycles;
+    if (cycles > s.max) s.max = cycles;
+    s.sum += cycles;
+    s.n++;
+}
+
+inline void bench_print(const char *stage, const char *name, uint32_t mhz, const BenchStat &s) {
+    uint32_t mean = s.n ? (uint32_t)(s.sum / s.n) : 0;
+    Serial2.printf("BENCH,%lu,%s,%s,%lu,%lu,%lu,%lu,%.2f\n", (unsigned long)mhz, stage, name,
+                   (unsigned long)s.n, (unsigned long)s.min, (unsigned long)mean, (unsigned long)s.max,
+                   (float)mean / mhz);
+}
+
+
+// ==========================================
+// 🔬 PART 2: STAGES
+// ==========================================
+
+inline void bench_joystick(const PadConfig &prof, bool html, uint32_t mhz, const char *stage) {
+    static DevState ds;
+    memset(&ds, 0, sizeof(ds));
+    uint8_t rep[BENCH_REPORT_LEN];
+    BenchStat s = {};
+    bench_rng = BENCH_SEED;
+    use_html_configurator = html;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bench_fill_report(rep);
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        process_joystick(prof, ds, rep, BENCH_REPORT_LEN);
+        bench_add(s, esp_cpu_get_cycle_count() - t0);
+    }
+    bench_print(stage, html ? "JoystickMapping.h" : prof.name, mhz, s);
+}
+
+inline void bench_mouse(uint32_t mhz) {
+    BenchStat s = {};
+    bench_rng = BENCH_SEED;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        uint8_t btn = bench_rand() & 0x07;
+        int8_t dx = (int8_t)(bench_rand() % 41) - 20;
+        int8_t dy = (int8_t)(bench_rand() % 41) - 20;
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        process_mouse(btn, dx, dy);
+        bench_add(s, esp_cpu_get_cycle_count() - t0);
+    }
+    bench_print("mouse", is_amiga ? "amiga_quadrature" : "c64_1351", mhz, s);
+}
+
+inline void bench_outputs(uint32_t mhz) {
+    BenchStat s = {};
+    bench_rng = BENCH_SEED;
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        set_joy_word((uint16_t)(bench_rand() & 0x3FFF));
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        update_hardware_and_leds();
+        bench_add(s, esp_cpu_get_cycle_count() - t0);
+    }
+    bench_print("outputs", "update_hardware_and_leds", mhz, s);
+}
+
+// Runs every stage at the current clock
+inline void bench_pass(uint32_t mhz) {
+    for (int i = 0; i < NUM_PROFILES; i++) bench_joystick(PROFILES[i], false, mhz, "joystick");
+#if HAS_HTML_CONFIGURATOR
+    bench_joystick(current_profile, true, mhz, "html_rules");
+#endif
+    bench_mouse(mhz);
+    bench_outputs(mhz);
+}
+
+// Locks the CPU at the low or high governor clock, returns the clock really running
+inline uint32_t bench_set_cpu(bool fast) {
+    if (pm_ok) pm_set_cpu_lock(fast);
+    else setCpuFrequencyMhz(fast ? POWER_MAX_MHZ : POWER_MIN_MHZ);
+    delay(2); // Let the clock switch settle
+    return getCpuFrequencyMhz();
+}
+
+
+// ==========================================
+// 📊 PART 3: ENTRY POINT (LOOP TASK)
+// ==========================================
+
+inline void run_bench() {
+    // Everything the stages touch is put back afterwards
+    SystemMode saved_mode = current_mode;
+    bool saved_html = use_html_configurator;
+    uint64_t saved_on_x = delayOnX, saved_on_y = delayOnY;
+    uint8_t saved_qx = QX, saved_qy = QY;
+
+    current_mode = MODE_BENCH;
+    pins_stubbed = true;
+
+    Serial2.printf("# BENCH v1 iterations=%d report_len=%d seed=0x%08lX profiles=%d html=%d console=%s\n",
+                   BENCH_ITERATIONS, BENCH_REPORT_LEN, (unsigned long)BENCH_SEED, NUM_PROFILES,
+                   HAS_HTML_CONFIGURATOR, is_amiga ? "amiga" : "c64");
+    Serial2.println("# tag,cpu_mhz,stage,name,n,min_cycles,mean_cycles,max_cycles,mean_us");
+    bench_pass(bench_set_cpu(false));
+    bench_pass(bench_set_cpu(true));
+    Serial2.println("# END");
+
+    pins_stubbed = false;
+    use_html_configurator = saved_html;
+    delayOnX = saved_on_x;
+    delayOnY = saved_on_y;
+    QX = saved_qx;
+    QY = saved_qy;
+    current_mode = saved_mode;
+    set_joy_word(usb_route_word());
+    if (!pm_ok) setCpuFrequencyMhz(is_mouse_connected ? POWER_MAX_MHZ : POWER_MIN_MHZ);
+}
@@ -0,0 +1,164 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: ChordLayer.h
+// Description: On-pad command layer (hold Start + direction) and per-pad mapping banks
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "Globals.h"
+
+// ==========================================
+// 🗂️ PART 1: MAPPING BANKS (BUILT AT CONNECT TIME)
+// ==========================================
+// Every bank is a complete PadConfig, so the decoder never sees a difference: switching banks
+// only moves the slot's mapping pointer (UsbDevices.h). Banks, in chord order:
+//   the matched profile, the other profiles with the same VID:PID, Fire 1 <-> Fire 2 swapped,
+//   Fire 2 as UP (jump button for platform games). A pad with no Fire 2 gets no derived banks.
+
+inline int build_chord_banks(const PadConfig &base, PadConfig *bank) {
+    int n = 0;
+    bank[n++] = base;
+    for (int i = 0; i < NUM_PROFILES && n < CHORD_BANKS; i++) {
+        const PadConfig &p = PROFILES[i];
+        if (p.vid && p.vid == base.vid && p.pid == base.pid && p.name != base.name) bank[n++] = p;
+    }
+    if (base.byte_fire2 == 0) return n;
+
+    if (n < CHORD_BANKS) {
+        PadConfig &b = bank[n++];
+        b = base;
+        b.byte_fire1 = base.byte_fire2; b.val_fire1 = base.val_fire2; b.color_fire1 = base.color_fire2;
+        b.byte_fire2 = base.byte_fire1; b.val_fire2 = base.val_fire1; b.color_fire2 = base.color_fire1;
+    }
+    if (n < CHORD_BANKS) {
+        PadConfig &b = bank[n++];
+        b = base;
+        b.byte_up_alt = base.byte_fire2; b.val_up_alt = base.val_fire2; b.color_up_alt = base.color_fire2;
+        b.byte_fire2 = 0;
+    }
+    return n;
+}
+
+
+// ==========================================
+// 🎹 PART 2: CHORD DETECTION (PACKED WORD)
+// ==========================================
+// Runs on the debounced JS_* word of one pad, after process_joystick().
+// IDLE    -> HOLD     the modifier alone is pressed (it still reaches the port, e.g. CD32 Play)
+// HOLD    -> OPEN     held CHORD_ARM_MS with nothing else: from here the pad drives nothing
+// OPEN    -> RELEASE  a new press picks the command, or the modifier was let go / the window closed
+// RELEASE -> IDLE     every button released, so the command press never reaches the game
+// Any other button during HOLD is a normal combo and goes back to IDLE.
+// The deadlines are also ticked by the loop (chord_tick): a report-on-change pad sends nothing while
+// Start is held, and the relevance filter holds a streaming pad's unchanged reports back.
+
+inline ChordCmd chord_command(uint16_t pressed) {
+    if (pressed & JS_UP)    return CHORD_DO_BANK;
+    if (pressed & JS_DOWN)  return CHORD_DO_AUTOFIRE;
+    if (pressed & JS_LEFT)  return CHORD_DO_MOUSE;
+    if (pressed & JS_RIGHT) return CHORD_DO_OUTPUT;
+    if (pressed & JS_FIRE1) return CHORD_DO_DEFAULTS;
+    return CHORD_DO_NONE;
+}
+
+inline ChordCmd chord_step(ChordState &c, uint16_t &word, uint32_t now_ms) {
+#if CHORD_LAYER
+    const uint16_t mod = CHORD_MODIFIER;
+    uint16_t w = word;
+    bool mod_held = (w & mod) == mod;
+    ChordCmd cmd = CHORD_DO_NONE;
+
+    switch (c.phase) {
+        case CHORD_IDLE:
+            if (mod_held && !(w & ~mod)) { c.phase = CHORD_HOLD; c.t_ms = now_ms; }
+            break;
+        case CHORD_HOLD:
+            if (!mod_held) { c.phase = CHORD_IDLE; break; }
+            if (now_ms - c.t_ms < CHORD_ARM_MS) {
+                if (w & ~mod) c.phase = CHORD_IDLE;
+                break;
+            }
+            // Armed before this report: its press is already the command
+            c.phase = CHORD_OPEN;
+            c.t_ms = now_ms;
+            /* fall through */
+        case CHORD_OPEN:
+            if (!mod_held || now_ms - c.t_ms > CHORD_WINDOW_MS) { c.phase = CHORD_RELEASE; break; }
+            cmd = chord_command(w & ~c.prev & ~mod);
+            if (cmd != CHORD_DO_NONE) c.phase = CHORD_RELEASE;
+            break;
+        case CHORD_RELEASE:
+            if (!w) c.phase = CHORD_IDLE;
+            break;
+    }
+    c.prev = w;
+    if (c.phase == CHORD_OPEN || c.phase == CHORD_RELEASE) word = 0;
+    return cmd;
+#else
+    return CHORD_DO_NONE;
+#endif
+}
+
+// Loop, every pass: applies the deadlines between reports. True = the pad just went silent (OPEN)
+// or its window closed, so its routed word must be blanked now.
+inline bool chord_tick(ChordState &c, uint32_t now_ms) {
+#if CHORD_LAYER
+    if (c.phase == CHORD_HOLD && now_ms - c.t_ms >= CHORD_ARM_MS) {
+        c.phase = CHORD_OPEN;
+        c.t_ms = now_ms;
+        return true;
+    }
+    if (c.phase == CHORD_OPEN && now_ms - c.t_ms > CHORD_WINDOW_MS) {
+        c.phase = CHORD_RELEASE;
+        return true;
+    }
+#endif
+    return false;
+}
+
+
+// ==========================================
+// 💡 PART 3: LED CONFIRMATION
+// ==========================================
+// The LED blinks 'count' times in the command's color, then returns to the idle color.
+// update_hardware_and_leds() leaves the LED alone meanwhile.
+
+static uint32_t chord_led_color = 0;
+static uint8_t chord_led_count = 0;
+static uint32_t chord_led_t0 = 0;
+
+inline uint32_t chord_color(ChordCmd cmd) {
+    switch (cmd) {
+        case CHORD_DO_BANK:     return C_CYAN;
+        case CHORD_DO_AUTOFIRE: return C_YELLOW;
+        case CHORD_DO_MOUSE:    return C_BLUE;
+        case CHORD_DO_OUTPUT:   return C_PINK;
+        default:                return C_WHITE;
+    }
+}
+
+inline void chord_flash(ChordCmd cmd, uint8_t count) {
+    chord_led_color = chord_color(cmd);
+    chord_led_count = count ? count : 1;
+    chord_led_t0 = millis();
+}
+
+inline bool chord_led_busy() { return chord_led_count != 0; }
+
+// Loop task, every pass
+inline void chord_led_tick() {
+    if (!chord_led_count || pins_stubbed) return;
+    uint32_t step = (millis() - chord_led_t0) / CHORD_BLINK_MS;
+    static uint32_t last_step = 0xFFFFFFFF;
+    if (step == last_step) return;
+    last_step = step;
+    if (step >= 2u * chord_led_count) {
+        chord_led_count = 0;
+        last_step = 0xFFFFFFFF;
+        ws2812b.setPixelColor(0, is_amiga ? LED_IDLE_AMIGA : LED_IDLE_C64);
+    } else {
+        ws2812b.setPixelColor(0, (step & 1) ? LED_OFF : chord_led_color);
+    }
+    ws2812b.show();
+}
@@ -10,6 +10,9 @@
 #include "Hardware.h"
 #include "ServiceTools.h"
 #include "InputEngine.h"
+#include "KeyboardEngine.h"
+#include "UsbDevices.h"
+#include "Telemetry.h"
 
 // Link to the RTC memory state from the main file
 extern int active_driver; 
@@ -29,10 +32,50 @@ inline void check_polling_timer() {
     }
 }
 
+// CLI requests: the service task never touches pins, timers, interrupts or the status LED itself
+inline void apply_cli_requests() {
+    int8_t mode = output_mode_request;
+    if (mode >= 0) { set_output_mode((OutputMode)mode); output_mode_request = -1; }
+    int8_t console = console_mode_request;
+    if (console >= 0) { configure_console_mode(console == 1); console_mode_request = -1; }
+    int8_t color = led_color_request;
+    if (color >= 0) {
+        mix_r = COLOR_TEST_RGB[color][0]; mix_g = COLOR_TEST_RGB[color][1]; mix_b = COLOR_TEST_RGB[color][2];
+        ws2812b.setPixelColor(0, mix_r, mix_g, mix_b);
+        ws2812b.show();
+        led_color_request = -1;
+    }
+    int8_t bright = led_brightness_request;
+    if (bright >= 0) { ws2812b.setBrightness(bright); led_brightness_request = -1; }
+}
+
 // 2. USB Packet Routing and Processing
 inline void process_usb_packet(pkt_t &p) {
-    if (active_driver == 1) {
-        // --- NATIVE HID MOUSE MODE (STRICT BOOT PROTOCOL) ---
+    // Boot trace: the loop writes the pins right after this packet
+    if (!boot_first_report_us) {
+        boot_first_report_us = micros();
+        BOOT_MARK("first USB report -> DB9");
+    }
+
+    // Raw engine keyboards can still be inspected with 'sniff' / 'raw'
+    bool kbd_inspect = (active_driver == 0 && (current_mode == MODE_SNIFFER || current_mode == MODE_RAW));
+    if (p.src == PKT_SRC_KEYBOARD && !kbd_inspect) {
+        // --- KEYBOARD (either engine) ---
+        if (current_mode == MODE_DEBUG) {
+            Serial2.print("[KBD] Len: "); 
+            Serial2.print(p.len); 
+            Serial2.print(" -> Data: ");
+            for(int i = 0; i < p.len; i++) {
+                Serial2.printf("%02X ", p.data[i]);
+            }
+            Serial2.println();
+        }
+        if (active_driver == 1) process_keyboard(hid_kbd_state, KBD_LAYOUT_BOOT, p.data, p.len);
+        else process_keyboard(usb_slots[p.slot].state, usb_slots[p.slot].kbd, p.data, p.len);
+        set_joy_word(usb_route_word());
+    }
+    else if (p.src == PKT_SRC_MOUSE) {
+        // --- MOUSE MODE (STRICT BOOT PROTOCOL: hid_host engine or raw mouse behind a hub) ---
         if (current_mode == MODE_DEBUG) {
             Serial2.print("[HID BOOT] Len: "); 
             Serial2.print(p.len); 
@@ -53,8 +96,20 @@ inline void process_usb_packet(pkt_t &p) {
             last_mouse_action_time = millis();
         }
 
+        // Movement summed for the next telemetry frame
+        telem_mouse_dx += dx;
+        telem_mouse_dy += dy;
+
+        // 'mousetest' running on the service task: record absolute peaks
+        if (mouse_bench_active) {
+            if (abs(dx) > mouse_bench_max_dx) mouse_bench_max_dx = abs(dx);
+            if (abs(dy) > mouse_bench_max_dy) mouse_bench_max_dy = abs(dy);
+        }
+
         if (current_mode == MODE_PLAY || current_mode == MODE_DEBUG || current_mode == MODE_GPIO) {
-            process_mouse(btns, dx, dy);
+            bool shared = (route_mode == ROUTE_OR && usb_joystick_source());
+            process_mouse(btns, dx, dy, shared);
+            if (shared) set_joy_word(usb_route_word());
             
             if (current_mode == MODE_DEBUG && (dx != 0 || dy != 0 || btns != 0)) {
                 Serial2.printf("MOUSE ACTION: X:%3d | Y:%3d | BTN:%02x\n", dx, dy, btns);
@@ -72,21 +127,35 @@ inline void process_usb_packet(pkt_t &p) {
     } 
     else {
         // --- RAW JOYSTICK MODE ---
+        // Inspection tools only listen to the focused device (the last one plugged in)
+        bool inspect = (current_mode == MODE_SNIFFER || current_mode == MODE_AUTOPROFILE || current_mode == MODE_RAW || current_mode == MODE_POLLING);
+        if (inspect && p.slot != usb_focus_slot) return;
+
         if (current_mode == MODE_SNIFFER) {
             run_sniffer(connected_vid, connected_pid, p.data, p.len);
         }
+        else if (current_mode == MODE_AUTOPROFILE) {
+            run_autoprofiler(p.data, p.len);
+        }
         else if (current_mode == MODE_RAW) {
             run_raw_sniffer(p.data, p.len); 
         }
         else { 
-            process_joystick(p.data, p.len); 
+            UsbSlot &s = usb_slots[p.slot];
+            process_joystick(*s.map, s.state, p.data, p.len); 
+            ChordCmd chord = chord_step(s.state.chord, s.state.word, millis());
+            if (chord != CHORD_DO_NONE) usb_apply_chord(p.slot, chord);
+            set_joy_word(usb_route_word());
         }
     }
 }
 
 // 3. Hardware Diagnostics
+// Redraws are rate-limited: at 115200 baud a full screen takes ~100 ms (use 'telemetry' for live data)
 inline void run_gpio_diagnostics() {
-    if (current_mode == MODE_GPIO) {
+    static unsigned long last_draw_ms = 0;
+    bool forced = gpio_redraw_request; // 'gp<n>' prints its probe below a fresh table
+    if (current_mode == MODE_GPIO && (forced || millis() - last_draw_ms >= GPIO_DASH_MS)) {
         uint16_t current_gpio_state = 0;
         current_gpio_state |= (digitalRead(GP_UP) << 0);
         current_gpio_state |= (digitalRead(GP_DOWN) << 1);
@@ -97,8 +166,9 @@ inline void run_gpio_diagnostics() {
         current_gpio_state |= (digitalRead(GP_POTY) << 6); 
         if (!is_amiga) current_gpio_state |= (digitalRead(GP_C64_SIG_MODE_SW) << 7);
 
-        if (current_gpio_state != last_gpio_state) {
+        if (current_gpio_state != last_gpio_state || forced) {
             last_gpio_state = current_gpio_state;
+            last_draw_ms = millis();
             
             Serial2.print("\x1b[2J\x1b[H");
             Serial2.println("\n==========================================");
@@ -108,53 +178,74 @@ inline void run_gpio_diagnostics() {
             Serial2.printf(" MODE   : %s\n", is_amiga ? "AMIGA" : "COMMODORE 64");
             Serial2.printf(" STATUS : %s\n", device_connected ? current_profile.name : "WAITING...");
             Serial2.println("------------------------------------------");
-            Serial2.printf(" UP        |  %02d  |   %s    | %s\n", GP_UP, digitalRead(GP_UP) ? "HIGH" : "LOW ", get_pin_status(GP_UP, true).c_str());
-            Serial2.printf(" DOWN      |  %02d  |   %s    | %s\n", GP_DOWN, digitalRead(GP_DOWN) ? "HIGH" : "LOW ", get_pin_status(GP_DOWN, true).c_str());
-            Serial2.printf(" LEFT      |  %02d  |   %s    | %s\n", GP_LEFT, digitalRead(GP_LEFT) ? "HIGH" : "LOW ", get_pin_status(GP_LEFT, true).c_str());
-            Serial2.printf(" RIGHT     |  %02d  |   %s    | %s\n", GP_RIGHT, digitalRead(GP_RIGHT) ? "HIGH" : "LOW ", get_pin_status(GP_RIGHT, true).c_str());
-            Serial2.printf(" FIRE 1    |  %02d  |   %s    | %s\n", GP_FIRE1, digitalRead(GP_FIRE1) ? "HIGH" : "LOW ", get_pin_status(GP_FIRE1, true).c_str());
-            Serial2.printf(" FIRE 2    |  %02d  |   %s    | %s\n", GP_FIRE2, digitalRead(GP_FIRE2) ? "HIGH" : "LOW ", get_pin_status(GP_FIRE2, true).c_str());
-            Serial2.printf(" FIRE 3    |  %02d  |   %s    | %s\n", GP_POTY, digitalRead(GP_POTY) ? "HIGH" : "LOW ", get_pin_status(GP_POTY, is_amiga).c_str());
+            Serial2.printf(" UP        |  %02d  |   %s    | %s\n", GP_UP, digitalRead(GP_UP) ? "HIGH" : "LOW ", get_pin_status(GP_UP, true));
+            Serial2.printf(" DOWN      |  %02d  |   %s    | %s\n", GP_DOWN, digitalRead(GP_DOWN) ? "HIGH" : "LOW ", get_pin_status(GP_DOWN, true));
+            Serial2.printf(" LEFT      |  %02d  |   %s    | %s\n", GP_LEFT, digitalRead(GP_LEFT) ? "HIGH" : "LOW ", get_pin_status(GP_LEFT, true));
+            Serial2.printf(" RIGHT     |  %02d  |   %s    | %s\n", GP_RIGHT, digitalRead(GP_RIGHT) ? "HIGH" : "LOW ", get_pin_status(GP_RIGHT, true));
+            Serial2.printf(" FIRE 1    |  %02d  |   %s    | %s\n", GP_FIRE1, digitalRead(GP_FIRE1) ? "HIGH" : "LOW ", get_pin_status(GP_FIRE1, true));
+            Serial2.printf(" FIRE 2    |  %02d  |   %s    | %s\n", GP_FIRE2, digitalRead(GP_FIRE2) ? "HIGH" : "LOW ", get_pin_status(GP_FIRE2, true));
+            Serial2.printf(" FIRE 3    |  %02d  |   %s    | %s\n", GP_POTY, digitalRead(GP_POTY) ? "HIGH" : "LOW ", get_pin_status(GP_POTY, is_amiga));
             
             if (!is_amiga) {
-                Serial2.printf(" C64_SIG   |  %02d  |   %s    | %s\n", GP_C64_SIG_MODE_SW, digitalRead(GP_C64_SIG_MODE_SW) ? "HIGH" : "LOW ", get_pin_status(GP_C64_SIG_MODE_SW, false).c_str());
+                Serial2.printf(" C64_SIG   |  %02d  |   %s    | %s\n", GP_C64_SIG_MODE_SW, digitalRead(GP_C64_SIG_MODE_SW) ? "HIGH" : "LOW ", get_pin_status(GP_C64_SIG_MODE_SW, false));
             }
             Serial2.println("------------------------------------------");
             Serial2.println(">> Type 'exit' to return to normal operation <<\n");
         }
     }
+    if (forced) gpio_redraw_request = false;
 }
 
 // 4. Update Pin Output and LEDs
 inline void update_hardware_and_leds() {
-    static bool last_mouse_state = false;
-    static bool first_run_clock = true;
-    
-    if (is_mouse_connected != last_mouse_state || first_run_clock) {
-        if (is_mouse_connected) {
-            setCpuFrequencyMhz(240); 
-        } else {
-            setCpuFrequencyMhz(80); 
-        }
-        last_mouse_state = is_mouse_connected;
-        first_run_clock = false;
-    }
+    // CPU clock is handled by the power governor (PowerGovernor.h)
+    chord_led_tick(); // A chord confirmation owns the LED while it blinks
+    usb_chord_tick(millis());
+    usb_debounce_tick(millis());
 
-    if (device_connected && !is_mouse_connected) {
+    // Pads and keyboards drive the joystick lines, even next to a mouse (hub / combo dongle).
+    // In priority routing a moving mouse keeps the port for itself, in stick-mouse mode run_stick_mouse() does.
+    bool mouse_owns_port = (route_mode == ROUTE_PRIORITY && is_mouse_connected && (millis() - last_mouse_action_time < 100))
+                        || active_output_mode == OUT_MOUSE;
+    // Handing the port back: the mouse wrote its own buttons meanwhile, so re-drive every line
+    static bool mouse_had_port = false;
+    bool resync = mouse_had_port && !mouse_owns_port;
+    mouse_had_port = mouse_owns_port;
+    if (((device_connected && usb_joystick_source()) || pins_stubbed) && !mouse_owns_port) {
         bool final_up = joy_u || joy_up_alt;
         bool out_fire = joy_f1;
         
         static bool toggle = false;
         static unsigned long last_ms = 0;
         if (joy_auto) {
-            if (millis() - last_ms > 70) { toggle = !toggle; last_ms = millis(); }
+            if (millis() - last_ms > AUTOFIRE_HALF_MS[autofire_preset]) { toggle = !toggle; last_ms = millis(); }
             out_fire = out_fire || toggle;
         }
         
+        // Per-line output (paddle mode re-routes the fire buttons)
+        bool out_up = final_up, out_down = joy_d, out_left = joy_l, out_right = joy_r;
+        bool out_f2 = joy_f2, out_f3 = joy_f3;
+        if (active_output_mode == OUT_PADDLE && !is_amiga) {
+            // C64 paddle fire buttons live on the joystick LEFT/RIGHT lines, POT lines belong to the timers
+            out_left = out_fire; out_right = joy_f2;
+            out_up = false; out_down = false; out_fire = false; out_f2 = false; out_f3 = false;
+        }
+
+        // CD32 pad: Red/Blue/extras go through the shift register word, pins 5/6/9 belong to the ISRs
+        bool cd32_on = (active_output_mode == OUT_CD32 && is_amiga);
+        if (cd32_on) {
+            static uint32_t last_cd32_word = CD32_IDLE_WORD;
+            uint32_t word = cd32_pack(out_fire, joy_f2, joy_ext);
+            if (word != last_cd32_word && (current_mode == MODE_PLAY || current_mode == MODE_GPIO)) {
+                cd32_publish(word);
+                last_cd32_word = word;
+            }
+        }
+
         static bool last_up = false, last_down = false, last_left = false, last_right = false;
         static bool last_fire = false, last_f2 = false, last_f3 = false;
 
-        if (final_up != last_up || joy_d != last_down || joy_l != last_left || joy_r != last_right || out_fire != last_fire || joy_f2 != last_f2 || joy_f3 != last_f3) {
+        if (resync || out_up != last_up || out_down != last_down || out_left != last_left || out_right != last_right || out_fire != last_fire || out_f2 != last_f2 || out_f3 != last_f3) {
             
             if (current_mode == MODE_DEBUG) {
                 Serial2.print("ACTION: ");
@@ -167,10 +258,12 @@ inline void update_hardware_and_leds() {
                 Serial2.println();
             } 
             else if (current_mode == MODE_PLAY || current_mode == MODE_GPIO) {
-                set_joy_pin(GP_UP, final_up); set_joy_pin(GP_DOWN, joy_d);
-                set_joy_pin(GP_LEFT, joy_l); set_joy_pin(GP_RIGHT, joy_r);
-                set_joy_pin(GP_FIRE1, out_fire); set_joy_pin(GP_FIRE2, joy_f2);
-                set_fire3_pin(joy_f3);
+                set_joy_pin(GP_UP, out_up); set_joy_pin(GP_DOWN, out_down);
+                set_joy_pin(GP_LEFT, out_left); set_joy_pin(GP_RIGHT, out_right);
+                if (!cd32_on) {
+                    set_joy_pin(GP_FIRE1, out_fire); set_joy_pin(GP_FIRE2, out_f2);
+                    set_fire3_pin(out_f3);
+                }
             }
 
             uint32_t led_color = LED_OFF;
@@ -191,34 +284,58 @@ inline void update_hardware_and_leds() {
             }
 
             static uint32_t last_led_color = 0xFFFFFFFF;
-            if (led_color != last_led_color) {
+            if (led_color != last_led_color && !pins_stubbed && !chord_led_busy()) {
                 ws2812b.setPixelColor(0, led_color); ws2812b.show(); 
                 last_led_color = led_color;
             }
 
-            last_up = final_up; last_down = joy_d; last_left = joy_l; last_right = joy_r;
-            last_fire = out_fire; last_f2 = joy_f2; last_f3 = joy_f3;
+            if (!pins_stubbed) { // A benchmark must not leave its states as the "current" pins
+                last_up = out_up; last_down = out_down; last_left = out_left; last_right = out_right;
+                last_fire = out_fire; last_f2 = out_f2; last_f3 = out_f3;
+            }
         }
     } 
     else { 
         uint32_t idle_color = is_amiga ? LED_IDLE_AMIGA : LED_IDLE_C64;
-        if (is_mouse_connected && (millis() - last_mouse_action_time < 100)) {
+        if ((is_mouse_connected || active_output_mode == OUT_MOUSE) && (millis() - last_mouse_action_time < 100)) {
             idle_color = LED_JOY_MOUSE; 
         }
         static uint32_t last_idle_color = 0xFFFFFFFF;
-        if (idle_color != last_idle_color) {
+        if (idle_color != last_idle_color && !pins_stubbed && !chord_led_busy()) {
             ws2812b.setPixelColor(0, idle_color); ws2812b.show();
             last_idle_color = idle_color;
         }
     }
 }
 
-// 5. Hardware Switch Safety Watchdog (WITH STABILITY SAMPLING & MOUSE PROTECTION)
+// 5. Analog Stick as Mouse (OUT_MOUSE)
+// Whole counts from the fixed-rate integrator (StickMouse.h) go through the same engines as a USB
+// mouse, so the live mouse speed applies. Fire 1/2/3 of the routed pads are the three buttons.
+inline void run_stick_mouse() {
+    if (active_output_mode != OUT_MOUSE) return;
+    int8_t dx, dy;
+    bool moved = stick_mouse_take(dx, dy);
+    uint8_t btns = (joy_f1 ? 0x01 : 0) | (joy_f2 ? 0x02 : 0) | (joy_f3 ? 0x04 : 0);
+    static uint8_t last_btns = 0;
+    if (!moved && btns == last_btns) return;
+    last_btns = btns;
+    last_mouse_action_time = millis();
+
+    telem_mouse_dx += dx;
+    telem_mouse_dy += dy;
+
+    if (current_mode == MODE_PLAY || current_mode == MODE_DEBUG || current_mode == MODE_GPIO) {
+        process_mouse(btns, dx, dy);
+        if (current_mode == MODE_DEBUG) Serial2.printf("STICK MOUSE: X:%3d | Y:%3d | BTN:%02x\n", dx, dy, btns);
+    }
+}
+
+// 6. Hardware Switch Safety Watchdog (WITH STABILITY SAMPLING & MOUSE PROTECTION)
 inline void check_switch_mismatch() {
     if (!ENABLE_SWITCH_WATCHDOG) return;
 
-    // Run only if on C64, Fire 2 is NOT pressed, AND NO MOUSE is connected!
-    if (!is_amiga && !joy_f2 && !is_mouse_connected && current_mode == MODE_PLAY) { 
+    // Run only if on C64, Fire 2 is NOT pressed, AND NO MOUSE/PADDLE owns the POT lines!
+    if (!is_amiga && !joy_f2 && !pot_lines_analog() && current_mode == MODE_PLAY) { 
         static unsigned long last_probe_time = 0;
         
         if (millis() - last_probe_time > 2000) { 
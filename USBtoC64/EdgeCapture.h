@@ -0,0 +1,225 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: EdgeCapture.h
+// Description: DB9 output edge capture and report-to-edge latency ('edges')
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "soc/gpio_struct.h"
+#include "Globals.h"
+
+inline bool pot_lines_analog(); // Hardware.h
+
+// ==========================================
+// 📍 PART 1: EDGE RING (ISR SIDE)
+// ==========================================
+// Every DB9 output pin gets a CHANGE interrupt on its own input path: the edge is stamped when
+// the line really moved (pull-up rise included), not when set_joy_pin() wrote it. The loop notes
+// each report before routing it, so every edge carries the report it was written after.
+// Line ids and names match tools/pinsim.h, so 'edges dump' replays in tools/pin_sim.
+
+enum EdgeLine : uint8_t {
+    EDGE_UP, EDGE_DOWN, EDGE_LEFT, EDGE_RIGHT, EDGE_FIRE1, EDGE_FIRE2, EDGE_POTY,
+    EDGE_POTX_DRV, EDGE_POTY_DRV, EDGE_SYNC, EDGE_LINES
+};
+
+static const char *const EDGE_LINE_NAMES[EDGE_LINES] = {
+    "UP", "DOWN", "LEFT", "RIGHT", "FIRE1", "FIRE2", "POTY", "POTX_DRV", "POTY_DRV", "SYNC"
+};
+
+struct EdgeRec {
+    uint32_t t_us;       // Line changed (esp_timer, same clock as pkt_t::t_us)
+    uint32_t rep_t_us;   // Arrival of the last report routed before it
+    uint16_t rep_id;     // Its sequence number (0 = none yet)
+    uint8_t line;
+    uint8_t level;
+};
+
+static EdgeRec edge_ring[EDGE_CAPTURE_LEN];
+static volatile uint16_t edge_count = 0;
+static volatile bool edge_capture_on = false;
+static volatile bool edge_capture_sid = false;  // SID timing lines too ('edges sid')
+static volatile uint16_t edge_rep_id = 0;
+static volatile uint32_t edge_rep_t_us = 0;
+static uint32_t edge_start_us = 0;
+static portMUX_TYPE edge_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Loop task, once per report before it is routed
+inline void edge_note_report(uint32_t arrival_us) {
+    if (!edge_capture_on) return;
+    edge_rep_t_us = arrival_us;
+    edge_rep_id = (uint16_t)(edge_rep_id + 1) ? (uint16_t)(edge_rep_id + 1) : 1;
+}
+
+inline void IRAM_ATTR edge_record(uint8_t line, uint8_t level) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&edge_mux);
+    if (edge_count < EDGE_CAPTURE_LEN) {
+        edge_ring[edge_count] = { now, edge_rep_t_us, edge_rep_id, line, level };
+        edge_count = edge_count + 1;
+    }
+    portEXIT_CRITICAL_ISR(&edge_mux);
+}
+
+static uint8_t edge_pin_of[EDGE_LINES];
+
+void IRAM_ATTR edgePinISR(void *arg) {
+    uint8_t line = (uint8_t)(uintptr_t)arg;
+    edge_record(line, (GPIO.in >> edge_pin_of[line]) & 1);
+}
+
+
+// ==========================================
+// 🔌 PART 2: ARMING THE PINS
+// ==========================================
+// Pins that already own an interrupt keep it: the CD32 shift register (FIRE1 clock, POTY mode)
+// and the SID sync on GP1, which handleInterrupt() reports itself. Lines the SID charges and
+// discharges every 512 cycles (C64 POT X/Y with a mouse or paddles) would flood the ring, so the
+// transistor drives are captured instead. Even those and the sync fire ~10k times a second and
+// would fill the ring in 0.1 s, so they only join a capture on request ('edges sid', for
+// tools/pin_sim), never the latency measurement.
+
+static uint8_t edge_armed[EDGE_LINES];
+static int edge_num_armed = 0;
+
+inline void edge_arm(uint8_t line, uint8_t pin) {
+    edge_pin_of[line] = pin;
+    attachInterruptArg(digitalPinToInterrupt(pin), edgePinISR, (void *)(uintptr_t)line, CHANGE);
+    edge_armed[edge_num_armed++] = line;
+}
+
+inline void edge_start(bool sid) {
+    bool cd32_on = (active_output_mode == OUT_CD32 && is_amiga);
+    bool pots_analog = !is_amiga && pot_lines_analog();
+    edge_count = 0;
+    edge_rep_id = 0;
+    edge_rep_t_us = 0;
+    edge_num_armed = 0;
+
+    edge_arm(EDGE_UP, GP_UP);
+    edge_arm(EDGE_DOWN, GP_DOWN);
+    edge_arm(EDGE_LEFT, GP_LEFT);
+    edge_arm(EDGE_RIGHT, GP_RIGHT);
+    if (!cd32_on) edge_arm(EDGE_FIRE1, GP_FIRE1);
+    if (pots_analog) {
+        if (sid) edge_arm(EDGE_POTX_DRV, GP_C64_SIG_MODE_SW);
+        if (sid) edge_arm(EDGE_POTY_DRV, GP_POTY_GND);
+    } else {
+        if (!cd32_on) edge_arm(EDGE_FIRE2, GP_FIRE2);
+        if (!cd32_on) edge_arm(EDGE_POTY, GP_POTY);
+    }
+    edge_start_us = (uint32_t)esp_timer_get_time();
+    edge_capture_sid = sid && !is_amiga;
+    edge_capture_on = true;
+}
+
+inline void edge_stop() {
+    edge_capture_on = false;
+    edge_capture_sid = false;
+    for (int i = 0; i < edge_num_armed; i++) detachInterrupt(digitalPinToInterrupt(edge_pin_of[edge_armed[i]]));
+}
+
+
+// ==========================================
+// 📊 PART 3: 'edges' REPORT (SERVICE TASK)
+// ==========================================
+// An edge joins its report when it follows it by less than EDGE_JOIN_MAX_US and is the first
+// edge after that report on its line: later ones (autofire, Amiga quadrature bursts, POT timers)
+// were written by a clock, not by the report.
+
+static uint32_t edge_lat[EDGE_CAPTURE_LEN];
+
+inline void run_edges_report() {
+    uint16_t n = edge_count;
+    uint16_t last_rep[EDGE_LINES] = { 0 };
+    uint16_t per_line[EDGE_LINES] = { 0 };
+    int joined = 0, unjoined = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        const EdgeRec &e = edge_ring[i];
+        per_line[e.line]++;
+        uint32_t dt = e.t_us - e.rep_t_us;
+        if (e.rep_id && e.line < EDGE_POTX_DRV && e.rep_id != last_rep[e.line] && dt < EDGE_JOIN_MAX_US) {
+            edge_lat[joined++] = dt;
+            last_rep[e.line] = e.rep_id;
+        } else {
+            unjoined++;
+        }
+    }
+    // Insertion sort: EDGE_CAPTURE_LEN samples at most, once per capture
+    for (int i = 1; i < joined; i++) {
+        uint32_t v = edge_lat[i];
+        int j = i - 1;
+        while (j >= 0 && edge_lat[j] > v) { edge_lat[j + 1] = edge_lat[j]; j--; }
+        edge_lat[j + 1] = v;
+    }
+
+    Serial2.println("\n==========================================");
+    Serial2.println("   USB REPORT -> DB9 EDGE LATENCY");
+    Serial2.println("==========================================");
+    Serial2.printf(" Edges     : %u captured%s, %u reports seen\n", n, n >= EDGE_CAPTURE_LEN ? " (ring full)" : "", edge_rep_id);
+    Serial2.print(" Per line  :");
+    for (int l = 0; l < EDGE_LINES; l++) if (per_line[l]) Serial2.printf(" %s %u", EDGE_LINE_NAMES[l], per_line[l]);
+    Serial2.println();
+    Serial2.printf(" Joined    : %d edges (%d timer-driven or stale)\n", joined, unjoined);
+    if (joined) {
+        uint64_t sum = 0;
+        for (int i = 0; i < joined; i++) sum += edge_lat[i];
+        Serial2.println("------------------------------------------");
+        Serial2.printf(" min %lu  p50 %lu  p90 %lu  p99 %lu  max %lu  mean %lu us\n",
+                       (unsigned long)edge_lat[0], (unsigned long)edge_lat[joined / 2],
+                       (unsigned long)edge_lat[(joined * 9) / 10], (unsigned long)edge_lat[(joined * 99) / 100],
+                       (unsigned long)edge_lat[joined - 1], (unsigned long)(sum / joined));
+        // Histogram, 250 us bins, the last one open
+        static const uint32_t BIN_US = 250;
+        int bins[9] = { 0 };
+        for (int i = 0; i < joined; i++) {
+            uint32_t b = edge_lat[i] / BIN_US;
+            bins[b > 8 ? 8 : b]++;
+        }
+        for (int b = 0; b < 9; b++) {
+            if (b < 8) Serial2.printf(" %4lu-%4lu us %5d ", (unsigned long)(b * BIN_US), (unsigned long)((b + 1) * BIN_US), bins[b]);
+            else       Serial2.printf("   >= %4lu us %5d ", (unsigned long)(b * BIN_US), bins[b]);
+            int bar = joined ? (bins[b] * 30 + joined - 1) / joined : 0;
+            for (int k = 0; k < bar; k++) Serial2.print('#');
+            Serial2.println();
+        }
+    }
+    Serial2.println("==========================================");
+    Serial2.println(" 'edges sid 1' + 'edges dump' record a trace for tools/pin_sim\n");
+}
+
+// Edge list in the tools/pinsim.h text format: '<time us> <LINE> <0|1>'
+inline void run_edges_dump() {
+    uint16_t n = edge_count;
+    Serial2.printf("# video %s\n", PAL ? "PAL" : "NTSC");
+    Serial2.printf("# console %s\n", is_amiga ? "AMIGA" : "C64");
+    Serial2.println("# t_us line level [report_id report_arrival_us]");
+    for (uint16_t i = 0; i < n; i++) {
+        const EdgeRec &e = edge_ring[i];
+        uint32_t t = e.t_us - edge_start_us;
+        if (!t) t = 1; // Time 0 means "idle level" to pin_sim
+        if (e.rep_id) {
+            Serial2.printf("%lu %s %u # %u %ld\n", (unsigned long)t, EDGE_LINE_NAMES[e.line], e.level, e.rep_id,
+                           (long)(e.rep_t_us - edge_start_us));
+        } else {
+            Serial2.printf("%lu %s %u\n", (unsigned long)t, EDGE_LINE_NAMES[e.line], e.level);
+        }
+    }
+    Serial2.println("# END");
+}
+
+// Captures for 'seconds' (or until a key / a full ring) while the loop keeps playing
+inline void run_edges(uint32_t seconds, bool sid) {
+    Serial2.printf("\n>>> 📍 EDGE CAPTURE%s: play for %lu s (any key stops)...\n", sid ? " + SID TIMING" : "", (unsigned long)seconds);
+    while (Serial2.available() > 0) Serial2.read();
+    edge_start(sid);
+    uint32_t t0 = millis();
+    while (millis() - t0 < seconds * 1000UL && edge_count < EDGE_CAPTURE_LEN && Serial2.available() == 0) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    edge_stop();
+    while (Serial2.available() > 0) Serial2.read();
+    run_edges_report();
+}
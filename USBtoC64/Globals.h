@@ -69,40 +69,259 @@ Adafruit_NeoPixel ws2812b(1, PIN_WS2812B, NEO_GRB + NEO_KHZ800);    //play board
 // false = Disables the hardware switch mismatch watchdog entirely
 #define ENABLE_SWITCH_WATCHDOG true
 
+// ⏱️ --- FAST BOOT --- ⏱️
+// true  = no fixed delays: USB enumeration overlaps the DB9 setup, waits are condition based
+// false = original boot sequence (1 s console delay, 300 ms USB line toggle, 600 ms settle)
+#define FAST_BOOT true
+#define BOOT_TARGET_MS       200  // Power-on -> first USB report on the DB9 pins (checked by 'boot')
+#define USB_LINE_RESET_MS    20   // D+/D- held LOW after a soft reset (USB reset needs >= 10 ms)
+#define USB_LINE_WAIT_MS     100  // Max wait for the device pull-up to come back
+#define SWITCH_STABLE_MS     5    // C64/Amiga switch must read the same for this long
+#define SWITCH_SETTLE_MAX_MS 600  // ...but never wait longer than the old fixed delay
+
+// Boot trace: micros() timestamps of each setup stage, printed by 'boot'
+#define BOOT_TRACE_MAX 24
+struct BootMark { const char *label; uint32_t t_us; };
+static BootMark boot_trace[BOOT_TRACE_MAX];
+static uint8_t boot_trace_len = 0;
+static uint32_t boot_first_report_us = 0;
+
+#define BOOT_MARK(lbl) do { \
+    if (boot_trace_len < BOOT_TRACE_MAX) { \
+        boot_trace[boot_trace_len].label = (lbl); \
+        boot_trace[boot_trace_len].t_us = micros(); \
+        boot_trace_len++; \
+    } \
+} while (0)
+
 // 🖥️ --- USB HOST VARIABLES --- 🖥️
 static usb_host_client_handle_t s_client = nullptr;
-static usb_device_handle_t      s_dev    = nullptr;
-static usb_transfer_t* s_in_xfer = nullptr;
-static uint8_t s_in_ep = 0, s_if_num = 0;
-static uint16_t s_in_mps = 0;
-static volatile uint8_t s_new_dev_addr = 0;
+
+// 🔌 --- MULTI-DEVICE POOL (USB HUB) --- 🔌
+// Devices live in a fixed pool (UsbDevices.h): plugging one in allocates nothing
+#define USB_MAX_DEVICES  4   // Pads / keyboards / mice served at the same time
+
+// Report buffering. The packet queue is shared by every device and the attach / detach events, so
+// it never drops below PKT_QUEUE_MIN_LEN (a 1 kHz pad over PKT_QUEUE_STALL_MS, twice the mean rate
+// for bursts). A pad the configurator measured (JM_POLL_* in JoystickMapping.h) can only grow it, and
+// sets its own transfer ring.
+#define PKT_QUEUE_STALL_MS  8
+#define PKT_QUEUE_MIN_LEN   16
+#if defined(JM_POLL_MEASURED) && JM_POLL_MEASURED && JM_POLL_MEAN_US > 0
+  #define PKT_QUEUE_RAW_LEN  (2 * PKT_QUEUE_STALL_MS * 1000 / JM_POLL_MEAN_US + 1)
+  #define PKT_QUEUE_LEN      (PKT_QUEUE_RAW_LEN < PKT_QUEUE_MIN_LEN ? PKT_QUEUE_MIN_LEN : PKT_QUEUE_RAW_LEN > 64 ? 64 : PKT_QUEUE_RAW_LEN)
+  #define USB_XFER_RING      (JM_POLL_MEAN_US < 2000 ? 3 : 2) // A third transfer in flight for >= 500 Hz pads
+#else
+  #define PKT_QUEUE_LEN      PKT_QUEUE_MIN_LEN
+  #define USB_XFER_RING      2   // IN transfers kept in flight per device
+#endif
+
+// How the devices share the single DB9 port
+// ROUTE_OR       = co-pilot: every device drives the port, buttons are OR-ed
+// ROUTE_PRIORITY = the first active device (plug order) owns the port, a moving mouse beats the joysticks
+enum RouteMode { ROUTE_OR, ROUTE_PRIORITY };
+RouteMode route_mode = ROUTE_OR;
+
+// 🔀 --- REPORT-ID MULTIPLEXER (multitaps / arcade encoders, .use_report_id) --- 🔀
+// Each report ID gets its own slot (first come, first served) holding a packed JS_* word
+#define MUX_SLOTS     8
+#define MUX_STALE_MS  0     // Release a port silent for this long (0 = never: report-on-change pads
+                            // send nothing while a button is held; ports are released on detach)
+
+// How the ports of one multiplexed device are merged
+// MUX_OR       = every port drives the DB9 (co-pilot)
+// MUX_PRIORITY = the active port with the lowest report ID owns the DB9
+// MUX_SELECT   = only the port that last pressed START (Play) drives the DB9
+enum MuxMode { MUX_OR, MUX_PRIORITY, MUX_SELECT };
+MuxMode mux_mode = MUX_OR;
+
+struct MuxState {
+    uint8_t  id[MUX_SLOTS];       // Report ID owning the slot (0 = free)
+    uint16_t word[MUX_SLOTS];     // Packed JS_* bits of that port
+    uint32_t last_ms[MUX_SLOTS];  // millis() of the last report from that port
+    uint8_t  selected;            // MUX_SELECT: slot that owns the DB9
+};
+
+// 🧹 --- GLITCH FILTER (debounce of the packed JS_* word) --- 🧹
+// A change must be seen on N consecutive reports before it reaches the pins (1 = immediate, max 7).
+// Counted in report intervals, so the delay is N x the pad's polling interval. A pad that only reports
+// on change goes silent after it, so the loop counts one for every interval it stays silent.
+// DEB_OFF  = reports go straight to the pins (zero lag)
+// DEB_FAST = presses pass at once, only release blips are filtered (e.g. a one-report hat 'centre')
+// DEB_FULL = presses use their threshold too (filters phantom fire blips)
+enum DebounceMode { DEB_OFF, DEB_FAST, DEB_FULL };
+DebounceMode debounce_mode = DEB_OFF;
+
+//                                     UP DN LT RT F1 F2 F3 UA AF GR YE RW FW PL
+const uint8_t DEBOUNCE_PRESS[14]   = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 };
+const uint8_t DEBOUNCE_RELEASE[14] = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 };
+
+struct DebounceState {
+    uint16_t c0, c1, c2;   // Vertical 3-bit counters: bit i of cK = bit K of button i's count
+    uint16_t state;        // Filtered word
+    uint16_t raw;          // Last unfiltered word (the loop counts it again while the pad is silent)
+    uint32_t t_ms;         // Last count
+    uint32_t glitches;     // Changes that vanished before reaching their threshold
+};
+
+// 🎹 --- CHORD LAYER (ChordLayer.h) --- 🎹
+// Hold CHORD_MODIFIER alone for CHORD_ARM_MS: the pad stops driving the port and the next press picks
+// a command. UP = next mapping bank, DOWN = autofire rate, LEFT = mouse speed, RIGHT = output mode,
+// FIRE 1 = back to the defaults. The LED blinks the new setting (1 blink = first bank / preset).
+#define CHORD_LAYER      1             // 0 = Start is always passed to the port
+#define CHORD_MODIFIER   (JS_START)    // Any JS_* combo, e.g. (JS_START | JS_SHOULDER_L)
+#define CHORD_ARM_MS     400           // Shorter holds are normal presses
+#define CHORD_WINDOW_MS  2000          // The layer closes if no command follows
+#define CHORD_BANKS      4             // Mapping banks per pad, built at connect time
+#define CHORD_BLINK_MS   150
+
+enum ChordPhase : uint8_t { CHORD_IDLE, CHORD_HOLD, CHORD_OPEN, CHORD_RELEASE };
+enum ChordCmd : uint8_t { CHORD_DO_NONE, CHORD_DO_BANK, CHORD_DO_AUTOFIRE, CHORD_DO_MOUSE, CHORD_DO_OUTPUT, CHORD_DO_DEFAULTS };
+
+struct ChordState {
+    uint8_t phase;
+    uint16_t prev;         // Word of the previous report (command = new press)
+    uint32_t t_ms;         // Phase start
+};
+
+// Autofire half periods (toggle every N ms): ~7, 10, 15 and 5 Hz. The chord cycles them.
+const uint16_t AUTOFIRE_HALF_MS[] = { 70, 50, 33, 100 };
+#define AUTOFIRE_PRESETS (sizeof(AUTOFIRE_HALF_MS) / sizeof(AUTOFIRE_HALF_MS[0]))
+uint8_t autofire_preset = 0;
+
+// Per-device decode state (one per pool slot)
+struct DevState {
+    uint16_t word;         // Packed JS_* bits of the last decoded report
+    MuxState mux;          // Report-ID multiport pads
+    bool autofire_latch;
+    DebounceState deb;     // Glitch filter
+    uint8_t stick_dir[2];  // Last 8-way direction of each analog stick (hysteresis)
+    ChordState chord;      // On-pad command layer
+};
 
 // 🕹️ --- SYSTEM MODES & STATES --- 🕹️
-enum SystemMode { MODE_PLAY, MODE_SERVICE, MODE_SNIFFER, MODE_RAW, MODE_DEBUG, MODE_GPIO, MODE_POLLING, MODE_COLOR_MIXER };
+enum SystemMode { MODE_PLAY, MODE_SERVICE, MODE_SNIFFER, MODE_RAW, MODE_DEBUG, MODE_GPIO, MODE_POLLING, MODE_COLOR_MIXER, MODE_AUTOPROFILE, MODE_INJECT, MODE_BENCH };
 SystemMode current_mode = MODE_PLAY;
 
-enum CmdState { CMD_IDLE, CMD_WAIT_IMPORT, CMD_WAIT_NAME_IMPORT, CMD_WAIT_NAME_MANUAL, CMD_WAIT_COLOR_CHOICE };
+enum CmdState { CMD_IDLE, CMD_WAIT_IMPORT, CMD_WAIT_NAME_IMPORT, CMD_WAIT_NAME_MANUAL, CMD_WAIT_COLOR_CHOICE, CMD_WAIT_NAME_AUTO };
 CmdState cmd_state = CMD_IDLE;
 
-String sniff_profile_name = "NEW_PAD"; 
+char sniff_profile_name[32] = "NEW_PAD";
 
 uint16_t last_gpio_state = 0xFFFF; 
 bool is_amiga = false;
 PadConfig current_profile; 
 bool device_connected = false;
 bool is_mouse_connected = false; 
+bool is_keyboard_connected = false;
 bool use_html_configurator = false; 
+OutputMode active_output_mode = OUT_JOYSTICK; 
 bool ground_stabilized = false;
 
 uint16_t connected_vid = 0;
 uint16_t connected_pid = 0;
+uint32_t connected_fingerprint = 0;
 
 bool joy_u = false, joy_d = false, joy_l = false, joy_r = false;
 bool joy_f1 = false, joy_f2 = false, joy_f3 = false, joy_up_alt = false, joy_auto = false;
 
-struct pkt_t { uint16_t len; uint8_t data[64]; };
+// 📦 --- PACKED LOGICAL CONTROLLER STATE (bit layout) --- 📦
+#define JS_UP         (1 << 0)
+#define JS_DOWN       (1 << 1)
+#define JS_LEFT       (1 << 2)
+#define JS_RIGHT      (1 << 3)
+#define JS_FIRE1      (1 << 4)
+#define JS_FIRE2      (1 << 5)
+#define JS_FIRE3      (1 << 6)
+#define JS_UP_ALT     (1 << 7)
+#define JS_AUTO       (1 << 8)
+#define JS_FACE3      (1 << 9)   // CD32 Green
+#define JS_FACE4      (1 << 10)  // CD32 Yellow
+#define JS_SHOULDER_L (1 << 11)  // CD32 Rewind
+#define JS_SHOULDER_R (1 << 12)  // CD32 Forward
+#define JS_START      (1 << 13)  // CD32 Play
+#define JS_EXTRA_MASK (JS_FACE3 | JS_FACE4 | JS_SHOULDER_L | JS_SHOULDER_R | JS_START)
+
+uint16_t joy_ext = 0; // Extra buttons (JS_EXTRA_MASK bits) beyond the classic joystick
+uint16_t joy_word = 0; // Last packed JS_* word routed to the port (telemetry)
+uint16_t mouse_btn_word = 0; // Mouse buttons as JS_* bits when they share the port with a pad / keyboard (ROUTE_OR)
+
+// Packet source (values match the HID boot protocol codes: 1 = keyboard, 2 = mouse)
+#define PKT_SRC_PAD      0
+#define PKT_SRC_KEYBOARD 1
+#define PKT_SRC_MOUSE    2
+// Control packets from usb_client_task: the loop applies routing, focus and output mode changes
+#define PKT_SRC_ATTACH   3  // Slot opened, data[0] = OutputMode to apply
+#define PKT_SRC_DETACH   4  // Slot cancelled, data[] = device name
+
+struct pkt_t { uint16_t len; uint8_t src; uint8_t slot; uint32_t t_us; uint8_t data[64]; }; // t_us = micros() at arrival
 static QueueHandle_t s_pkt_q = nullptr;
 
+// 🎯 --- RELEVANCE FILTER (UsbDevices.h) --- 🎯
+// Pad reports whose mapped bits did not change since the last queued one are dropped in the USB
+// callback, before the queue: gyro, touchpad and counter bytes no longer cost a full decode.
+#define RELEVANCE_FILTER       1    // 0 = every report is queued and decoded
+#define RELEVANCE_KEEPALIVE_MS 250  // An unchanged report still passes this often (keeps MUX ports alive with MUX_STALE_MS)
+#define RELEVANCE_TAIL         7    // Unchanged reports passed after a change while debounce counts them
+
+struct RelevanceMask {
+    uint32_t mask[16];     // Bits the active mapping reads, in 32-bit words of the report
+    uint32_t last[16];     // Last report seen, same layout
+    uint8_t words;         // Words up to the last relevant byte (0 = no filter)
+    uint8_t len;           // Length of the last queued report
+    uint8_t tail;          // Unchanged reports still to pass (debounce)
+    bool primed;           // last[] holds a report
+    uint32_t t_last_us;    // Last queued report
+    uint32_t skipped;      // Decodes saved
+};
+
+// 🔋 --- POWER GOVERNOR (esp_pm, PowerGovernor.h) --- 🔋
+// The CPU idles at POWER_MIN_MHZ and is raised to POWER_MAX_MHZ only while input reports keep changing.
+// Needs an Arduino core built with power management; without it the old fixed clocks are used.
+#define POWER_GOVERNOR        1     // 0 = fixed clocks (240 MHz with a mouse, 80 MHz otherwise)
+#define POWER_MAX_MHZ         240
+#define POWER_MIN_MHZ         80    // APB stays at 80 MHz, USB and UART timings do not move
+#define POWER_HOLD_MS         250   // Full speed is kept this long after the last changing report
+#define POWER_LIGHT_SLEEP     1     // Light sleep while the USB bus is empty and the CLI is quiet
+#define POWER_SERIAL_AWAKE_MS 30000 // No light sleep for this long after a character on the CLI
+// The loop sleeps on the packet queue: a report wakes it at once, these only pace the housekeeping
+#define LOOP_WAIT_MS          5     // With a device plugged in (autofire, LEDs, watchdog)
+#define LOOP_IDLE_WAIT_MS     50    // With an empty bus
+
+volatile uint32_t power_serial_ms = 0; // millis() of the last character received by the CLI
+volatile bool power_force_max = false;  // 'power max': keep full speed (A/B comparison)
+
+// 📡 --- BINARY TELEMETRY (Telemetry.h, 'telemetry' command) --- 📡
+#define TELEMETRY_BAUD          921600 // Default stream speed ('telemetry <baud>' picks another)
+#define TELEMETRY_HEARTBEAT_MS  50     // A frame is sent at least this often, even with no reports
+#define GPIO_DASH_MS            200    // The text 'gpio' dashboard redraws at most this often
+
+// 🔁 --- CLI -> LOOP REQUESTS --- 🔁
+// Pin modes, timers, interrupts and the status LED belong to the loop task (core 1). The CLI task
+// posts the change, the loop applies it between two report batches (apply_cli_requests) and clears the request.
+volatile int8_t output_mode_request = -1;   // OutputMode to switch to (-1 = none)
+volatile int8_t console_mode_request = -1;  // 1 = Amiga, 0 = C64 (-1 = none)
+volatile bool gpio_redraw_request = false;  // 'gp<n>': redraw the 'gpio' dashboard now
+volatile int8_t led_color_request = -1;     // 'color' test: COLOR_TEST_RGB entry to show (-1 = none)
+volatile int8_t led_brightness_request = -1; // Status LED brightness to restore (-1 = none)
+#define SERIAL_RX_BUFFER        4096   // Serial2 receive buffer: ~40 ms of 'inject' stream at 921600 baud
+
+// 📦 --- MEMORY (MemBudget.h, 'mem' command) --- 📦
+#define STATIC_ALLOC_BUILD  1  // Task stacks, TCBs and queues in .bss instead of the heap (0 = heap)
+
+// 📈 --- PROFILER (Profiler.h, 'top' command) --- 📈
+#define ISR_PROFILE     1     // 0 = no probes in the ISRs ('top' then shows tasks only)
+#define TOP_REFRESH_MS  1000  // 'top' measurement window
+
+// 📍 --- EDGE CAPTURE (EdgeCapture.h, 'edges' command) --- 📍
+#define EDGE_CAPTURE_LEN   1024    // Edges kept per capture (12 B each)
+#define EDGE_CAPTURE_S     10      // Default capture length ('edges <seconds>' picks another)
+#define EDGE_JOIN_MAX_US   50000   // Longer gaps are not caused by the report (autofire, timers)
+
+// ⏱️ --- MICRO-BENCHMARK (Bench.h, 'bench' command) --- ⏱️
+volatile bool bench_request = false; // Set by the CLI, the loop runs the benchmark and clears it
+bool pins_stubbed = false;           // Pin and LED writes are skipped (benchmark runs)
+
 // ⏱️ --- POLLING TESTER VARIABLES --- ⏱️
 unsigned long polling_start_time = 0;
 uint32_t polling_packet_count = 0;
@@ -119,6 +338,8 @@ uint8_t mix_brightness = 40;
 // Insert value from 1 to 5 where 1 is slow, 3 is normal, 5 is fast
 #define AMIGA_MOUSE_SPEED  3
 #define C64_MOUSE_SPEED    3
+uint8_t mouse_speed_amiga = AMIGA_MOUSE_SPEED; // Live values: the chord layer cycles them until reboot
+uint8_t mouse_speed_c64 = C64_MOUSE_SPEED;
 
 // 🖱️ --- MOUSE EMULATION VARIABLES (C64/AMIGA) --- 🖱️
 #define PAL 0 // 0 = NTSC, 1 = PAL
@@ -180,4 +401,79 @@ volatile uint64_t delayOffY = 10;
 hw_timer_t *timerOnX = NULL;
 hw_timer_t *timerOnY = NULL;
 hw_timer_t *timerOffX = NULL;
-hw_timer_t *timerOffY = NULL;
\ No newline at end of file
+hw_timer_t *timerOffY = NULL;
+hw_timer_t *timerDutyPeriod = NULL; // Amiga duty-cycle joystick frame clock
+
+// 🧭 --- ANALOG STICK AS 8-WAY JOYSTICK --- 🧭
+// Radial deadzone and angular sectors (AnalogEngine.h), used by both engines.
+// Raw stick units: 0..127 from the centre.
+#define STICK_DEADZONE       56   // Radius the stick must leave before a direction is sent
+#define STICK_DEADZONE_HYST  8    // ...and must come back inside (radius - hyst) to release it
+// Half-width of each cardinal sector in degrees: 22.5 = even 8-way split,
+// bigger = cardinals easier and diagonals harder (Boulder Dash, maze games)
+#define STICK_CARDINAL_DEG   27.5f
+#define STICK_HYST_DEG       4.0f // Sector border moves by this much against the current direction
+
+// 🎛️ --- PADDLE / DUTY-CYCLE JOYSTICK CALIBRATION --- 🎛️
+// Raw stick units (0-127) around the centre that snap to the middle of the POT range
+#define PADDLE_CENTER_DEADZONE 6
+// Calibration curve: 1 = linear, 2 = quadratic (fine control near the centre)
+#define PADDLE_CURVE_EXP       1
+
+// Axis inversion and Amiga pulse scale follow the HTML configurator when present.
+// JM_C64_ANALOG_DIV is not followed: the configurator divides the deflection by it into mouse counts
+// per report. A paddle is a position, not a count, and the stick mouse (OUT_MOUSE) runs at a fixed
+// rate of STICK_MOUSE_MAX_CPS whatever the pad's report rate.
+#if defined(JM_C64_Y_INVERT)
+  #define PADDLE_Y_INVERT JM_C64_Y_INVERT
+#else
+  #define PADDLE_Y_INVERT 0
+#endif
+
+#if defined(JM_A_Y_INVERT)
+  #define AMIGA_DUTY_Y_INVERT JM_A_Y_INVERT
+#else
+  #define AMIGA_DUTY_Y_INVERT 0
+#endif
+
+// Microseconds of direction pulse per unit of stick deflection (full deflection = 127 units)
+#if defined(JM_ATARI_PULSE_SCALE)
+  #define AMIGA_DUTY_PULSE_SCALE JM_ATARI_PULSE_SCALE
+#else
+  #define AMIGA_DUTY_PULSE_SCALE 18.6f
+#endif
+// One duty-cycle frame = full deflection pulse + a small release gap (timer ticks @ 10 MHz)
+#define AMIGA_DUTY_PERIOD_TICKS (uint64_t)((127.0f * AMIGA_DUTY_PULSE_SCALE + 200.0f) * 10.0f)
+
+// Latest duty-cycle pulse per axis, written by the decoder and consumed by the frame ISR
+volatile uint32_t duty_x_mask = 0, duty_y_mask = 0;   // GPIO bit of the direction to press (0 = centred)
+volatile uint32_t duty_x_ticks = 0, duty_y_ticks = 0; // Pulse width in timer ticks
+volatile uint32_t duty_x_armed = 0, duty_y_armed = 0; // Line pulled by the current pulse: the only one the off-timer releases
+
+// 🖱️ --- ANALOG STICK AS MOUSE (OUT_MOUSE, StickMouse.h) --- 🖱️
+// Stick deflection is a pointer velocity, integrated at a fixed rate: the pointer moves the same
+// on a 60 Hz and a 1000 Hz pad. The live mouse speed (1-5) still applies on top.
+#define STICK_MOUSE_HZ         250  // Integrator rate (esp_timer, the hardware timers are all taken)
+#define STICK_MOUSE_MAX_CPS    600  // Mouse counts per second at full deflection
+#define STICK_MOUSE_DEADZONE   12   // Raw stick units (0-127) around the centre that do not move
+#define STICK_MOUSE_CURVE_EXP  2    // 1 = linear, 2 = quadratic (fine pointing near the centre)
+#define STICK_MOUSE_DPAD_DEFL  64   // Deflection the D-Pad stands for (pads without a stick)
+
+// 🎮 --- AMIGA CD32 PAD EMULATION --- 🎮
+// Pin 5 (GP_POTY) LOW  = console latches the pad, pin 6 (GP_FIRE1) becomes its clock,
+// Pin 9 (GP_FIRE2)     = data out, one bit per clock edge, LOW = pressed.
+// Shift order: Blue, Red, Yellow, Green, Forward, Rewind, Play, then ID bits 1, 0, 0...
+#define CD32_BIT_BLUE    (1 << 0)
+#define CD32_BIT_RED     (1 << 1)
+#define CD32_BIT_YELLOW  (1 << 2)
+#define CD32_BIT_GREEN   (1 << 3)
+#define CD32_BIT_FORWARD (1 << 4)
+#define CD32_BIT_REWIND  (1 << 5)
+#define CD32_BIT_PLAY    (1 << 6)
+#define CD32_ID_BITS     (1 << 7)
+#define CD32_IDLE_WORD   (0x7F | CD32_ID_BITS) // Line levels with nothing pressed
+
+volatile uint32_t cd32_word  = CD32_IDLE_WORD; // Precomputed line levels, refreshed by the decoder in one store
+volatile uint32_t cd32_shift = 0;              // Bits still to be clocked out in the current read
+volatile bool     cd32_latched = false;        // Console is clocking the shift register
+portMUX_TYPE      cd32_mux = portMUX_INITIALIZER_UNLOCKED;
\ No newline at end of file
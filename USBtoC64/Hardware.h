@@ -9,12 +9,16 @@
 #include "driver/gpio.h"
 #include "soc/gpio_struct.h"
 #include "Globals.h"
+#include "Profiler.h"
+#include "EdgeCapture.h"
 
 // ⚡ --- FAST GPIO INTERRUPTS FOR C64 MOUSE (SID 1351) --- ⚡
 
 void IRAM_ATTR handleInterrupt() {
+    ISR_PROBE(ISR_POT_SYNC);
     // Workaround: sometimes the interrupt triggers twice, check pin level
     if (!((GPIO.in >> GP1) & 1)) return; 
+    if (edge_capture_sid) edge_record(EDGE_SYNC, 1);
     timerWrite(timerOnX, 0);
     timerAlarm(timerOnX, delayOnX, false, 0);
     timerWrite(timerOnY, 0);
@@ -22,6 +26,7 @@ void IRAM_ATTR handleInterrupt() {
 }
 
 void IRAM_ATTR turnOnPotX() {
+    ISR_PROBE(ISR_POTX_ON);
     // Pin 4 (GP_C64_SIG_MODE_SW) -> DB9 Pin 5 (POT X)
     GPIO.out_w1ts = (1 << GP_C64_SIG_MODE_SW); 
     timerWrite(timerOffX, 0);
@@ -29,10 +34,12 @@ void IRAM_ATTR turnOnPotX() {
 }
 
 void IRAM_ATTR turnOffPotX() { 
+    ISR_PROBE(ISR_POTX_OFF);
     GPIO.out_w1tc = (1 << GP_C64_SIG_MODE_SW); 
 }
 
 void IRAM_ATTR turnOnPotY() {
+    ISR_PROBE(ISR_POTY_ON);
     // Pin 6 (GP_POTY_GND) -> DB9 Pin 9 (POT Y)
     GPIO.out_w1ts = (1 << GP_POTY_GND); 
     timerWrite(timerOffY, 0);
@@ -40,25 +47,110 @@ void IRAM_ATTR turnOnPotY() {
 }
 
 void IRAM_ATTR turnOffPotY() { 
+    ISR_PROBE(ISR_POTY_OFF);
     GPIO.out_w1tc = (1 << GP_POTY_GND); 
 }
 
+// End of a duty-cycle pulse: release only the line this pulse pulled (latched at arm time),
+// a D-Pad press on the other line of the axis stays untouched
 void IRAM_ATTR turnOffJoyX() {
-    digitalWrite(GP_LEFT, LOW);
-    digitalWrite(GP_RIGHT, LOW);
-    pinMode(GP_LEFT, INPUT);
-    pinMode(GP_RIGHT, INPUT);
+    ISR_PROBE(ISR_JOYX_OFF);
+    GPIO.enable_w1tc = duty_x_armed;
+    duty_x_armed = 0;
 }
 
 void IRAM_ATTR turnOffJoyY() {
-    digitalWrite(GP_UP, LOW);
-    digitalWrite(GP_DOWN, LOW);
-    pinMode(GP_UP, INPUT);
-    pinMode(GP_DOWN, INPUT);
+    ISR_PROBE(ISR_JOYY_OFF);
+    GPIO.enable_w1tc = duty_y_armed;
+    duty_y_armed = 0;
+}
+
+// ⚡ --- AMIGA DUTY-CYCLE JOYSTICK FRAME CLOCK --- ⚡
+// A PWM on the digital direction lines (~2.5 ms frame), not the analog joystick POT0DAT/POT1DAT
+// read on pins 5/9: a game polling the port sees the direction held for the deflection's share of time.
+// Every frame: pull the direction line LOW (output latch is already LOW) and let the
+// one-shot off-timers release it after a pulse proportional to the stick deflection.
+void IRAM_ATTR amigaDutyFrame() {
+    ISR_PROBE(ISR_DUTY_FRAME);
+    uint32_t mx = duty_x_mask;
+    uint32_t my = duty_y_mask;
+    if (mx) {
+        duty_x_armed = mx;
+        GPIO.enable_w1ts = mx;
+        timerWrite(timerOffX, 0);
+        timerAlarm(timerOffX, duty_x_ticks, false, 0);
+        timerStart(timerOffX);
+    }
+    if (my) {
+        duty_y_armed = my;
+        GPIO.enable_w1ts = my;
+        timerWrite(timerOffY, 0);
+        timerAlarm(timerOffY, duty_y_ticks, false, 0);
+        timerStart(timerOffY);
+    }
+}
+
+// Loop: the D-Pad took the axis. Stop the pending off-timer so it cannot release the D-Pad's line,
+// and end the pulse now; update_hardware_and_leds() then drives the D-Pad direction.
+inline void duty_cancel_pulse(hw_timer_t *off_timer, volatile uint32_t &armed) {
+    timerStop(off_timer);
+    uint32_t m = armed;
+    armed = 0;
+    GPIO.enable_w1tc = m;
+}
+
+// ⚡ --- AMIGA CD32 SHIFT REGISTER (PIN 5 MODE / PIN 6 CLOCK / PIN 9 DATA) --- ⚡
+// set_output_mode() attaches both ISRs from the loop task (CLI and USB changes are posted to it),
+// but the spinlock is still taken on both sides: cd32_publish() must never refresh pins 6/9 in the
+// middle of a shift, whatever core the interrupt was registered on.
+
+// Open-collector drive: the output latch is LOW, enabling the driver pulls the line down
+static inline void IRAM_ATTR cd32_drive(uint32_t pin, uint32_t level_high) {
+    if (level_high) GPIO.enable_w1tc = (1UL << pin);
+    else            GPIO.enable_w1ts = (1UL << pin);
+}
+
+// Not latched: plain 2-button joystick, Red on pin 6 and Blue on pin 9
+static inline void IRAM_ATTR cd32_apply_fire_lines(uint32_t w) {
+    cd32_drive(GP_FIRE1, w & CD32_BIT_RED);
+    cd32_drive(GP_FIRE2, w & CD32_BIT_BLUE);
+}
+
+void IRAM_ATTR cd32ModeISR() {
+    ISR_PROBE(ISR_CD32_MODE);
+    portENTER_CRITICAL_ISR(&cd32_mux);
+    if (!((GPIO.in >> GP_POTY) & 1)) {
+        // Pin 5 LOW: hand pin 6 to the console clock and present the first bit (Blue)
+        uint32_t w = cd32_word;
+        GPIO.enable_w1tc = (1UL << GP_FIRE1);
+        cd32_drive(GP_FIRE2, w & 1);
+        cd32_shift = w >> 1;
+        cd32_latched = true;
+    } else {
+        cd32_latched = false;
+        cd32_apply_fire_lines(cd32_word);
+    }
+    portEXIT_CRITICAL_ISR(&cd32_mux);
+}
+
+void IRAM_ATTR cd32ClockISR() {
+    ISR_PROBE(ISR_CD32_CLOCK);
+    portENTER_CRITICAL_ISR(&cd32_mux);
+    if (cd32_latched) { // Otherwise our own Red button edge, not a console clock
+        uint32_t w = cd32_shift;
+        cd32_drive(GP_FIRE2, w & 1);
+        cd32_shift = w >> 1;
+    }
+    portEXIT_CRITICAL_ISR(&cd32_mux);
 }
 
 // 🔌 --- HARDWARE PIN MANAGEMENT --- 🔌
 
+// True while the C64 POT lines carry analog timing (1351 mouse, stick mouse or paddles) and must float
+inline bool pot_lines_analog() {
+    return is_mouse_connected || ((active_output_mode == OUT_PADDLE || active_output_mode == OUT_MOUSE) && !is_amiga);
+}
+
 void configure_console_mode(bool amiga_mode) {
     is_amiga = amiga_mode;
     if (is_amiga) {
@@ -79,17 +171,58 @@ void configure_console_mode(bool amiga_mode) {
     }
 }
 
+// --- CD32 MODE CONTROL ---
+inline void cd32_enable(bool on) {
+    if (on) {
+        // Output latches LOW + pull-ups: the ISRs only toggle the output enable
+        digitalWrite(GP_FIRE1, LOW); pinMode(GP_FIRE1, INPUT_PULLUP);
+        digitalWrite(GP_FIRE2, LOW); pinMode(GP_FIRE2, INPUT_PULLUP);
+        digitalWrite(GP_POTY, LOW);  pinMode(GP_POTY, INPUT_PULLUP); // Pin 5 is now the console's mode line
+        cd32_word = CD32_IDLE_WORD;
+        cd32_latched = false;
+        attachInterrupt(digitalPinToInterrupt(GP_POTY), cd32ModeISR, CHANGE);
+        attachInterrupt(digitalPinToInterrupt(GP_FIRE1), cd32ClockISR, RISING);
+    } else {
+        detachInterrupt(digitalPinToInterrupt(GP_POTY));
+        detachInterrupt(digitalPinToInterrupt(GP_FIRE1));
+        cd32_latched = false;
+    }
+}
+
+// Pressed buttons -> line levels in shift order (LOW = pressed)
+inline uint32_t cd32_pack(bool red, bool blue, uint16_t ext) {
+    uint32_t pressed = 0;
+    if (red)  pressed |= CD32_BIT_RED;
+    if (blue) pressed |= CD32_BIT_BLUE;
+    if (ext & JS_FACE3)      pressed |= CD32_BIT_GREEN;
+    if (ext & JS_FACE4)      pressed |= CD32_BIT_YELLOW;
+    if (ext & JS_SHOULDER_L) pressed |= CD32_BIT_REWIND;
+    if (ext & JS_SHOULDER_R) pressed |= CD32_BIT_FORWARD;
+    if (ext & JS_START)      pressed |= CD32_BIT_PLAY;
+    return CD32_IDLE_WORD & ~pressed;
+}
+
+// Decoder side: single store of the new word, pins 6/9 refreshed only while not latched
+inline void cd32_publish(uint32_t word) {
+    portENTER_CRITICAL(&cd32_mux);
+    cd32_word = word;
+    if (!cd32_latched) cd32_apply_fire_lines(word);
+    portEXIT_CRITICAL(&cd32_mux);
+}
+
 void set_joy_pin(int pin, bool pressed) {
+    if (pins_stubbed) return;
+
     // 🛡️ C64 Fire 2 (POT X / GP5)
     if (!is_amiga && pin == GP_FIRE2) {
         if (pressed) {
             pinMode(pin, OUTPUT); digitalWrite(pin, HIGH); // HIGH = PRESSED (SID reads 0)
         } else {
-            // Restore LOW (Released) ONLY if NOT using the mouse
-            if (!is_mouse_connected) {
+            // Restore LOW (Released) ONLY if NOT using the mouse or paddles
+            if (!pot_lines_analog()) {
                 pinMode(pin, OUTPUT); digitalWrite(pin, LOW); 
             } else {
-                pinMode(pin, INPUT); // Mouse mode: must float for hardware timers
+                pinMode(pin, INPUT); // Mouse/paddle mode: must float for hardware timers
             }
         }
         return; 
@@ -104,6 +237,8 @@ void set_joy_pin(int pin, bool pressed) {
 }
 
 void set_fire3_pin(bool pressed) {
+    if (pins_stubbed) return;
+
     if (is_amiga) {
         // Amiga Fire 3 (Pure digital Middle Button on Pin 5)
         if (pressed) { 
@@ -116,17 +251,17 @@ void set_fire3_pin(bool pressed) {
         if (pressed) {
             pinMode(GP_POTY, OUTPUT); digitalWrite(GP_POTY, HIGH); // HIGH = PRESSED (SID reads 0)
         } else {
-            // Restore LOW (Released) ONLY if NOT using the mouse
-            if (!is_mouse_connected) {
+            // Restore LOW (Released) ONLY if NOT using the mouse or paddles
+            if (!pot_lines_analog()) {
                 pinMode(GP_POTY, OUTPUT); digitalWrite(GP_POTY, LOW); 
             } else {
-                pinMode(GP_POTY, INPUT); // Mouse mode: must float for hardware timers
+                pinMode(GP_POTY, INPUT); // Mouse/paddle mode: must float for hardware timers
             }
         }
     }
 }
 
-String get_pin_status(int pin, bool is_active_low) {
+const char* get_pin_status(int pin, bool is_active_low) {
     int val = digitalRead(pin);
     if (is_active_low) return (val == LOW) ? "[ PRESSED ]" : "[ IDLE    ]";
     else return (val == HIGH) ? "[ ACTIVE  ]" : "[ IDLE    ]";
@@ -0,0 +1,266 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: Inject.h
+// Description: Serial input injection: timestamped logical states from a PC, applied by a one-shot esp_timer
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "soc/gpio_struct.h"
+#include "Globals.h"
+#include "Hardware.h"
+#include "Profiler.h"
+#include "TelemetryProtocol.h"
+
+// ==========================================
+// 💉 PART 1: FRAME RING AND CLOCK
+// ==========================================
+// The host streams InjFrame {t_us, word} (TelemetryProtocol.h) ahead of time. The service task
+// queues them in a ring and a one-shot esp_timer is always armed on the oldest queued frame: the
+// callback writes the pins and re-arms on the next one. The inject clock is esp_timer_get_time()
+// minus the time of the last RESET. All four hardware timers can be taken (C64: the POT timers),
+// so pacing goes through esp_timer: dispatched from its ISR where the SDK allows it, otherwise
+// from the esp_timer task (tens of us of jitter). Nothing on the USB path touches the pins while
+// inject mode runs. The clock is 32-bit: one session (between two RESETs) lasts up to 71 minutes.
+
+#define INJECT_RING_SIZE  1024  // Frames queued ahead (power of two)
+#define INJECT_STATUS_MS  20    // Status frame period (the host's flow control)
+
+static InjFrame inj_ring[INJECT_RING_SIZE];
+static volatile uint16_t inj_head = 0;     // Written by the service task
+static volatile uint16_t inj_tail = 0;     // Written by the timer callback
+static volatile bool inj_armed = false;    // An alarm is pending on inj_ring[inj_tail]
+static volatile bool inj_ended = false;    // Host sent INJ_END
+static esp_timer_handle_t inj_timer = nullptr;
+static int64_t inj_clock_base = 0;         // esp_timer_get_time() at the last RESET
+static portMUX_TYPE inj_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Line masks captured when the mode starts
+static uint32_t inj_od_mask = 0;    // Open-drain lines: pressed = driver enabled (latch LOW)
+static uint32_t inj_pot_mask = 0;   // C64 POT fire lines: pressed = output HIGH
+
+// applied / underruns belong to the timer callback (written under inj_mux), the rest to the service task
+static uint32_t inj_applied = 0;
+static uint32_t inj_underruns = 0;
+static uint32_t inj_overruns = 0;
+static uint32_t inj_late = 0;
+static uint32_t inj_max_late_us = 0;
+static uint32_t inj_tag = 0;
+static uint16_t inj_seq = 0;
+static uint32_t inj_last_status_ms = 0;
+static TelemDecoder inj_rx;
+
+inline uint16_t inj_count() { return (uint16_t)(inj_head - inj_tail) & (INJECT_RING_SIZE - 1); }
+static inline uint32_t IRAM_ATTR inj_now() { return (uint32_t)(esp_timer_get_time() - inj_clock_base); }
+
+// Arms the one-shot on frame time t_us (a frame whose time already passed fires at once). Under inj_mux.
+static inline void IRAM_ATTR inj_arm(uint32_t t_us) {
+    int32_t wait = (int32_t)(t_us - inj_now());
+    esp_timer_start_once(inj_timer, wait > 0 ? (uint64_t)wait : 0);
+}
+
+
+// ==========================================
+// ⚡ PART 2: TIMER CALLBACK (PIN OUTPUT)
+// ==========================================
+
+static inline void IRAM_ATTR inj_write_pins(uint16_t w) {
+    uint32_t od = 0, pot = 0;
+    if (w & (JS_UP | JS_UP_ALT)) od |= (1UL << GP_UP);
+    if (w & JS_DOWN)             od |= (1UL << GP_DOWN);
+    if (w & JS_LEFT)             od |= (1UL << GP_LEFT);
+    if (w & JS_RIGHT)            od |= (1UL << GP_RIGHT);
+    if (w & JS_FIRE1)            od |= (1UL << GP_FIRE1);
+    if (w & JS_FIRE2) { od |= (1UL << GP_FIRE2); pot |= (1UL << GP_FIRE2); }
+    if (w & JS_FIRE3) { od |= (1UL << GP_POTY);  pot |= (1UL << GP_POTY); }
+
+    od &= inj_od_mask;
+    pot &= inj_pot_mask;
+    GPIO.enable_w1ts = od;
+    GPIO.enable_w1tc = inj_od_mask & ~od;
+    GPIO.out_w1ts = pot;
+    GPIO.out_w1tc = inj_pot_mask & ~pot;
+}
+
+static void IRAM_ATTR inj_timer_cb(void *) {
+    ISR_PROBE(ISR_INJECT);
+    portENTER_CRITICAL_SAFE(&inj_mux);
+    if (inj_tail != inj_head) {
+        inj_write_pins(inj_ring[inj_tail].word);
+        inj_tail = (inj_tail + 1) & (INJECT_RING_SIZE - 1);
+        inj_applied++;
+    }
+    if (inj_tail != inj_head) {
+        inj_arm(inj_ring[inj_tail].t_us);
+    } else {
+        inj_armed = false;
+        if (!inj_ended) inj_underruns++;
+    }
+    portEXIT_CRITICAL_SAFE(&inj_mux);
+}
+
+
+// ==========================================
+// 📥 PART 3: HOST FRAMES (SERVICE TASK)
+// ==========================================
+
+inline void inj_send_status() {
+    InjStatus st;
+    st.clock_us = inj_now();
+    st.tag = inj_tag;
+    st.ring_free = (INJECT_RING_SIZE - 1) - inj_count();
+    st.ring_size = INJECT_RING_SIZE - 1;
+    st.applied = inj_applied;
+    st.underruns = inj_underruns;
+    st.overruns = inj_overruns;
+    st.late = inj_late;
+    st.max_late_us = inj_max_late_us;
+
+    uint8_t frame[TELEM_HEADER_LEN + sizeof(InjStatus) + TELEM_CRC_LEN];
+    telem_build_frame(frame, TELEM_TYPE_INJ_STATUS, inj_seq++, &st, sizeof(st));
+    Serial2.write(frame, sizeof(frame));
+    inj_last_status_ms = millis();
+}
+
+// Queues one frame. Returns false when the ring is full (the frame is lost, the host overran us).
+inline bool inj_push(const InjFrame &f) {
+    uint32_t now = inj_now();
+    if ((int32_t)(f.t_us - now) < 0) {
+        inj_late++;
+        if (now - f.t_us > inj_max_late_us) inj_max_late_us = now - f.t_us;
+    }
+
+    bool ok = true;
+    portENTER_CRITICAL(&inj_mux);
+    uint16_t next = (inj_head + 1) & (INJECT_RING_SIZE - 1);
+    if (next == inj_tail) {
+        ok = false;
+    } else {
+        inj_ring[inj_head] = f;
+        inj_head = next;
+        if (!inj_armed) {
+            inj_armed = true;
+            inj_arm(f.t_us);
+        }
+    }
+    portEXIT_CRITICAL(&inj_mux);
+    return ok;
+}
+
+inline void inj_reset() {
+    portENTER_CRITICAL(&inj_mux);
+    esp_timer_stop(inj_timer); // Fails harmlessly when nothing is pending
+    inj_clock_base = esp_timer_get_time();
+    inj_head = 0;
+    inj_tail = 0;
+    inj_armed = false;
+    inj_ended = false;
+    inj_applied = 0;
+    inj_underruns = 0;
+    inj_write_pins(0);
+    portEXIT_CRITICAL(&inj_mux);
+    inj_overruns = 0;
+    inj_late = 0;
+    inj_max_late_us = 0;
+}
+
+extern void inject_stop();
+
+inline void inj_handle_frame(const TelemDecoder &d) {
+    switch (d.type()) {
+        case TELEM_TYPE_INJ_FRAMES: {
+            int n = d.len() / sizeof(InjFrame);
+            for (int i = 0; i < n; i++) {
+                InjFrame f;
+                memcpy(&f, d.payload() + i * sizeof(InjFrame), sizeof(f));
+                if (!inj_push(f)) inj_overruns++;
+            }
+            inj_ended = false;
+            break;
+        }
+        case TELEM_TYPE_INJ_SYNC:
+            if (d.len() >= 4) memcpy(&inj_tag, d.payload(), 4);
+            inj_send_status();
+            break;
+        case TELEM_TYPE_INJ_RESET: inj_reset(); break;
+        case TELEM_TYPE_INJ_END:   inj_ended = true; break;
+        case TELEM_TYPE_INJ_EXIT:  inject_stop(); break;
+    }
+}
+
+// Runs instead of the text CLI while inject mode is active (service task, every tick)
+void inject_service() {
+    while (Serial2.available() > 0) {
+        if (inj_rx.push((uint8_t)Serial2.read())) inj_handle_frame(inj_rx);
+        if (current_mode != MODE_INJECT) return; // INJ_EXIT
+    }
+    if (millis() - inj_last_status_ms >= INJECT_STATUS_MS) inj_send_status();
+}
+
+
+// ==========================================
+// 🎛️ PART 4: START / STOP
+// ==========================================
+
+// Setup: the timer is created once, before the memory budget is sealed
+inline void inject_init() {
+    esp_timer_create_args_t args = {};
+    args.callback = &inj_timer_cb;
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+    args.dispatch_method = ESP_TIMER_ISR;
+#else
+    args.dispatch_method = ESP_TIMER_TASK;
+#endif
+    args.name = "inject";
+    if (esp_timer_create(&args, &inj_timer) != ESP_OK) inj_timer = nullptr;
+}
+
+bool inject_start(uint32_t baud) {
+    if (active_output_mode == OUT_CD32) {
+        Serial2.println(">>> ERROR: Inject drives a plain joystick. Type 'cd32' to leave CD32 mode first.");
+        return false;
+    }
+    if (!inj_timer) {
+        Serial2.println(">>> ERROR: Inject has no pacing timer (esp_timer_create failed at boot).");
+        return false;
+    }
+
+    // Open-drain lines: latch LOW + pull-up, the callback only toggles the output enable
+    inj_od_mask = (1UL << GP_UP) | (1UL << GP_DOWN) | (1UL << GP_LEFT) | (1UL << GP_RIGHT) | (1UL << GP_FIRE1);
+    inj_pot_mask = 0;
+    if (is_amiga) inj_od_mask |= (1UL << GP_FIRE2) | (1UL << GP_POTY);
+    else if (!pot_lines_analog()) inj_pot_mask = (1UL << GP_FIRE2) | (1UL << GP_POTY); // Already LOW outputs
+    for (int pin : { GP_UP, GP_DOWN, GP_LEFT, GP_RIGHT, GP_FIRE1, GP_FIRE2, GP_POTY }) {
+        if (inj_od_mask & (1UL << pin)) { digitalWrite(pin, LOW); pinMode(pin, INPUT_PULLUP); }
+    }
+
+    Serial2.printf("\n>>> 💉 INJECT MODE @ %lu baud: the DB9 now follows the serial stream, USB input is ignored.\n", (unsigned long)baud);
+    Serial2.println(">>> Binary frames only from here on (INJ_EXIT frame to leave).");
+    Serial2.flush();
+    Serial2.updateBaudRate(baud);
+
+    inj_reset();
+    inj_rx.n = 0;
+    inj_seq = 0;
+    current_mode = MODE_INJECT;
+    inj_send_status();
+    return true;
+}
+
+void inject_stop() {
+    portENTER_CRITICAL(&inj_mux);
+    esp_timer_stop(inj_timer); // Nothing pending while idle
+    inj_head = 0;
+    inj_tail = 0;
+    inj_armed = false;
+    inj_write_pins(0);
+    portEXIT_CRITICAL(&inj_mux);
+
+    Serial2.flush();
+    Serial2.updateBaudRate(115200);
+    current_mode = MODE_SERVICE;
+    Serial2.printf("\n>>> 💉 INJECT MODE OFF: %lu frames applied, %lu underruns, %lu overruns, %lu late (max %lu us).\n",
+                   (unsigned long)inj_applied, (unsigned long)inj_underruns, (unsigned long)inj_overruns,
+                   (unsigned long)inj_late, (unsigned long)inj_max_late_us);
+}
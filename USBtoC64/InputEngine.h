@@ -9,6 +9,7 @@
 #include "Globals.h"
 #include "Hardware.h"
 #include "ServiceTools.h"
+#include "AnalogEngine.h"
 
 // ==========================================
 // 🖱️ PART 1: MOUSE PROCESSING ENGINE
@@ -26,12 +27,14 @@ inline float get_mouse_multiplier(int speed) {
 
 // --- AMIGA QUADRATURE HELPERS (Push-Pull Mode) ---
 inline void AHorizontalMove(int pulse) {
+    if (pins_stubbed) return;
     pinMode(GP_DOWN, OUTPUT); digitalWrite(GP_DOWN, H[QX]);
     pinMode(GP_RIGHT, OUTPUT); digitalWrite(GP_RIGHT, HQ[QX]);
     delayMicroseconds(pulse);
 }
 
 inline void AVerticalMove(int pulse) {
+    if (pins_stubbed) return;
     pinMode(GP_UP, OUTPUT); digitalWrite(GP_UP, H[QY]);
     pinMode(GP_LEFT, OUTPUT); digitalWrite(GP_LEFT, HQ[QY]);
     delayMicroseconds(pulse);
@@ -44,11 +47,11 @@ inline void A_Up(int pulse)    { AVerticalMove(pulse); QY = (QY >= 3) ? 0 : ++QY
 
 
 // --- AMIGA MOUSE MODE (Quadrature) ---
-inline void process_amiga_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, bool b_mid) {
+inline void process_amiga_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, bool b_mid, bool route_buttons) {
     // Fraction accumulator for smooth scaling
     static float a_rem_x = 0;
     static float a_rem_y = 0;
-    float mult = get_mouse_multiplier(AMIGA_MOUSE_SPEED);
+    float mult = get_mouse_multiplier(mouse_speed_amiga);
 
     float real_dx = ((float)dx * mult) + a_rem_x;
     float real_dy = ((float)dy * mult) + a_rem_y;
@@ -66,9 +69,11 @@ inline void process_amiga_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right,
     
     int pulse = PULSE_LENGTH;
 
-    set_joy_pin(GP_FIRE1, b_left);
-    set_joy_pin(GP_FIRE2, b_right);
-    set_fire3_pin(b_mid);
+    if (!route_buttons) {
+        set_joy_pin(GP_FIRE1, b_left);
+        set_joy_pin(GP_FIRE2, b_right);
+        set_fire3_pin(b_mid);
+    }
 
     while ((xsteps | ysteps) != 0) {
         if (xsteps != 0) {
@@ -86,17 +91,19 @@ inline void process_amiga_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right,
 
 
 // --- COMMODORE 64 MOUSE MODE (1351 Analog) ---
-inline void process_c64_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, bool b_mid) {
+inline void process_c64_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, bool b_mid, bool route_buttons) {
     
     // FIX "CRAZY MOUSE" ON C64
     // We must release the pins to high impedance (INPUT) to let the SID capacitors charge!
-    pinMode(GP_FIRE2, INPUT); 
-    pinMode(GP_POTY, INPUT);
+    if (!pins_stubbed) {
+        pinMode(GP_FIRE2, INPUT); 
+        pinMode(GP_POTY, INPUT);
+    }
 
     // Fraction accumulator for smooth scaling
     static float c64_rem_x = 0;
     static float c64_rem_y = 0;
-    float mult = get_mouse_multiplier(C64_MOUSE_SPEED);
+    float mult = get_mouse_multiplier(mouse_speed_c64);
 
     float real_dx = ((float)dx * mult) + c64_rem_x;
     float real_dy = ((float)dy * mult) + c64_rem_y;
@@ -107,9 +114,11 @@ inline void process_c64_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, b
     c64_rem_x = real_dx - final_dx;
     c64_rem_y = real_dy - final_dy;
 
-    set_joy_pin(GP_FIRE1, b_left);
-    set_joy_pin(GP_UP, b_right);
-    set_joy_pin(GP_DOWN, b_mid);
+    if (!route_buttons) {
+        set_joy_pin(GP_FIRE1, b_left);
+        set_joy_pin(GP_UP, b_right);
+        set_joy_pin(GP_DOWN, b_mid);
+    }
 
     float new_x = (float)delayOnX + (STEPdelayOnX * (float)final_dx);
     if (new_x > MAXdelayOnX) new_x = MINdelayOnX;
@@ -124,17 +133,26 @@ inline void process_c64_mouse(int8_t dx, int8_t dy, bool b_left, bool b_right, b
 
 
 // --- MAIN MOUSE DISPATCHER ---
-// Accepts strict 3-byte BOOT Protocol packets
-inline void process_mouse(uint8_t buttons, int8_t dx, int8_t dy) {
+// Accepts strict 3-byte BOOT Protocol packets.
+// route_buttons: a pad / keyboard shares the port (ROUTE_OR), so the buttons go into mouse_btn_word
+// and reach the pins through usb_route_word() instead of being written here over the joystick lines.
+inline void process_mouse(uint8_t buttons, int8_t dx, int8_t dy, bool route_buttons = false) {
     bool b_left  = (buttons & 0x01) != 0;
     bool b_right = (buttons & 0x02) != 0;
     bool b_mid   = (buttons & 0x04) != 0;
 
+    mouse_btn_word = 0;
+    if (route_buttons) {
+        if (b_left) mouse_btn_word |= JS_FIRE1;
+        if (b_right) mouse_btn_word |= is_amiga ? JS_FIRE2 : JS_UP;
+        if (b_mid) mouse_btn_word |= is_amiga ? JS_FIRE3 : JS_DOWN;
+    }
+
     // AUTO-DETECT: Hardware knows the target machine via the toggle switch
     if (is_amiga) {
-        process_amiga_mouse(dx, dy, b_left, b_right, b_mid);
+        process_amiga_mouse(dx, dy, b_left, b_right, b_mid, route_buttons);
     } else {
-        process_c64_mouse(dx, dy, b_left, b_right, b_mid);
+        process_c64_mouse(dx, dy, b_left, b_right, b_mid, route_buttons);
     }
 }
 
@@ -143,7 +161,118 @@ inline void process_mouse(uint8_t buttons, int8_t dx, int8_t dy) {
 // 🕹️ PART 2: JOYSTICK PROCESSING ENGINE
 // ==========================================
 
-inline void process_joystick(const uint8_t *raw_data, int len) {
+// Unpacks a routed JS_* word into the output flags read by update_hardware_and_leds()
+inline void set_joy_word(uint16_t w) {
+    joy_u = (w & JS_UP) != 0;       joy_d = (w & JS_DOWN) != 0;
+    joy_l = (w & JS_LEFT) != 0;     joy_r = (w & JS_RIGHT) != 0;
+    joy_f1 = (w & JS_FIRE1) != 0;   joy_f2 = (w & JS_FIRE2) != 0;
+    joy_f3 = (w & JS_FIRE3) != 0;
+    joy_up_alt = (w & JS_UP_ALT) != 0;
+    joy_auto = (w & JS_AUTO) != 0;
+    joy_ext = w & JS_EXTRA_MASK;
+    joy_word = w;
+}
+
+// --- Report-ID multiplexer ---
+// Stores one port's word in the slot owned by its report ID (claims a free slot on first sight)
+inline void mux_store(MuxState &m, uint8_t id, uint16_t word) {
+    if (id == 0) return;
+    int slot = -1, free_slot = -1;
+    for (int i = 0; i < MUX_SLOTS; i++) {
+        if (m.id[i] == id) { slot = i; break; }
+        if (m.id[i] == 0 && free_slot < 0) free_slot = i;
+    }
+    if (slot < 0) {
+        if (free_slot < 0) return; // More ports than slots: extra IDs are ignored
+        slot = free_slot;
+        m.id[slot] = id;
+    }
+    m.word[slot] = word;
+    m.last_ms[slot] = millis();
+    if (word & JS_START) m.selected = slot;
+}
+
+// Single reduction over the slot words. Slots fill in order of first report, so PRIORITY compares
+// report IDs (port numbers), not slot indexes. With MUX_STALE_MS set, expired ports are released on the way.
+inline uint16_t mux_merge(MuxState &m) {
+    uint32_t now = millis();
+    uint16_t merged = 0;
+    uint8_t best_id = 0xFF;
+    for (int i = 0; i < MUX_SLOTS; i++) {
+        if (m.id[i] == 0) continue;
+        if (MUX_STALE_MS && now - m.last_ms[i] > MUX_STALE_MS) { m.id[i] = 0; m.word[i] = 0; continue; }
+        uint16_t w = m.word[i];
+        if (mux_mode == MUX_OR) merged |= w;
+        else if (mux_mode == MUX_PRIORITY) { if (w && m.id[i] <= best_id) { best_id = m.id[i]; merged = w; } }
+        else if (i == m.selected) merged = w;
+    }
+    return merged;
+}
+
+// --- Glitch filter: bit-parallel vertical counters ---
+// Each button owns a 3-bit counter spread over three words, so all 14 buttons are counted,
+// compared with their own threshold and toggled with a handful of word operations per report.
+static uint16_t deb_press[3], deb_release[3], deb_immediate[3];
+
+// Thresholds are stored bit-sliced like the counters (bit i of slice K = bit K of threshold i)
+inline void build_debounce_masks() {
+    memset(deb_press, 0, sizeof(deb_press));
+    memset(deb_release, 0, sizeof(deb_release));
+    for (int i = 0; i < 14; i++) {
+        uint8_t p = constrain(DEBOUNCE_PRESS[i], 1, 7);
+        uint8_t r = constrain(DEBOUNCE_RELEASE[i], 1, 7);
+        for (int k = 0; k < 3; k++) {
+            if (p & (1 << k)) deb_press[k] |= (1 << i);
+            if (r & (1 << k)) deb_release[k] |= (1 << i);
+        }
+    }
+    deb_immediate[0] = 0x3FFF; deb_immediate[1] = 0; deb_immediate[2] = 0; // Threshold 1 everywhere
+}
+
+inline uint16_t debounce_word(DebounceState &d, uint16_t raw) {
+    if (debounce_mode == DEB_OFF) {
+        d.state = raw; d.c0 = d.c1 = d.c2 = 0;
+        return raw;
+    }
+    d.raw = raw;
+    uint16_t delta = raw ^ d.state;
+
+    // A pending change whose bit is back to the filtered value was a glitch
+    uint16_t pending = d.c0 | d.c1 | d.c2;
+    d.glitches += __builtin_popcount(pending & ~delta);
+
+    // Vertical increment for the differing bits, reset for the others
+    uint16_t c0 = ~d.c0, c1 = d.c1 ^ d.c0, c2 = d.c2 ^ (d.c1 & d.c0);
+    d.c0 = c0 & delta; d.c1 = c1 & delta; d.c2 = c2 & delta;
+
+    // Press threshold where the raw bit is set, release threshold where it is clear
+    const uint16_t *p = (debounce_mode == DEB_FAST) ? deb_immediate : deb_press;
+    uint16_t t0 = (raw & p[0]) | (~raw & deb_release[0]);
+    uint16_t t1 = (raw & p[1]) | (~raw & deb_release[1]);
+    uint16_t t2 = (raw & p[2]) | (~raw & deb_release[2]);
+    uint16_t reached = delta & ~((d.c0 ^ t0) | (d.c1 ^ t1) | (d.c2 ^ t2));
+
+    d.state ^= reached;
+    d.c0 &= ~reached; d.c1 &= ~reached; d.c2 &= ~reached;
+    return d.state;
+}
+
+// Loop: one more count for a pending change while the pad stays silent, once per report interval
+// (+1 ms of frame jitter, so a streaming pad's next report always comes first). True = state moved.
+inline bool debounce_tick(DebounceState &d, uint32_t now_ms, uint8_t interval_ms) {
+    if (!(d.c0 | d.c1 | d.c2) || now_ms - d.t_ms <= (uint32_t)interval_ms + 1) return false;
+    uint16_t before = d.state;
+    debounce_word(d, d.raw);
+    d.t_ms = now_ms;
+    return d.state != before;
+}
+
+// Extra buttons are optional bit masks (byte 0 = not mapped)
+inline bool pad_bit(const uint8_t *raw_data, int len, int byte_idx, uint8_t mask) {
+    return byte_idx != 0 && len > byte_idx && (raw_data[byte_idx] & mask) != 0;
+}
+
+inline void process_joystick(const PadConfig &prof, DevState &ds, const uint8_t *raw_data, int len) {
     if (current_mode == MODE_POLLING) {
         if (polling_active) {
             if (!polling_neutral_saved) {
@@ -167,13 +296,21 @@ inline void process_joystick(const uint8_t *raw_data, int len) {
     }
 
     if (current_mode == MODE_SNIFFER) { run_sniffer(connected_vid, connected_pid, raw_data, len); return; }
+    if (current_mode == MODE_AUTOPROFILE) { run_autoprofiler(raw_data, len); return; }
     if (current_mode == MODE_RAW)     { run_raw_sniffer(raw_data, len); return; }
     if (current_mode == MODE_SERVICE) return; 
-    if (!device_connected || len < 3) return;
+    if ((!device_connected && current_mode != MODE_BENCH) || len < 3) return;
 
     // --- Variables declaration ---
     bool u = false, d = false, l = false, r = false;
     bool f1 = false, f2 = false, f3 = false, f_alt = false, auto_btn = false;
+    uint16_t ext = 0; // CD32 extra buttons (JS_EXTRA_MASK)
+
+    // --- Paddle / Duty-cycle / Stick mouse modes: raw stick position (128 = centre) ---
+    bool paddle_on = (active_output_mode == OUT_PADDLE);
+    bool stick_mouse_on = (active_output_mode == OUT_MOUSE);
+    bool analog_out = paddle_on || stick_mouse_on;
+    uint8_t pad_x = 128, pad_y = 128;
 
 #if HAS_HTML_CONFIGURATOR
     if (use_html_configurator) {
@@ -215,6 +352,7 @@ inline void process_joystick(const uint8_t *raw_data, int len) {
             }
         }
         f3 = f3_html; f_alt = false; 
+        if (f3_html) ext |= JS_FACE3; // HTML rules know only 3 fires: Fire 3 doubles as CD32 Green
         
         // --- SMART HTML AUTOFIRE ---
         static bool html_autofire_latch = false;
@@ -228,20 +366,21 @@ inline void process_joystick(const uint8_t *raw_data, int len) {
         auto_btn = has_html_off_btn ? html_autofire_latch : html_auto_on;
         
         #if JM_USE_ANALOG_MOUSE == 1
-        for (size_t i = 0; i < (sizeof(JM_MOUSE_X_INDEXES)/sizeof(JM_MOUSE_X_INDEXES[0])); i++) {
-            uint8_t idx = JM_MOUSE_X_INDEXES[i];
-            if (idx < len) {
-                uint8_t val = raw_data[idx];
-                if (val < JM_ANALOG_DEAD_LOW) l = true;
-                if (val > JM_ANALOG_DEAD_HIGH) r = true;
-            }
-        }
-        for (size_t i = 0; i < (sizeof(JM_MOUSE_Y_INDEXES)/sizeof(JM_MOUSE_Y_INDEXES[0])); i++) {
-            uint8_t idx = JM_MOUSE_Y_INDEXES[i];
-            if (idx < len) {
-                uint8_t val = raw_data[idx];
-                if (val < JM_ANALOG_DEAD_LOW) u = true;
-                if (val > JM_ANALOG_DEAD_HIGH) d = true;
+        if (analog_out) {
+            // The first analog pair drives the paddles / pointer instead of the digital directions
+            if (JM_MOUSE_X_INDEXES[0] < len) pad_x = raw_data[JM_MOUSE_X_INDEXES[0]];
+            if (JM_MOUSE_Y_INDEXES[0] < len) pad_y = raw_data[JM_MOUSE_Y_INDEXES[0]];
+        } else {
+            // Each X/Y index pair is one stick (radial deadzone + 8-way sectors)
+            size_t count_x = sizeof(JM_MOUSE_X_INDEXES)/sizeof(JM_MOUSE_X_INDEXES[0]);
+            size_t count_y = sizeof(JM_MOUSE_Y_INDEXES)/sizeof(JM_MOUSE_Y_INDEXES[0]);
+            size_t sticks = count_x > count_y ? count_x : count_y;
+            for (size_t i = 0; i < sticks; i++) {
+                int sx = (i < count_x && JM_MOUSE_X_INDEXES[i] < len) ? raw_data[JM_MOUSE_X_INDEXES[i]] - 128 : 0;
+                int sy = (i < count_y && JM_MOUSE_Y_INDEXES[i] < len) ? raw_data[JM_MOUSE_Y_INDEXES[i]] - 128 : 0;
+                uint8_t dirs = stick_to_dirs(ds.stick_dir[i & 1], sx, sy);
+                if (dirs & JS_UP) u = true;    if (dirs & JS_DOWN) d = true;
+                if (dirs & JS_LEFT) l = true;  if (dirs & JS_RIGHT) r = true;
             }
         }
         #endif
@@ -250,78 +389,77 @@ inline void process_joystick(const uint8_t *raw_data, int len) {
 #endif
         // --- NATIVE ENGINE ---
         
-        // Step 1: Independently compute Analog values
+        // Step 1: Independently compute Analog values (radial deadzone + 8-way sectors)
         bool a_u = false, a_d = false, a_l = false, a_r = false;
-
-        if (current_profile.byte_analog_x != 0 || current_profile.byte_analog_y != 0) {
-            if (len > current_profile.byte_analog_x) {
-                uint8_t ax = raw_data[current_profile.byte_analog_x]; 
-                if (ax < 64) a_l = true; if (ax > 192) a_r = true;
-            }
-            if (len > current_profile.byte_analog_y) {
-                uint8_t ay = raw_data[current_profile.byte_analog_y];
-                if (ay < 64) a_u = true; if (ay > 192) a_d = true;
+        uint8_t a_dirs = 0;
+
+        if ((prof.byte_analog_x != 0 || prof.byte_analog_y != 0) && prof.dpad_type != HYBRID_16BIT_BITMASK) {
+            int sx = (len > prof.byte_analog_x) ? raw_data[prof.byte_analog_x] - 128 : 0;
+            int sy = (len > prof.byte_analog_y) ? raw_data[prof.byte_analog_y] - 128 : 0;
+            a_dirs |= stick_to_dirs(ds.stick_dir[0], sx, sy);
+            if (analog_out) {
+                if (len > prof.byte_analog_x) pad_x = raw_data[prof.byte_analog_x];
+                if (len > prof.byte_analog_y) pad_y = raw_data[prof.byte_analog_y];
             }
         }
-        if (current_profile.byte_analog_right_x != 0 || current_profile.byte_analog_right_y != 0) {
-            if (len > current_profile.byte_analog_right_x) {
-                uint8_t rx = raw_data[current_profile.byte_analog_right_x]; 
-                if (rx < 64) a_l = true; if (rx > 192) a_r = true;
-            }
-            if (len > current_profile.byte_analog_right_y) {
-                uint8_t ry = raw_data[current_profile.byte_analog_right_y];
-                if (ry < 64) a_u = true; if (ry > 192) a_d = true;
-            }
+        if (prof.byte_analog_right_x != 0 || prof.byte_analog_right_y != 0) {
+            int sx = (len > prof.byte_analog_right_x) ? raw_data[prof.byte_analog_right_x] - 128 : 0;
+            int sy = (len > prof.byte_analog_right_y) ? raw_data[prof.byte_analog_right_y] - 128 : 0;
+            a_dirs |= stick_to_dirs(ds.stick_dir[1], sx, sy);
         }
 
         // Step 2: Independently compute Digital D-Pad values
         bool d_u = false, d_d = false, d_l = false, d_r = false;
 
-        if (current_profile.dpad_type == HYBRID_16BIT_BITMASK) {
-            int idx_x = current_profile.byte_analog_x; int idx_y = current_profile.byte_analog_y;
+        if (prof.dpad_type == HYBRID_16BIT_BITMASK) {
+            int idx_x = prof.byte_analog_x; int idx_y = prof.byte_analog_y;
             if (len > idx_y + 1) { 
                 int16_t axis_x = (int16_t)(raw_data[idx_x] | (raw_data[idx_x + 1] << 8));
                 int16_t axis_y = (int16_t)(raw_data[idx_y] | (raw_data[idx_y + 1] << 8));
-                a_u = a_u || (axis_y > 16000); a_d = a_d || (axis_y < -16000);
-                a_r = a_r || (axis_x > 16000); a_l = a_l || (axis_x < -16000);
+                a_dirs |= stick_to_dirs(ds.stick_dir[0], axis_x >> 8, -(axis_y >> 8)); // 16-bit Y grows upwards
+                if (analog_out) { pad_x = axis16_to_raw(axis_x, false); pad_y = axis16_to_raw(axis_y, true); }
                 
-                uint8_t dpad = raw_data[current_profile.byte_x];
-                d_u = (dpad & current_profile.val_up) != 0; d_d = (dpad & current_profile.val_down) != 0;
-                d_l = (dpad & current_profile.val_left) != 0; d_r = (dpad & current_profile.val_right) != 0;
+                uint8_t dpad = raw_data[prof.byte_x];
+                d_u = (dpad & prof.val_up) != 0; d_d = (dpad & prof.val_down) != 0;
+                d_l = (dpad & prof.val_left) != 0; d_r = (dpad & prof.val_right) != 0;
             }
         }
-        else if (current_profile.dpad_type == AXIS) {
-            if (len > current_profile.byte_y) {
-                uint8_t x = raw_data[current_profile.byte_x]; uint8_t y = raw_data[current_profile.byte_y];
+        else if (prof.dpad_type == AXIS) {
+            if (len > prof.byte_y) {
+                uint8_t x = raw_data[prof.byte_x]; uint8_t y = raw_data[prof.byte_y];
                 d_l = (x < 64); d_r = (x > 192); d_u = (y < 64); d_d = (y > 192);
             }
         } 
-        else if (current_profile.dpad_type == HAT_SWITCH) {
-            if (len > current_profile.byte_x) {
-                uint8_t hat = raw_data[current_profile.byte_x] & 0x0F;
+        else if (prof.dpad_type == HAT_SWITCH) {
+            if (len > prof.byte_x) {
+                uint8_t hat = raw_data[prof.byte_x] & 0x0F;
                 if (hat <= 7) {
                     d_u = (hat == 0 || hat == 1 || hat == 7); d_d = (hat == 3 || hat == 4 || hat == 5);
                     d_l = (hat == 5 || hat == 6 || hat == 7); d_r = (hat == 1 || hat == 2 || hat == 3);
                 }
             }
         }
-        else if (current_profile.dpad_type == EXACT_VALUE) {
-            if (len > current_profile.byte_x) {
-                uint8_t val = raw_data[current_profile.byte_x];
-                d_u = (val == current_profile.val_up); d_d = (val == current_profile.val_down);
-                d_l = (val == current_profile.val_left); d_r = (val == current_profile.val_right);
+        else if (prof.dpad_type == EXACT_VALUE) {
+            if (len > prof.byte_x) {
+                uint8_t val = raw_data[prof.byte_x];
+                d_u = (val == prof.val_up); d_d = (val == prof.val_down);
+                d_l = (val == prof.val_left); d_r = (val == prof.val_right);
             }
         }
-        else if (current_profile.dpad_type == BITMASK) {
-            if (len > current_profile.byte_x) {
-                d_u = (raw_data[current_profile.byte_x] & current_profile.val_up) != 0;
-                d_d = (raw_data[current_profile.byte_x] & current_profile.val_down) != 0;
-                d_l = (raw_data[current_profile.byte_x] & current_profile.val_left) != 0;
-                d_r = (raw_data[current_profile.byte_x] & current_profile.val_right) != 0;
+        else if (prof.dpad_type == BITMASK) {
+            if (len > prof.byte_x) {
+                d_u = (raw_data[prof.byte_x] & prof.val_up) != 0;
+                d_d = (raw_data[prof.byte_x] & prof.val_down) != 0;
+                d_l = (raw_data[prof.byte_x] & prof.val_left) != 0;
+                d_r = (raw_data[prof.byte_x] & prof.val_right) != 0;
             }
         }
 
         // Step 3: MERGE Analog and Digital properly!
+        // (In paddle and stick-mouse modes the stick is analog, so only the D-Pad stays digital)
+        a_u = (a_dirs & JS_UP) != 0;   a_d = (a_dirs & JS_DOWN) != 0;
+        a_l = (a_dirs & JS_LEFT) != 0; a_r = (a_dirs & JS_RIGHT) != 0;
+        if (analog_out) { a_u = false; a_d = false; a_l = false; a_r = false; }
         u = a_u || d_u;
         d = a_d || d_d;
         l = a_l || d_l;
@@ -331,62 +469,136 @@ inline void process_joystick(const uint8_t *raw_data, int len) {
         bool f_auto_on = false;
         bool f_auto_off = false;
 
-        if (current_profile.dpad_type == EXACT_VALUE || current_profile.dpad_type == HAT_SWITCH) {
-            if (current_profile.byte_fire1 != 0 && len > current_profile.byte_fire1)   f1 = (raw_data[current_profile.byte_fire1] == current_profile.val_fire1);
-            if (current_profile.byte_fire2 != 0 && len > current_profile.byte_fire2)   f2 = (raw_data[current_profile.byte_fire2] == current_profile.val_fire2);
-            if (current_profile.byte_fire3 != 0 && len > current_profile.byte_fire3)   f3 = (raw_data[current_profile.byte_fire3] == current_profile.val_fire3);
-            if (current_profile.byte_up_alt != 0 && len > current_profile.byte_up_alt)  f_alt = (raw_data[current_profile.byte_up_alt] == current_profile.val_up_alt);
-            if (current_profile.byte_autofire != 0 && len > current_profile.byte_autofire) f_auto_on = (raw_data[current_profile.byte_autofire] == current_profile.val_autofire);
-            if (current_profile.byte_autofire_off != 0 && len > current_profile.byte_autofire_off) f_auto_off = (raw_data[current_profile.byte_autofire_off] == current_profile.val_autofire_off);
+        if (prof.dpad_type == EXACT_VALUE || prof.dpad_type == HAT_SWITCH) {
+            if (prof.byte_fire1 != 0 && len > prof.byte_fire1)   f1 = (raw_data[prof.byte_fire1] == prof.val_fire1);
+            if (prof.byte_fire2 != 0 && len > prof.byte_fire2)   f2 = (raw_data[prof.byte_fire2] == prof.val_fire2);
+            if (prof.byte_fire3 != 0 && len > prof.byte_fire3)   f3 = (raw_data[prof.byte_fire3] == prof.val_fire3);
+            if (prof.byte_up_alt != 0 && len > prof.byte_up_alt)  f_alt = (raw_data[prof.byte_up_alt] == prof.val_up_alt);
+            if (prof.byte_autofire != 0 && len > prof.byte_autofire) f_auto_on = (raw_data[prof.byte_autofire] == prof.val_autofire);
+            if (prof.byte_autofire_off != 0 && len > prof.byte_autofire_off) f_auto_off = (raw_data[prof.byte_autofire_off] == prof.val_autofire_off);
         } else {
-            if (current_profile.byte_fire1 != 0 && len > current_profile.byte_fire1)   f1 = (raw_data[current_profile.byte_fire1] & current_profile.val_fire1) != 0;
-            if (current_profile.byte_fire2 != 0 && len > current_profile.byte_fire2)   f2 = (raw_data[current_profile.byte_fire2] & current_profile.val_fire2) != 0;
-            if (current_profile.byte_fire3 != 0 && len > current_profile.byte_fire3)   f3 = (raw_data[current_profile.byte_fire3] & current_profile.val_fire3) != 0;
-            if (current_profile.byte_up_alt != 0 && len > current_profile.byte_up_alt)  f_alt = (raw_data[current_profile.byte_up_alt] & current_profile.val_up_alt) != 0;
-            if (current_profile.byte_autofire != 0 && len > current_profile.byte_autofire) f_auto_on = (raw_data[current_profile.byte_autofire] & current_profile.val_autofire) != 0;
-            if (current_profile.byte_autofire_off != 0 && len > current_profile.byte_autofire_off) f_auto_off = (raw_data[current_profile.byte_autofire_off] & current_profile.val_autofire_off) != 0;
+            if (prof.byte_fire1 != 0 && len > prof.byte_fire1)   f1 = (raw_data[prof.byte_fire1] & prof.val_fire1) != 0;
+            if (prof.byte_fire2 != 0 && len > prof.byte_fire2)   f2 = (raw_data[prof.byte_fire2] & prof.val_fire2) != 0;
+            if (prof.byte_fire3 != 0 && len > prof.byte_fire3)   f3 = (raw_data[prof.byte_fire3] & prof.val_fire3) != 0;
+            if (prof.byte_up_alt != 0 && len > prof.byte_up_alt)  f_alt = (raw_data[prof.byte_up_alt] & prof.val_up_alt) != 0;
+            if (prof.byte_autofire != 0 && len > prof.byte_autofire) f_auto_on = (raw_data[prof.byte_autofire] & prof.val_autofire) != 0;
+            if (prof.byte_autofire_off != 0 && len > prof.byte_autofire_off) f_auto_off = (raw_data[prof.byte_autofire_off] & prof.val_autofire_off) != 0;
         }
 
+        // --- Extra buttons (CD32 pad) ---
+        if (pad_bit(raw_data, len, prof.byte_face3, prof.val_face3))           ext |= JS_FACE3;
+        if (pad_bit(raw_data, len, prof.byte_face4, prof.val_face4))           ext |= JS_FACE4;
+        if (pad_bit(raw_data, len, prof.byte_shoulder_l, prof.val_shoulder_l)) ext |= JS_SHOULDER_L;
+        if (pad_bit(raw_data, len, prof.byte_shoulder_r, prof.val_shoulder_r)) ext |= JS_SHOULDER_R;
+        if (pad_bit(raw_data, len, prof.byte_start, prof.val_start))           ext |= JS_START;
+
         // --- SMART NATIVE AUTOFIRE ---
-        static bool native_autofire_latch = false;
-        
-        if (current_profile.byte_autofire != 0 && current_profile.byte_autofire_off != 0) {
-            if (f_auto_on) native_autofire_latch = true;
-            if (f_auto_off) native_autofire_latch = false;
-            auto_btn = native_autofire_latch;
+        if (prof.byte_autofire != 0 && prof.byte_autofire_off != 0) {
+            if (f_auto_on) ds.autofire_latch = true;
+            if (f_auto_off) ds.autofire_latch = false;
+            auto_btn = ds.autofire_latch;
         } 
-        else if (current_profile.byte_autofire != 0) {
+        else if (prof.byte_autofire != 0) {
             auto_btn = f_auto_on; 
-            native_autofire_latch = false;
+            ds.autofire_latch = false;
         }
 
 #if HAS_HTML_CONFIGURATOR
     }
 #endif
 
+    // --- PADDLE / DUTY-CYCLE OUTPUT (table lookup, picked up by the next SID/frame cycle) ---
+    if (paddle_on) paddle_update(pad_x, pad_y, l || r, u || d);
+
+    // --- STICK MOUSE: new velocity, integrated by the fixed-rate timer (StickMouse.h) ---
+    // An open chord centres the pointer, its direction press is a command, not a move.
+    if (stick_mouse_on) {
+        if (ds.chord.phase >= CHORD_OPEN) stick_mouse_update(&ds, 128, 128, false, false, false, false);
+        else stick_mouse_update(&ds, pad_x, pad_y, l, r, u, d);
+    }
+
+    uint16_t word = (u ? JS_UP : 0) | (d ? JS_DOWN : 0) | (l ? JS_LEFT : 0) | (r ? JS_RIGHT : 0)
+                  | (f1 ? JS_FIRE1 : 0) | (f2 ? JS_FIRE2 : 0) | (f3 ? JS_FIRE3 : 0)
+                  | (f_alt ? JS_UP_ALT : 0) | (auto_btn ? JS_AUTO : 0) | ext;
+
     // --- SMART MULTIPORT MERGE (CO-PILOT MODE) ---
-    if (current_profile.use_report_id) {
-        static bool p_u[3], p_d[3], p_l[3], p_r[3], p_f1[3], p_f2[3], p_f3[3], p_alt[3], p_auto[3];
-        uint8_t id = raw_data[0]; 
-
-        if (id == 1 || id == 2) {
-            p_u[id] = u; p_d[id] = d; p_l[id] = l; p_r[id] = r;
-            p_f1[id] = f1; p_f2[id] = f2; p_f3[id] = f3; 
-            p_alt[id] = f_alt; p_auto[id] = auto_btn;
-        }
+    if (prof.use_report_id) {
+        mux_store(ds.mux, raw_data[0], word);
+        word = mux_merge(ds.mux);
+    }
 
-        joy_u = p_u[1] | p_u[2];
-        joy_d = p_d[1] | p_d[2];
-        joy_l = p_l[1] | p_l[2];
-        joy_r = p_r[1] | p_r[2];
-        joy_f1 = p_f1[1] | p_f1[2];
-        joy_f2 = p_f2[1] | p_f2[2];
-        joy_f3 = p_f3[1] | p_f3[2];
-        joy_up_alt = p_alt[1] | p_alt[2];
-        joy_auto = p_auto[1] | p_auto[2];
+    // The routing stage (UsbDevices.h) merges this with the other devices
+    ds.deb.t_ms = millis();
+    ds.word = debounce_word(ds.deb, word);
+}
+
+
+// ==========================================
+// 🎯 PART 3: RELEVANCE MASK
+// ==========================================
+// The report bits process_joystick() reads for a profile. The USB callback drops reports whose
+// masked bits match the last one (UsbDevices.h). Keep this in step with the decoder above: a bit
+// missing here is a button that only works while something else moves.
+
+inline void rel_mark(RelevanceMask &rm, int idx, uint8_t bits) {
+    if (idx < 0 || idx >= 64 || !bits) return;
+    ((uint8_t *)rm.mask)[idx] |= bits; // Same byte order as the report words
+}
 
+inline void build_relevance_mask(const PadConfig &prof, RelevanceMask &rm) {
+    memset(&rm, 0, sizeof(rm));
+#if HAS_HTML_CONFIGURATOR
+    if (use_html_configurator) {
+        for (size_t i = 0; i < JM_JOY_RULES_COUNT; i++) {
+            const JM_Rule &rule = JM_JOY_RULES[i];
+            rel_mark(rm, rule.index, rule.op == JM_BITANY ? rule.value : 0xFF);
+        }
+        #if JM_USE_ANALOG_MOUSE == 1
+        for (size_t i = 0; i < sizeof(JM_MOUSE_X_INDEXES) / sizeof(JM_MOUSE_X_INDEXES[0]); i++) rel_mark(rm, JM_MOUSE_X_INDEXES[i], 0xFF);
+        for (size_t i = 0; i < sizeof(JM_MOUSE_Y_INDEXES) / sizeof(JM_MOUSE_Y_INDEXES[0]); i++) rel_mark(rm, JM_MOUSE_Y_INDEXES[i], 0xFF);
+        #endif
     } else {
-        joy_u = u; joy_d = d; joy_l = l; joy_r = r;
-        joy_f1 = f1; joy_f2 = f2; joy_f3 = f3; joy_up_alt = f_alt; joy_auto = auto_btn;
+#endif
+        if (prof.use_report_id) rel_mark(rm, 0, 0xFF);
+        uint8_t dirs = prof.val_up | prof.val_down | prof.val_left | prof.val_right;
+
+        // Sticks and D-Pad
+        if ((prof.byte_analog_x != 0 || prof.byte_analog_y != 0) && prof.dpad_type != HYBRID_16BIT_BITMASK) {
+            rel_mark(rm, prof.byte_analog_x, 0xFF);
+            rel_mark(rm, prof.byte_analog_y, 0xFF);
+        }
+        if (prof.byte_analog_right_x != 0 || prof.byte_analog_right_y != 0) {
+            rel_mark(rm, prof.byte_analog_right_x, 0xFF);
+            rel_mark(rm, prof.byte_analog_right_y, 0xFF);
+        }
+        switch (prof.dpad_type) {
+            case HYBRID_16BIT_BITMASK:
+                rel_mark(rm, prof.byte_analog_x, 0xFF); rel_mark(rm, prof.byte_analog_x + 1, 0xFF);
+                rel_mark(rm, prof.byte_analog_y, 0xFF); rel_mark(rm, prof.byte_analog_y + 1, 0xFF);
+                rel_mark(rm, prof.byte_x, dirs);
+                break;
+            case AXIS:        rel_mark(rm, prof.byte_x, 0xFF); rel_mark(rm, prof.byte_y, 0xFF); break;
+            case HAT_SWITCH:  rel_mark(rm, prof.byte_x, 0x0F); break;
+            case EXACT_VALUE: rel_mark(rm, prof.byte_x, 0xFF); break;
+            case BITMASK:     rel_mark(rm, prof.byte_x, dirs); break;
+        }
+
+        // Buttons: compared for equality on HAT / EXACT pads, as bit masks otherwise (byte 0 = not mapped)
+        bool exact = (prof.dpad_type == EXACT_VALUE || prof.dpad_type == HAT_SWITCH);
+        const int btn_byte[6] = { prof.byte_fire1, prof.byte_fire2, prof.byte_fire3, prof.byte_up_alt, prof.byte_autofire, prof.byte_autofire_off };
+        const uint8_t btn_val[6] = { prof.val_fire1, prof.val_fire2, prof.val_fire3, prof.val_up_alt, prof.val_autofire, prof.val_autofire_off };
+        for (int i = 0; i < 6; i++) {
+            if (btn_byte[i] != 0) rel_mark(rm, btn_byte[i], exact ? 0xFF : btn_val[i]);
+        }
+        if (prof.byte_face3) rel_mark(rm, prof.byte_face3, prof.val_face3);
+        if (prof.byte_face4) rel_mark(rm, prof.byte_face4, prof.val_face4);
+        if (prof.byte_shoulder_l) rel_mark(rm, prof.byte_shoulder_l, prof.val_shoulder_l);
+        if (prof.byte_shoulder_r) rel_mark(rm, prof.byte_shoulder_r, prof.val_shoulder_r);
+        if (prof.byte_start) rel_mark(rm, prof.byte_start, prof.val_start);
+#if HAS_HTML_CONFIGURATOR
+    }
+#endif
+    for (int i = 15; i >= 0; i--) {
+        if (rm.mask[i]) { rm.words = i + 1; break; }
     }
 }
\ No newline at end of file
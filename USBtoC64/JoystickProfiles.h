@@ -25,6 +25,13 @@
 
 enum DpadType { BITMASK, HAT_SWITCH, AXIS, EXACT_VALUE, HYBRID_16BIT_BITMASK };
 
+// 🎛️ Output personality of the DB9 port for this pad
+// OUT_JOYSTICK = classic 8-way digital joystick (default)
+// OUT_PADDLE   = analog stick drives C64 paddles (POT X/Y) or Amiga duty-cycle joystick (digital lines)
+// OUT_CD32     = Amiga CD32 seven-button pad (shift register on pins 5/6/9), plain joystick on C64
+// OUT_MOUSE    = analog stick moves a C64 1351 / Amiga mouse pointer, Fire 1/2/3 are its buttons
+enum OutputMode { OUT_JOYSTICK, OUT_PADDLE, OUT_CD32, OUT_MOUSE };
+
 struct PadConfig {
     const char* name;
     uint16_t vid;
@@ -64,6 +71,26 @@ struct PadConfig {
     uint32_t color_fire3;
     uint32_t color_up_alt;
     uint32_t color_autofire;
+
+    OutputMode output_mode;
+
+    // Extra buttons (CD32 Green / Yellow / Rewind / Forward / Play)
+    // Always tested as bit masks, 0 = not mapped
+    int byte_face3;
+    int byte_face4;
+    int byte_shoulder_l;
+    int byte_shoulder_r;
+    int byte_start;
+
+    uint8_t val_face3;
+    uint8_t val_face4;
+    uint8_t val_shoulder_l;
+    uint8_t val_shoulder_r;
+    uint8_t val_start;
+
+    // HID report descriptor fingerprint ('usb' prints it), 0 = match by VID:PID only.
+    // Set it when clones share a VID:PID but not the report layout.
+    uint32_t fingerprint;
 };
 
 // --- INTERNAL CONTROLLER PROFILES ---
@@ -136,7 +163,11 @@ const PadConfig PROFILES[] = {
         .byte_fire1 = 5, .byte_fire2 = 5, .byte_fire3 = 5, .byte_up_alt = 5, .byte_autofire = 6, .byte_autofire_off = 6,
         .val_up = 0, .val_down = 4, .val_left = 6, .val_right = 2,
         .val_fire1 = 40, .val_fire2 = 24, .val_fire3 = 136, .val_up_alt = 72, .val_autofire = 1, .val_autofire_off = 2,
-        .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW
+        .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW,
+        .output_mode = OUT_JOYSTICK,
+        // CD32: Circle = Green, Triangle = Yellow, L1/R1 = Rewind/Forward, Options = Play
+        .byte_face3 = 5, .byte_face4 = 5, .byte_shoulder_l = 6, .byte_shoulder_r = 6, .byte_start = 6,
+        .val_face3 = 0x40, .val_face4 = 0x80, .val_shoulder_l = 0x01, .val_shoulder_r = 0x02, .val_start = 0x20
     },
     {
         .name = "China Arcade PS3 PC",
@@ -185,7 +216,12 @@ const PadConfig PROFILES[] = {
         // Autofire ON = L (4), Autofire OFF = R (8)
         .val_fire1 = 64, .val_fire2 = 128, .val_fire3 = 0, .val_up_alt = 32, .val_autofire = 4, .val_autofire_off = 8,
         
-        .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW
+        .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW,
+        .output_mode = OUT_JOYSTICK,
+
+        // CD32: A = Green, L/R = Rewind/Forward
+        .byte_face3 = 5, .byte_face4 = 0, .byte_shoulder_l = 6, .byte_shoulder_r = 6, .byte_start = 0,
+        .val_face3 = 32, .val_face4 = 0, .val_shoulder_l = 4, .val_shoulder_r = 8, .val_start = 0
     }
 };
 
@@ -0,0 +1,282 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: KeyboardEngine.h
+// Description: USB Keyboard as Joystick (Boot, N-Key Rollover bitmap and array reports, laid out by the report descriptor)
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "Globals.h"
+#include "Hardware.h"
+
+// ==========================================
+// ⌨️ PART 1: KEY MAP (EDIT HERE)
+// ==========================================
+// HID usage ID -> logical joystick bits (JS_* in Globals.h). A key may set several bits (diagonals).
+// Modifiers use their usage IDs too: 0xE0 L-Ctrl, 0xE1 L-Shift, 0xE2 L-Alt, 0xE4 R-Ctrl, 0xE5 R-Shift.
+
+struct KeyBinding {
+    uint8_t usage;
+    uint16_t bits;
+};
+
+const KeyBinding KEYBOARD_MAP[] = {
+    // Cursor keys
+    { 0x52, JS_UP }, { 0x51, JS_DOWN }, { 0x50, JS_LEFT }, { 0x4F, JS_RIGHT },
+    // W / S / A / D
+    { 0x1A, JS_UP }, { 0x16, JS_DOWN }, { 0x04, JS_LEFT }, { 0x07, JS_RIGHT },
+    // Numpad 8 / 2 / 4 / 6 and diagonals 7 / 9 / 1 / 3
+    { 0x60, JS_UP }, { 0x5A, JS_DOWN }, { 0x5C, JS_LEFT }, { 0x5E, JS_RIGHT },
+    { 0x5F, JS_UP | JS_LEFT },   { 0x61, JS_UP | JS_RIGHT },
+    { 0x59, JS_DOWN | JS_LEFT }, { 0x5B, JS_DOWN | JS_RIGHT },
+    // Fire 1: Space, L-Ctrl, R-Ctrl, Numpad 0
+    { 0x2C, JS_FIRE1 }, { 0xE0, JS_FIRE1 }, { 0xE4, JS_FIRE1 }, { 0x62, JS_FIRE1 },
+    // Fire 2: L-Alt, X, Numpad 5
+    { 0xE2, JS_FIRE2 }, { 0x1B, JS_FIRE2 }, { 0x5D, JS_FIRE2 },
+    // Fire 3: L-Shift, C
+    { 0xE1, JS_FIRE3 }, { 0x06, JS_FIRE3 },
+    // Alt Up: R-Shift / Autofire (hold): Tab
+    { 0xE5, JS_UP_ALT }, { 0x2B, JS_AUTO },
+    // CD32 extras: Z = Green, V = Yellow, Q = Rewind, E = Forward, Enter = Play
+    { 0x1D, JS_FACE3 }, { 0x19, JS_FACE4 }, { 0x14, JS_SHOULDER_L }, { 0x08, JS_SHOULDER_R }, { 0x28, JS_START }
+};
+
+const int NUM_KEY_BINDINGS = sizeof(KEYBOARD_MAP) / sizeof(KeyBinding);
+
+// LED colors / name used while a keyboard drives the port
+const PadConfig KEYBOARD_PROFILE = {
+    .name = "USB KEYBOARD",
+    .color_fire1 = C_GREEN,
+    .color_fire2 = C_RED,
+    .color_fire3 = C_CYAN,
+    .color_up_alt = C_BLUE,
+    .color_autofire = C_YELLOW,
+    .output_mode = OUT_JOYSTICK
+};
+
+// Boot protocol report: [modifiers][reserved][6 x usage]. Any other layout (NKRO bitmaps, report
+// IDs, wider arrays) is read from the interface's report descriptor at enumeration.
+#define KBD_USAGE_ROLLOVER    0x01 // ErrorRollOver: too many keys, report carries no state
+#define KBD_NUM_FUNCS         14   // JS_UP .. JS_START
+#define KBD_MAX_FIELDS        6    // Input items with keyboard usages kept per interface
+
+// One Input item carrying keyboard usages. Bit offsets start after the report ID byte.
+struct KbdField {
+    uint8_t  id;           // Report ID (0 = the interface uses none)
+    bool     is_array;     // Array: each entry holds a usage. Variable: one bit per usage
+    uint8_t  size;         // Bits per entry (a bitmap has 1)
+    uint8_t  count;        // Entries
+    uint16_t bit;          // First bit of the item in the report
+    uint16_t usage_min;    // Usage of bit 0 (bitmap) / of value logical_min (array)
+    int16_t  logical_min;  // Array only
+};
+
+// Where the key reports sit. A boot-protocol interface (hid_host engine, or a raw keyboard whose
+// descriptor could not be read and was switched to boot) never prepends an ID.
+struct KbdLayout {
+    bool has_ids;          // Every report starts with its report ID
+    uint32_t key_ids;      // Bit n: report ID n carries keyboard usages (IDs 1-31)
+    uint8_t num_fields;    // 0 = no keyboard field found in the descriptor
+    KbdField fields[KBD_MAX_FIELDS];
+};
+
+const KbdLayout KBD_LAYOUT_BOOT = { false, 0, 2, {
+    { 0, false, 1, 8, 0,  0xE0, 0 },   // Modifiers: usages 0xE0-0xE7
+    { 0, true,  8, 6, 16, 0x00, 0 },   // 6 key slots after the reserved byte
+} };
+
+// Short items: [tag/type/size][0, 1, 2 or 4 data bytes]
+#define HID_ITEM_USAGE_PAGE   0x04
+#define HID_ITEM_LOGICAL_MIN  0x14
+#define HID_ITEM_REPORT_SIZE  0x74
+#define HID_ITEM_REPORT_ID    0x84
+#define HID_ITEM_REPORT_COUNT 0x94
+#define HID_ITEM_USAGE        0x08
+#define HID_ITEM_USAGE_MIN    0x18
+#define HID_ITEM_INPUT        0x80
+#define HID_ITEM_OUTPUT       0x90
+#define HID_ITEM_FEATURE      0xB0
+#define HID_ITEM_COLLECTION   0xA0
+#define HID_ITEM_END_COLL     0xC0
+#define HID_ITEM_LONG         0xFE
+#define HID_INPUT_CONSTANT    0x01
+#define HID_INPUT_VARIABLE    0x02
+#define HID_PAGE_KEYBOARD     0x07
+
+inline KbdLayout kbd_scan_report_descriptor(const uint8_t *d, int n) {
+    KbdLayout lay = {};
+    uint32_t page = 0, usage_page = 0;
+    uint16_t usage_min = 0, pos[32] = {0}; // Input bit position per report ID
+    bool have_usage = false;
+    int32_t logical_min = 0;
+    uint8_t id = 0, size = 0, count = 0;
+    int i = 0;
+    while (i < n) {
+        uint8_t b = d[i];
+        if (b == HID_ITEM_LONG) { // [FE][size][tag][data...]
+            if (i + 1 >= n) break;
+            i += 3 + d[i + 1];
+            continue;
+        }
+        int sz = b & 0x03;
+        if (sz == 3) sz = 4;
+        if (i + 1 + sz > n) break;
+        uint32_t v = 0;
+        for (int k = 0; k < sz; k++) v |= (uint32_t)d[i + 1 + k] << (8 * k);
+
+        switch (b & 0xFC) {
+            case HID_ITEM_USAGE_PAGE:   page = v; break;
+            case HID_ITEM_LOGICAL_MIN:  logical_min = (sz == 1) ? (int8_t)v : (sz == 2) ? (int16_t)v : (int32_t)v; break;
+            case HID_ITEM_REPORT_SIZE:  size = (uint8_t)v; break;
+            case HID_ITEM_REPORT_ID:    id = (uint8_t)v; lay.has_ids = true; break;
+            case HID_ITEM_REPORT_COUNT: count = (uint8_t)v; break;
+            case HID_ITEM_USAGE:
+            case HID_ITEM_USAGE_MIN:
+                // The first usage (or the range start) names entry 0. A 4-byte usage carries its page.
+                if (!have_usage || (b & 0xFC) == HID_ITEM_USAGE_MIN) {
+                    usage_page = (sz == 4) ? (v >> 16) : page;
+                    usage_min = (uint16_t)v;
+                    have_usage = true;
+                }
+                break;
+            case HID_ITEM_INPUT: {
+                uint16_t &p = pos[id < 32 ? id : 0];
+                bool keys = !(v & HID_INPUT_CONSTANT) && have_usage && usage_page == HID_PAGE_KEYBOARD
+                         && id < 32 && count && size && size <= 16 && ((v & HID_INPUT_VARIABLE) == 0 || size == 1);
+                if (keys && lay.num_fields < KBD_MAX_FIELDS) {
+                    KbdField &f = lay.fields[lay.num_fields++];
+                    f.id = id;
+                    f.is_array = !(v & HID_INPUT_VARIABLE);
+                    f.size = size;
+                    f.count = count;
+                    f.bit = p;
+                    f.usage_min = usage_min;
+                    f.logical_min = (int16_t)logical_min;
+                    if (id) lay.key_ids |= (1UL << id);
+                }
+                p += size * count;
+            }
+            // A main item ends the local usages
+            /* fall through */
+            case HID_ITEM_OUTPUT:
+            case HID_ITEM_FEATURE:
+            case HID_ITEM_COLLECTION:
+            case HID_ITEM_END_COLL:
+                have_usage = false;
+                break;
+        }
+        i += 1 + sz;
+    }
+    return lay;
+}
+
+
+// ==========================================
+// 🧮 PART 2: KEY BITMAP AND FUNCTION MASKS
+// ==========================================
+// Keys live in a 256-bit bitmap (one bit per HID usage, modifiers at 0xE0-0xE7).
+// The map is compiled once into one 256-bit mask per joystick function, so decoding a
+// report is 8 word ANDs/ORs per function, whatever the number of keys held down.
+
+static uint32_t kbd_keys[8];
+static uint32_t kbd_func_mask[KBD_NUM_FUNCS][8];
+static uint8_t  kbd_active_funcs[KBD_NUM_FUNCS];
+static int      kbd_num_active = 0;
+
+inline void build_keyboard_masks() {
+    memset(kbd_func_mask, 0, sizeof(kbd_func_mask));
+    for (int i = 0; i < NUM_KEY_BINDINGS; i++) {
+        uint8_t u = KEYBOARD_MAP[i].usage;
+        for (int f = 0; f < KBD_NUM_FUNCS; f++) {
+            if (KEYBOARD_MAP[i].bits & (1 << f)) kbd_func_mask[f][u >> 5] |= (1UL << (u & 31));
+        }
+    }
+
+    // Only functions with at least one key are visited at runtime
+    kbd_num_active = 0;
+    for (int f = 0; f < KBD_NUM_FUNCS; f++) {
+        uint32_t any = 0;
+        for (int w = 0; w < 8; w++) any |= kbd_func_mask[f][w];
+        if (any) kbd_active_funcs[kbd_num_active++] = f;
+    }
+}
+
+// 'size' bits at bit offset 'bit', LSB first (HID order)
+inline uint32_t kbd_field_bits(const uint8_t *r, int bit, int size) {
+    if (size == 8 && !(bit & 7)) return r[bit >> 3];
+    uint32_t v = 0;
+    for (int k = 0; k < size; k++) {
+        if (r[(bit + k) >> 3] & (1 << ((bit + k) & 7))) v |= (1UL << k);
+    }
+    return v;
+}
+
+// Fills the bitmap from a report. Returns false when the report must be ignored (keep last state).
+inline bool kbd_parse_report(const KbdLayout &lay, const uint8_t *data, int len, uint32_t *keys) {
+    memset(keys, 0, 8 * sizeof(uint32_t));
+
+    uint8_t id = 0;
+    if (lay.has_ids) {
+        // Only the IDs that carry key usages (media keys / system control share the endpoint)
+        if (len < 1 || data[0] >= 32 || !(lay.key_ids & (1UL << data[0]))) return false;
+        id = data[0];
+        data++;
+        len--;
+    }
+
+    uint8_t *kb = (uint8_t *)keys; // Byte k holds usages 8k..8k+7 (ESP32 is little-endian)
+    for (int i = 0; i < lay.num_fields; i++) {
+        const KbdField &f = lay.fields[i];
+        if (f.id != id || f.bit + f.size * f.count > len * 8) continue;
+        if (!f.is_array) {
+            if (!(f.bit & 7) && !(f.usage_min & 7)) {
+                // Byte-aligned bitmap (NKRO, boot modifiers): already our layout
+                int n = (f.count + 7) / 8;
+                if ((f.usage_min >> 3) + n > 32) n = 32 - (f.usage_min >> 3);
+                for (int k = 0; k < n; k++) {
+                    uint8_t m = (k * 8 + 8 <= f.count) ? 0xFF : (uint8_t)((1 << (f.count & 7)) - 1);
+                    kb[(f.usage_min >> 3) + k] |= data[(f.bit >> 3) + k] & m;
+                }
+            } else {
+                for (int k = 0; k < f.count && f.usage_min + k < 256; k++) {
+                    if (kbd_field_bits(data, f.bit + k, 1)) keys[(f.usage_min + k) >> 5] |= (1UL << ((f.usage_min + k) & 31));
+                }
+            }
+        } else {
+            for (int k = 0; k < f.count; k++) {
+                int v = (int)kbd_field_bits(data, f.bit + k * f.size, f.size) - f.logical_min;
+                if (v < 0) continue;
+                int u = f.usage_min + v;
+                if (u == KBD_USAGE_ROLLOVER) return false;
+                if (u < 256) keys[u >> 5] |= (1UL << (u & 31));
+            }
+        }
+    }
+    if (keys[0] & (1UL << KBD_USAGE_ROLLOVER)) return false;
+    keys[0] &= ~0x0FUL; // Usages 0-3 are error codes, not keys
+    return true;
+}
+
+inline uint16_t kbd_decode(const uint32_t *keys) {
+    uint16_t state = 0;
+    for (int i = 0; i < kbd_num_active; i++) {
+        uint8_t f = kbd_active_funcs[i];
+        const uint32_t *m = kbd_func_mask[f];
+        uint32_t hit = (keys[0] & m[0]) | (keys[1] & m[1]) | (keys[2] & m[2]) | (keys[3] & m[3])
+                     | (keys[4] & m[4]) | (keys[5] & m[5]) | (keys[6] & m[6]) | (keys[7] & m[7]);
+        if (hit) state |= (1 << f);
+    }
+    return state;
+}
+
+
+// ==========================================
+// 🕹️ PART 3: KEYBOARD PROCESSING ENGINE
+// ==========================================
+
+inline void process_keyboard(DevState &ds, const KbdLayout &lay, const uint8_t *raw_data, int len) {
+    if (current_mode != MODE_PLAY && current_mode != MODE_DEBUG && current_mode != MODE_GPIO) return;
+    if (!kbd_parse_report(lay, raw_data, len, kbd_keys)) return;
+
+    ds.word = kbd_decode(kbd_keys);
+}
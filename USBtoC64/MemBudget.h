@@ -0,0 +1,141 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: MemBudget.h
+// Description: Static task/queue allocation, per-subsystem memory budget and heap seal ('mem')
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "Globals.h"
+
+// ==========================================
+// 📦 PART 1: STATIC OR HEAP OBJECTS
+// ==========================================
+// With STATIC_ALLOC_BUILD every task stack, TCB and queue we create lives in .bss: the storage
+// is declared next to its owner with MEM_TASK_STORAGE / MEM_QUEUE_STORAGE and handed over with
+// MEM_TASK_ARGS / MEM_QUEUE_ARGS. Without it the same calls fall back to the heap.
+
+#if STATIC_ALLOC_BUILD
+  #define MEM_TASK_STORAGE(id, bytes)        static StackType_t id##_stack[(bytes) / sizeof(StackType_t)]; static StaticTask_t id##_tcb
+  #define MEM_TASK_ARGS(id)                  id##_stack, &id##_tcb
+  #define MEM_QUEUE_STORAGE(id, len, type)   static uint8_t id##_storage[(len) * sizeof(type)]; static StaticQueue_t id##_qcb
+  #define MEM_QUEUE_ARGS(id)                 id##_storage, &id##_qcb
+#else
+  #define MEM_TASK_STORAGE(id, bytes)
+  #define MEM_TASK_ARGS(id)                  nullptr, nullptr
+  #define MEM_QUEUE_STORAGE(id, len, type)
+  #define MEM_QUEUE_ARGS(id)                 nullptr, nullptr
+#endif
+
+enum MemWhere : uint8_t { MEM_STATIC, MEM_HEAP_SETUP };
+
+struct MemEntry {
+    const char *subsystem;
+    const char *item;
+    uint32_t bytes;
+    MemWhere where;
+};
+
+#define MEM_MAX_ENTRIES 24
+
+static MemEntry mem_entries[MEM_MAX_ENTRIES];
+static int mem_num_entries = 0;
+
+inline void mem_budget_add(const char *subsystem, const char *item, uint32_t bytes, MemWhere where) {
+    if (mem_num_entries >= MEM_MAX_ENTRIES) return;
+    mem_entries[mem_num_entries++] = { subsystem, item, bytes, where };
+}
+
+inline TaskHandle_t mem_task(TaskFunction_t fn, const char *name, uint32_t stack_bytes, UBaseType_t prio, BaseType_t core,
+                             const char *subsystem, StackType_t *stack, StaticTask_t *tcb) {
+    TaskHandle_t h = nullptr;
+    if (stack && tcb) {
+        h = xTaskCreateStaticPinnedToCore(fn, name, stack_bytes / sizeof(StackType_t), nullptr, prio, stack, tcb, core);
+        mem_budget_add(subsystem, name, stack_bytes + sizeof(StaticTask_t), MEM_STATIC);
+    } else {
+        xTaskCreatePinnedToCore(fn, name, stack_bytes, nullptr, prio, &h, core);
+        mem_budget_add(subsystem, name, stack_bytes + sizeof(StaticTask_t), MEM_HEAP_SETUP);
+    }
+    return h;
+}
+
+inline QueueHandle_t mem_queue(const char *subsystem, const char *item, UBaseType_t len, UBaseType_t item_size,
+                               uint8_t *storage, StaticQueue_t *qcb) {
+    if (storage && qcb) {
+        mem_budget_add(subsystem, item, len * item_size + sizeof(StaticQueue_t), MEM_STATIC);
+        return xQueueCreateStatic(len, item_size, storage, qcb);
+    }
+    mem_budget_add(subsystem, item, len * item_size + sizeof(StaticQueue_t), MEM_HEAP_SETUP);
+    return xQueueCreate(len, item_size);
+}
+
+
+// ==========================================
+// 🔒 PART 2: HEAP SEAL
+// ==========================================
+// The end of setup() takes a snapshot of the heap. From there on our own code allocates nothing:
+// 'mem' compares the live block count and bytes with that snapshot. What still moves comes from
+// outside the firmware (USB host stack on enumeration, Arduino printf above 64 characters,
+// Preferences writes) and returns to zero once the bus is empty and the CLI is quiet. The one
+// lasting exception is the inject timer, created by the first 'inject'.
+
+static multi_heap_info_t mem_seal_info;
+static bool mem_sealed = false;
+
+inline void mem_print_budget() {
+    uint32_t total_static = 0, total_heap = 0;
+    Serial2.println(">> MEMORY BUDGET <<");
+    Serial2.println(" SUBSYSTEM  ITEM                 BYTES  WHERE");
+    for (int i = 0; i < mem_num_entries; i++) {
+        const MemEntry &e = mem_entries[i];
+        Serial2.printf(" %-9s  %-18s %7lu  %s\n", e.subsystem, e.item, (unsigned long)e.bytes,
+                       e.where == MEM_STATIC ? "static" : "heap (setup)");
+        if (e.where == MEM_STATIC) total_static += e.bytes;
+        else total_heap += e.bytes;
+    }
+    // Per subsystem: first occurrence of each name sums all its entries
+    Serial2.print(" Per subsystem:");
+    for (int i = 0; i < mem_num_entries; i++) {
+        bool seen = false;
+        for (int j = 0; j < i; j++) if (strcmp(mem_entries[j].subsystem, mem_entries[i].subsystem) == 0) seen = true;
+        if (seen) continue;
+        uint32_t sum = 0;
+        for (int j = i; j < mem_num_entries; j++) {
+            if (strcmp(mem_entries[j].subsystem, mem_entries[i].subsystem) == 0) sum += mem_entries[j].bytes;
+        }
+        Serial2.printf(" %s %lu", mem_entries[i].subsystem, (unsigned long)sum);
+    }
+    Serial2.printf("\n Total: %lu B static, %lu B heap during setup\n", (unsigned long)total_static, (unsigned long)total_heap);
+}
+
+// Called once, at the very end of setup()
+inline void mem_seal() {
+    heap_caps_get_info(&mem_seal_info, MALLOC_CAP_8BIT);
+    mem_sealed = true;
+    mem_print_budget();
+    Serial2.printf(" Heap after setup: %lu B free, %lu B in %lu blocks\n", (unsigned long)mem_seal_info.total_free_bytes,
+                   (unsigned long)mem_seal_info.total_allocated_bytes, (unsigned long)mem_seal_info.allocated_blocks);
+}
+
+inline void run_mem_report() {
+    multi_heap_info_t now;
+    heap_caps_get_info(&now, MALLOC_CAP_8BIT);
+    Serial2.println("\n==========================================");
+    Serial2.printf("   MEMORY (%s)\n", STATIC_ALLOC_BUILD ? "STATIC_ALLOC_BUILD" : "heap build");
+    Serial2.println("==========================================");
+    mem_print_budget();
+    Serial2.println("------------------------------------------");
+    Serial2.printf(" Heap free     : %lu B (largest block %lu B)\n", (unsigned long)now.total_free_bytes, (unsigned long)now.largest_free_block);
+    Serial2.printf(" Heap low mark : %lu B since boot\n", (unsigned long)now.minimum_free_bytes);
+    if (mem_sealed) {
+        long d_blocks = (long)now.allocated_blocks - (long)mem_seal_info.allocated_blocks;
+        long d_bytes = (long)now.total_allocated_bytes - (long)mem_seal_info.total_allocated_bytes;
+        Serial2.printf(" Since setup   : %+ld blocks, %+ld B %s\n", d_blocks, d_bytes,
+                       (d_blocks == 0 && d_bytes == 0) ? "✅ heap untouched" : "(USB host stack / core)");
+    }
+    Serial2.println("==========================================\n");
+}
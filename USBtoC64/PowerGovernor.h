@@ -0,0 +1,192 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: PowerGovernor.h
+// Description: Latency-aware power governor (esp_pm locks, light sleep, 'power' benchmark)
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "Globals.h"
+#include "UsbDevices.h"
+
+// ==========================================
+// 🔋 PART 1: GOVERNOR STATE
+// ==========================================
+// Two esp_pm locks replace the old fixed 80/240 MHz switch:
+//   pm_cpu_lock   (CPU_FREQ_MAX)   held while reports keep changing, released POWER_HOLD_MS later
+//   pm_awake_lock (NO_LIGHT_SLEEP) held while a device is on the bus: the USB host must send a
+//                                  frame every millisecond, so light sleep is only for an empty bus
+// A pad streaming the same report over and over does not count as activity.
+
+static bool pm_ok = false;              // esp_pm accepted the configuration
+static bool pm_light_sleep = false;     // ...with automatic light sleep
+static esp_pm_lock_handle_t pm_cpu_lock = nullptr;
+static esp_pm_lock_handle_t pm_awake_lock = nullptr;
+static bool pm_cpu_held = false;
+static bool pm_awake_held = false;
+static uint32_t pm_last_activity_ms = 0;
+static uint32_t pm_last_report_hash[USB_MAX_DEVICES];
+
+// 'power' benchmark window, filled by the loop
+struct PowerStats {
+    uint32_t start_us;
+    uint32_t busy_us;      // Loop time spent working (not waiting on the queue)
+    uint32_t fast_us;      // Time with the CPU lock held
+    uint32_t reports;
+    uint32_t lat_sum_us;   // Report arrival -> pins written
+    uint32_t lat_max_us;
+    uint32_t lat_n;
+};
+static PowerStats pm_stats;
+static volatile bool pm_bench_active = false;
+static uint32_t pm_fast_since_us = 0;
+
+inline void pm_set_cpu_lock(bool on) {
+    if (on == pm_cpu_held) return;
+    uint32_t now = micros();
+    if (on) {
+        if (pm_ok) esp_pm_lock_acquire(pm_cpu_lock);
+        pm_fast_since_us = now;
+    } else {
+        if (pm_ok) esp_pm_lock_release(pm_cpu_lock);
+        if (pm_bench_active) pm_stats.fast_us += now - pm_fast_since_us;
+    }
+    pm_cpu_held = on;
+}
+
+inline void pm_set_awake_lock(bool on) {
+    if (on == pm_awake_held || !pm_ok) return;
+    if (on) esp_pm_lock_acquire(pm_awake_lock);
+    else    esp_pm_lock_release(pm_awake_lock);
+    pm_awake_held = on;
+}
+
+
+// ==========================================
+// ⚙️ PART 2: SETUP AND LOOP HOOKS
+// ==========================================
+
+inline void power_init() {
+#if POWER_GOVERNOR
+    esp_pm_config_t cfg = { .max_freq_mhz = POWER_MAX_MHZ, .min_freq_mhz = POWER_MIN_MHZ, .light_sleep_enable = (bool)POWER_LIGHT_SLEEP };
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK && cfg.light_sleep_enable) {
+        // Core built without tickless idle: keep frequency scaling only
+        cfg.light_sleep_enable = false;
+        err = esp_pm_configure(&cfg);
+    }
+    if (err == ESP_OK
+        && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "usb_reports", &pm_cpu_lock) == ESP_OK
+        && esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "usb_bus", &pm_awake_lock) == ESP_OK) {
+        pm_ok = true;
+        pm_light_sleep = cfg.light_sleep_enable;
+        if (pm_light_sleep) {
+            // A start bit on the CLI wakes the chip (the first character may be lost)
+            gpio_wakeup_enable((gpio_num_t)GP_RX, GPIO_INTR_LOW_LEVEL);
+            esp_sleep_enable_gpio_wakeup();
+        }
+    }
+#endif
+    Serial2.printf(">> POWER: %s <<\n", !pm_ok ? "FIXED CLOCK" : pm_light_sleep ? "GOVERNOR + LIGHT SLEEP" : "GOVERNOR");
+}
+
+// Called for every dequeued report, before it is decoded
+inline void power_on_report(const pkt_t &p) {
+    if (pm_bench_active) pm_stats.reports++;
+
+    // Mice only report when they move: every report is activity. Others must change.
+    bool active = (p.src == PKT_SRC_MOUSE);
+    if (!active) {
+        uint8_t i = p.slot % USB_MAX_DEVICES;
+        uint32_t h = fnv1a(FNV_OFFSET_BASIS, p.data, p.len > 64 ? 64 : p.len);
+        active = (h != pm_last_report_hash[i]);
+        pm_last_report_hash[i] = h;
+    }
+    if (active) {
+        pm_last_activity_ms = millis();
+        if (pm_ok) pm_set_cpu_lock(true);
+    }
+}
+
+// Called once per loop pass, after the pins were written. t_first_us = arrival of the oldest
+// report handled in this pass, busy_us = time the pass spent working.
+inline void power_update(bool had_reports, uint32_t t_first_us, uint32_t busy_us) {
+    if (pm_bench_active) {
+        pm_stats.busy_us += busy_us;
+        if (had_reports) {
+            uint32_t lat = micros() - t_first_us;
+            pm_stats.lat_sum_us += lat;
+            pm_stats.lat_n++;
+            if (lat > pm_stats.lat_max_us) pm_stats.lat_max_us = lat;
+        }
+    }
+
+    if (!pm_ok) {
+        // Fixed clocks (no power management in this core)
+        static bool last_mouse_state = false;
+        static bool first_run_clock = true;
+        if (is_mouse_connected != last_mouse_state || first_run_clock) {
+            setCpuFrequencyMhz(is_mouse_connected ? POWER_MAX_MHZ : POWER_MIN_MHZ);
+            last_mouse_state = is_mouse_connected;
+            first_run_clock = false;
+        }
+        return;
+    }
+
+    bool recent = (millis() - pm_last_activity_ms < POWER_HOLD_MS);
+    pm_set_cpu_lock(power_force_max || recent);
+
+    bool bus_busy = device_connected || is_mouse_connected || is_keyboard_connected;
+    bool cli_busy = (current_mode != MODE_PLAY) || (millis() - power_serial_ms < POWER_SERIAL_AWAKE_MS);
+    pm_set_awake_lock(bus_busy || cli_busy || power_force_max);
+}
+
+// How long the loop may sleep on the packet queue
+inline TickType_t power_loop_wait() {
+    bool bus_busy = device_connected || is_mouse_connected || is_keyboard_connected;
+    if (current_mode == MODE_GPIO || current_mode == MODE_POLLING) return pdMS_TO_TICKS(LOOP_WAIT_MS);
+    return pdMS_TO_TICKS(bus_busy ? LOOP_WAIT_MS : LOOP_IDLE_WAIT_MS);
+}
+
+
+// ==========================================
+// 📊 PART 3: 'power' BENCHMARK
+// ==========================================
+// Runs on the service task while the loop keeps playing. Idle % and time at full speed are
+// the current proxies, report -> pin time is the latency the governor costs.
+
+void run_power_benchmark(uint32_t ms) {
+    memset(&pm_stats, 0, sizeof(pm_stats));
+    pm_stats.start_us = micros();
+    if (pm_cpu_held) pm_fast_since_us = pm_stats.start_us;
+    pm_bench_active = true;
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    if (pm_cpu_held) pm_stats.fast_us += micros() - pm_fast_since_us;
+    pm_bench_active = false;
+
+    uint32_t total = micros() - pm_stats.start_us;
+    float idle = 100.0f - (100.0f * pm_stats.busy_us / total);
+    float fast = 100.0f * pm_stats.fast_us / total;
+
+    Serial2.println("\n=======================================");
+    Serial2.println(" 🔋 POWER BENCHMARK RESULTS ");
+    Serial2.println("=======================================");
+    Serial2.printf(" Governor      : %s%s\n", !pm_ok ? "FIXED CLOCK" : pm_light_sleep ? "ESP_PM + LIGHT SLEEP" : "ESP_PM",
+                   power_force_max ? " (forced MAX)" : "");
+    Serial2.printf(" CPU now       : %lu MHz\n", (unsigned long)getCpuFrequencyMhz());
+    Serial2.printf(" Locks         : CPU_MAX %s | NO_SLEEP %s\n", pm_cpu_held ? "HELD" : "free", pm_awake_held ? "HELD" : "free");
+    Serial2.println("---------------------------------------");
+    Serial2.printf(" Loop idle     : %.1f %%\n", idle);
+    Serial2.printf(" Full speed    : %.1f %% of the time\n", pm_ok ? fast : (is_mouse_connected ? 100.0f : 0.0f));
+    Serial2.printf(" Reports       : %lu (%.0f Hz)\n", (unsigned long)pm_stats.reports, pm_stats.reports * 1000000.0f / total);
+    if (pm_stats.lat_n) {
+        Serial2.printf(" Report -> pin : avg %lu us | max %lu us\n",
+                       (unsigned long)(pm_stats.lat_sum_us / pm_stats.lat_n), (unsigned long)pm_stats.lat_max_us);
+    } else {
+        Serial2.println(" Report -> pin : no reports (move the controller during the test)");
+    }
+    Serial2.println("=======================================\n");
+}
@@ -0,0 +1,210 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: Profiler.h
+// Description: Per-task CPU load, stack high-water marks and ISR cycle counters ('top')
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "Globals.h"
+
+// ==========================================
+// ⚡ PART 1: ISR PROBES
+// ==========================================
+// Each ISR opens an IsrProbe: entry count, cycles and microseconds spent are added to its slot of
+// the core it ran on. Counters are 32-bit (single stores, never torn): 'top' works on the difference
+// between two refreshes, so a wrap of the cycle counter is harmless as long as the refresh is < 17 s.
+// The governor moves the clock between 80 and 240 MHz, so cycles only say how much work an ISR
+// does; its share of the CPU comes from the esp_timer time, whatever the clock was at the time.
+// A single ISR is shorter than 1 us, but the rounding of the two timestamps evens out over the
+// thousands of entries of a refresh.
+// Only our callback is timed: the timer driver's own dispatch before and after it is not.
+
+enum IsrId {
+    ISR_POT_SYNC,    // handleInterrupt: SID POT cycle start (C64 mouse / paddles)
+    ISR_POTX_ON, ISR_POTX_OFF, ISR_POTY_ON, ISR_POTY_OFF,
+    ISR_JOYX_OFF, ISR_JOYY_OFF,
+    ISR_DUTY_FRAME,  // Amiga duty-cycle joystick frame clock
+    ISR_CD32_MODE, ISR_CD32_CLOCK,
+    ISR_INJECT,      // Serial inject timer
+    ISR_SWITCH,      // C64/Amiga switch
+    ISR_COUNT
+};
+
+static const char *const ISR_NAMES[ISR_COUNT] = {
+    "pot_sync", "potx_on", "potx_off", "poty_on", "poty_off", "joyx_off", "joyy_off",
+    "duty_frame", "cd32_mode", "cd32_clock", "inject", "switch_mj"
+};
+
+struct IsrStat {
+    uint32_t count;
+    uint32_t cycles;
+    uint32_t us;
+};
+
+static IsrStat isr_stats[2][ISR_COUNT]; // [core][isr]
+
+#if ISR_PROFILE
+struct IsrProbe {
+    uint8_t id;
+    uint32_t t0;
+    uint32_t t0_us;
+    inline __attribute__((always_inline)) IsrProbe(uint8_t isr)
+        : id(isr), t0(esp_cpu_get_cycle_count()), t0_us((uint32_t)esp_timer_get_time()) {}
+    inline __attribute__((always_inline)) ~IsrProbe() {
+        IsrStat &s = isr_stats[xPortGetCoreID() & 1][id];
+        s.cycles += esp_cpu_get_cycle_count() - t0;
+        s.us += (uint32_t)esp_timer_get_time() - t0_us;
+        s.count++;
+    }
+};
+#define ISR_PROBE(isr) IsrProbe isr_probe_(isr)
+#else
+#define ISR_PROBE(isr) do {} while (0)
+#endif
+
+
+// ==========================================
+// 📈 PART 2: TASK SNAPSHOTS
+// ==========================================
+// FreeRTOS run-time counters (esp_timer microseconds on the ESP32) give each task's CPU time,
+// uxTaskGetSystemState() the minimum free stack ever seen. Loads are per core: 100 % = one core busy.
+
+#define TOP_MAX_TASKS      24
+#define TOP_STACK_WARN     512   // Bytes of free stack below which a task is flagged
+
+struct TopTaskSnap {
+    UBaseType_t num;
+    uint32_t run;
+};
+
+static TopTaskSnap top_prev_tasks[TOP_MAX_TASKS];
+static int top_prev_n = 0;
+static IsrStat top_prev_isr[2][ISR_COUNT];
+static uint64_t top_isr_cycles[2][ISR_COUNT];  // Summed since 'top' started
+static uint32_t top_prev_us = 0;
+
+inline uint32_t top_prev_run(UBaseType_t num, bool &found) {
+    for (int i = 0; i < top_prev_n; i++) {
+        if (top_prev_tasks[i].num == num) { found = true; return top_prev_tasks[i].run; }
+    }
+    found = false;
+    return 0;
+}
+
+inline int top_task_core(const TaskStatus_t &t) {
+#if defined(configTASKLIST_INCLUDE_COREID) && configTASKLIST_INCLUDE_COREID
+    return (t.xCoreID == 0 || t.xCoreID == 1) ? (int)t.xCoreID : -1;
+#else
+    return -1;
+#endif
+}
+
+inline void top_draw_tasks(uint32_t dt_us) {
+    static TaskStatus_t tasks[TOP_MAX_TASKS];
+    static uint32_t delta[TOP_MAX_TASKS];
+    UBaseType_t n = uxTaskGetSystemState(tasks, TOP_MAX_TASKS, nullptr);
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        bool found;
+        uint32_t prev = top_prev_run(tasks[i].xTaskNumber, found);
+        delta[i] = found ? tasks[i].ulRunTimeCounter - prev : 0;
+    }
+    // Busiest first (insertion sort, a couple of dozen tasks at most)
+    for (UBaseType_t i = 1; i < n; i++) {
+        TaskStatus_t t = tasks[i];
+        uint32_t d = delta[i];
+        int j = (int)i - 1;
+        while (j >= 0 && delta[j] < d) { tasks[j + 1] = tasks[j]; delta[j + 1] = delta[j]; j--; }
+        tasks[j + 1] = t;
+        delta[j + 1] = d;
+    }
+
+    Serial2.println(" TASK              CORE PRIO   CPU %   FREE STACK");
+    for (UBaseType_t i = 0; i < n; i++) {
+        int core = top_task_core(tasks[i]);
+        uint32_t free_b = tasks[i].usStackHighWaterMark;
+#if configGENERATE_RUN_TIME_STATS
+        float pct = dt_us ? (100.0f * delta[i] / dt_us) : 0.0f;
+        Serial2.printf(" %-16s  %4s %4u  %6.1f   %6lu B %s\n", tasks[i].pcTaskName, core < 0 ? "any" : (core ? "1" : "0"),
+                       (unsigned)tasks[i].uxCurrentPriority, pct, (unsigned long)free_b, free_b < TOP_STACK_WARN ? "⚠️" : "");
+#else
+        Serial2.printf(" %-16s  %4s %4u     n/a   %6lu B %s\n", tasks[i].pcTaskName, core < 0 ? "any" : (core ? "1" : "0"),
+                       (unsigned)tasks[i].uxCurrentPriority, (unsigned long)free_b, free_b < TOP_STACK_WARN ? "⚠️" : "");
+#endif
+    }
+    if (n == TOP_MAX_TASKS) Serial2.printf(" (first %d tasks only)\n", TOP_MAX_TASKS);
+
+    top_prev_n = (int)n;
+    for (UBaseType_t i = 0; i < n; i++) {
+        top_prev_tasks[i].num = tasks[i].xTaskNumber;
+        top_prev_tasks[i].run = tasks[i].ulRunTimeCounter;
+    }
+}
+
+inline void top_draw_isrs(uint32_t dt_us) {
+    Serial2.println(" ISR          CORE    ENTRIES     /s   AVG CYC   CPU %   CYCLES (top)");
+    for (int c = 0; c < 2; c++) {
+        uint64_t core_us = 0;
+        for (int i = 0; i < ISR_COUNT; i++) {
+            IsrStat now = isr_stats[c][i];
+            uint32_t dn = now.count - top_prev_isr[c][i].count;
+            uint32_t dc = now.cycles - top_prev_isr[c][i].cycles;
+            uint32_t du = now.us - top_prev_isr[c][i].us;
+            top_prev_isr[c][i] = now;
+            top_isr_cycles[c][i] += dc;
+            core_us += du;
+            if (!now.count) continue;
+            Serial2.printf(" %-12s  %d  %10lu %6lu %9lu  %6.2f   %llu\n", ISR_NAMES[i], c, (unsigned long)now.count,
+                           (unsigned long)(dt_us ? (uint64_t)dn * 1000000ULL / dt_us : 0),
+                           (unsigned long)(dn ? dc / dn : 0),
+                           dt_us ? (100.0f * du / dt_us) : 0.0f,
+                           (unsigned long long)top_isr_cycles[c][i]);
+        }
+        Serial2.printf(" core %d ISRs: %.2f %% of the time (now %lu MHz)\n", c,
+                       dt_us ? (100.0f * core_us / dt_us) : 0.0f, (unsigned long)getCpuFrequencyMhz());
+    }
+}
+
+
+// ==========================================
+// 🖥️ PART 3: 'top' SCREEN (SERVICE TASK)
+// ==========================================
+
+// Redraws every TOP_REFRESH_MS until a key arrives on the console
+inline void run_top() {
+    top_prev_n = 0;
+    memcpy(top_prev_isr, isr_stats, sizeof(top_prev_isr));
+    memset(top_isr_cycles, 0, sizeof(top_isr_cycles));
+    top_prev_us = micros();
+    top_draw_tasks(0); // First snapshot: the loads need two
+
+    uint32_t last_draw = millis();
+    while (Serial2.available() == 0) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+        if (millis() - last_draw < TOP_REFRESH_MS) continue;
+        last_draw = millis();
+
+        uint32_t now_us = micros();
+        uint32_t dt_us = now_us - top_prev_us;
+        top_prev_us = now_us;
+
+        Serial2.print("\033[2J\033[H");
+        Serial2.println("==========================================");
+        Serial2.printf("   TOP  (%lu ms window, any key = quit)\n", (unsigned long)(dt_us / 1000));
+        Serial2.println("==========================================");
+        top_draw_tasks(dt_us);
+        Serial2.println("------------------------------------------");
+#if ISR_PROFILE
+        top_draw_isrs(dt_us);
+#else
+        Serial2.println(" ISR probes disabled (ISR_PROFILE 0)");
+#endif
+    }
+    while (Serial2.available() > 0) Serial2.read();
+    Serial2.println("\n>>> TOP closed.");
+}
@@ -8,11 +8,17 @@
 #include <Arduino.h>
 #include "soc/rtc_cntl_reg.h" // Required for the 'flash' command
 #include "Globals.h"
+#include "MemBudget.h"
 
 // --- FORWARD DECLARATIONS ---
 // These are still needed because they are defined in Hardware.h / CoreTasks.h
-extern void configure_console_mode(bool is_amiga); 
-extern void run_gpio_diagnostics();
+extern void print_usb_devices();
+extern void usb_apply_focus_profile(const PadConfig &cfg);
+extern void run_power_benchmark(uint32_t ms);
+extern bool telemetry_start(uint32_t baud);
+extern void telemetry_stop();
+extern bool inject_start(uint32_t baud);
+extern void inject_service();
 
 
 // ==========================================
@@ -32,6 +38,11 @@ enum SniffStep {
     S_WAIT_F3,   S_REL_F3,      
     S_WAIT_UPALT,S_REL_UPALT, 
     S_WAIT_AUTO, S_REL_AUTO, 
+    S_WAIT_GREEN, S_REL_GREEN,
+    S_WAIT_YELLOW,S_REL_YELLOW,
+    S_WAIT_SH_L, S_REL_SH_L,
+    S_WAIT_SH_R, S_REL_SH_R,
+    S_WAIT_START,S_REL_START,
     S_WAIT_LS_X, S_REL_LS_X,
     S_WAIT_LS_Y, S_REL_LS_Y,
     S_WAIT_RS_X, S_REL_RS_X,
@@ -47,6 +58,8 @@ static uint8_t dat_max[64];
 
 static int b_up, b_down, b_left, b_right, b_f1, b_f2, b_f3, b_up_alt, b_auto;
 static int b_ls_x = 0, b_ls_y = 0, b_rs_x = 0, b_rs_y = 0;
+static int b_green = 0, b_yellow = 0, b_sh_l = 0, b_sh_r = 0, b_start = 0;
+static uint8_t m_green = 0, m_yellow = 0, m_sh_l = 0, m_sh_r = 0, m_start = 0;
 static uint8_t v_up, v_down, v_left, v_right, v_f1, v_f2, v_f3, v_up_alt, v_auto;
 static bool config_printed = false;
 static unsigned long sniff_timer = 0; 
@@ -55,29 +68,49 @@ static bool first_packet_received = false;
 // --- Multiplexer Detection Variables ---
 static bool detected_multiplexer = false;
 static uint8_t detected_report_id = 0;
+static uint8_t detected_ids[MUX_SLOTS];   // Every report ID seen during calibration
+static int detected_id_count = 0;
 
 inline void reset_sniffer() {
     sniff_step = S_INIT;
     config_printed = false;
     b_ls_x = 0; b_ls_y = 0; b_rs_x = 0; b_rs_y = 0;
+    b_green = 0; b_yellow = 0; b_sh_l = 0; b_sh_r = 0; b_start = 0;
+    m_green = 0; m_yellow = 0; m_sh_l = 0; m_sh_r = 0; m_start = 0;
     first_packet_received = false; 
     detected_multiplexer = false;
     detected_report_id = 0;
+    detected_id_count = 0;
     sniff_timer = millis();
     for(int i = 0; i < 64; i++) dat_thresh[i] = 2; 
 }
 
+// --- Boot trace report ('boot' command) ---
+inline void print_boot_trace() {
+    Serial2.println("\n=== ⏱️ BOOT TRACE ===");
+    Serial2.printf(" Mode: %s\n", FAST_BOOT ? "FAST_BOOT" : "standard");
+    uint32_t prev = 0;
+    for (int i = 0; i < boot_trace_len; i++) {
+        uint32_t t = boot_trace[i].t_us;
+        Serial2.printf(" %8.1f ms  (+%7.1f)  %s\n", t / 1000.0f, (t - prev) / 1000.0f, boot_trace[i].label);
+        prev = t;
+    }
+    Serial2.println("---------------------");
+    if (boot_first_report_us == 0) {
+        Serial2.println(" No USB report received yet: plug a pad and reboot to measure.");
+    } else {
+        uint32_t ms = boot_first_report_us / 1000;
+        Serial2.printf(" First report on the DB9 pins: %lu ms (target %d ms) -> %s\n", (unsigned long)ms, BOOT_TARGET_MS, ms <= BOOT_TARGET_MS ? "PASS" : "FAIL");
+    }
+    Serial2.println(" Times start when the app starts; add the 2nd-stage bootloader time (see ServiceMenu.md).");
+    Serial2.println("=====================\n");
+}
+
 inline void run_raw_sniffer(const uint8_t *data, int len) {
     static uint8_t last_raw[64] = {0};
-    bool changed = false;
     int check_len = len > 12 ? 12 : len;
 
-    for(int i = 0; i < check_len; i++) {
-        if(abs((int)data[i] - (int)last_raw[i]) > 0) { 
-            changed = true; break;
-        }
-    }
-    if (changed) {
+    if (memcmp(data, last_raw, check_len) != 0) {
         SNIFFER_SERIAL.print("RAW DATA: ");
         for(int i = 0; i < check_len; i++) {
             SNIFFER_SERIAL.printf("[%d]:%3d  ", i, data[i]);
@@ -100,6 +133,11 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
         }
 
         if (millis() - sniff_timer < 2000) {
+            // Collect the set of report IDs (ports) cycling on byte 0
+            bool known = false;
+            for (int k = 0; k < detected_id_count; k++) if (detected_ids[k] == data[0]) known = true;
+            if (!known && detected_id_count < MUX_SLOTS) detected_ids[detected_id_count++] = data[0];
+
             for(int i = 0; i < len; i++) {
                 dat_neutral[i] = data[i];
                 if (data[i] < dat_min[i]) dat_min[i] = data[i];
@@ -127,7 +165,9 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
         }
         
         if (detected_multiplexer) {
-             SNIFFER_SERIAL.printf(">>> MULTIPLEXER DETECTED! Locked to Port/ID: %d\n", detected_report_id);
+             SNIFFER_SERIAL.printf(">>> MULTIPLEXER DETECTED! %d ports, IDs:", detected_id_count);
+             for (int k = 0; k < detected_id_count; k++) SNIFFER_SERIAL.printf(" %d", detected_ids[k]);
+             SNIFFER_SERIAL.printf("\n>>> Map the pad on Port/ID %d, every port will share the mapping.\n", detected_report_id);
         }
 
         sniff_step = S_START;
@@ -140,6 +180,9 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
         SNIFFER_SERIAL.println("[?] PRESS AND HOLD: UP on D-PAD");
     }
 
+    // Multitap: only the locked port is mapped, the others would look like button presses
+    if (detected_multiplexer && data[0] != detected_report_id) return;
+
     bool is_neutral = true;
     int changed_byte = -1;
     uint8_t changed_val = 0;
@@ -202,6 +245,39 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
             if (!is_neutral) { b_auto = changed_byte; v_auto = changed_val; SNIFFER_SERIAL.printf("OK! B:%d, V:%d\n", b_auto, v_auto); sniff_step = S_REL_AUTO; } break;
         
         case S_REL_AUTO: 
+            if (is_neutral) { 
+                SNIFFER_SERIAL.println("\n--- CD32 EXTRA BUTTONS (Optional) ---");
+                SNIFFER_SERIAL.println("[?] PRESS AND HOLD: CD32 GREEN (Or press FIRE 1 to skip all extras)"); 
+                sniff_step = S_WAIT_GREEN; 
+            } break;
+
+        // Extra buttons are stored as changed bits (always bit-tested by the engine)
+        case S_WAIT_GREEN: 
+            if (!is_neutral && changed_byte == b_f1 && changed_val == v_f1) {
+                SNIFFER_SERIAL.println(">>> CD32 extras skipped.");
+                sniff_step = S_REL_START; 
+            } else if (!is_neutral) { b_green = changed_byte; m_green = changed_val ^ dat_neutral[changed_byte]; SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", b_green, m_green); sniff_step = S_REL_GREEN; } break;
+        case S_REL_GREEN: 
+            if (is_neutral) { SNIFFER_SERIAL.println("[?] PRESS AND HOLD: CD32 YELLOW"); sniff_step = S_WAIT_YELLOW; } break;
+
+        case S_WAIT_YELLOW: 
+            if (!is_neutral) { b_yellow = changed_byte; m_yellow = changed_val ^ dat_neutral[changed_byte]; SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", b_yellow, m_yellow); sniff_step = S_REL_YELLOW; } break;
+        case S_REL_YELLOW: 
+            if (is_neutral) { SNIFFER_SERIAL.println("[?] PRESS AND HOLD: LEFT SHOULDER (CD32 Rewind)"); sniff_step = S_WAIT_SH_L; } break;
+
+        case S_WAIT_SH_L: 
+            if (!is_neutral) { b_sh_l = changed_byte; m_sh_l = changed_val ^ dat_neutral[changed_byte]; SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", b_sh_l, m_sh_l); sniff_step = S_REL_SH_L; } break;
+        case S_REL_SH_L: 
+            if (is_neutral) { SNIFFER_SERIAL.println("[?] PRESS AND HOLD: RIGHT SHOULDER (CD32 Forward)"); sniff_step = S_WAIT_SH_R; } break;
+
+        case S_WAIT_SH_R: 
+            if (!is_neutral) { b_sh_r = changed_byte; m_sh_r = changed_val ^ dat_neutral[changed_byte]; SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", b_sh_r, m_sh_r); sniff_step = S_REL_SH_R; } break;
+        case S_REL_SH_R: 
+            if (is_neutral) { SNIFFER_SERIAL.println("[?] PRESS AND HOLD: START (CD32 Play)"); sniff_step = S_WAIT_START; } break;
+
+        case S_WAIT_START: 
+            if (!is_neutral) { b_start = changed_byte; m_start = changed_val ^ dat_neutral[changed_byte]; SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", b_start, m_start); sniff_step = S_REL_START; } break;
+        case S_REL_START: 
             if (is_neutral) { 
                 SNIFFER_SERIAL.println("\n--- ANALOG STICKS (Optional) ---");
                 SNIFFER_SERIAL.println("[?] MOVE LEFT STICK FULLY RIGHT (Or press FIRE 1 to skip all analogs)"); 
@@ -268,7 +344,7 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
 
         case S_DONE:
             if (!config_printed) {
-                String type_str = "EXACT_VALUE";
+                const char *type_str = "EXACT_VALUE";
                 bool same_byte = (b_up == b_left && b_left == b_down && b_down == b_right);
                 if (same_byte) {
                     if ((v_up & 0x0F) <= 8) type_str = "HAT_SWITCH"; 
@@ -278,7 +354,7 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
                     else type_str = "HYBRID_16BIT_BITMASK";
                 }
 
-                bool is_exact = (type_str == "HAT_SWITCH" || type_str == "EXACT_VALUE"); 
+                bool is_exact = (strcmp(type_str, "HAT_SWITCH") == 0 || strcmp(type_str, "EXACT_VALUE") == 0); 
                 uint8_t m_f1 = is_exact ? v_f1 : (v_f1 ^ dat_neutral[b_f1]);
                 uint8_t m_f2 = is_exact ? v_f2 : (v_f2 ^ dat_neutral[b_f2]);
                 uint8_t m_f3 = is_exact ? v_f3 : (v_f3 ^ dat_neutral[b_f3]); 
@@ -287,15 +363,19 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
 
                 SNIFFER_SERIAL.println("\n// --- COPY THIS INTO JoystickProfiles.h ---");
                 SNIFFER_SERIAL.println("{");
-                SNIFFER_SERIAL.printf("  .name = \"%s\",\n", sniff_profile_name.c_str());
+                SNIFFER_SERIAL.printf("  .name = \"%s\",\n", sniff_profile_name);
                 SNIFFER_SERIAL.printf("  .vid = %d, .pid = %d,\n", vid, pid);
                 SNIFFER_SERIAL.printf("  .use_report_id = %s, .report_id_val = %d,\n", detected_multiplexer ? "true" : "false", detected_report_id);
-                SNIFFER_SERIAL.printf("  .dpad_type = %s,\n", type_str.c_str());
+                SNIFFER_SERIAL.printf("  .dpad_type = %s,\n", type_str);
                 SNIFFER_SERIAL.printf("  .byte_x = %d, .byte_y = %d, .byte_analog_x = %d, .byte_analog_y = %d, .byte_analog_right_x = %d, .byte_analog_right_y = %d,\n", b_left, b_up, b_ls_x, b_ls_y, b_rs_x, b_rs_y);
                 SNIFFER_SERIAL.printf("  .byte_fire1 = %d, .byte_fire2 = %d, .byte_fire3 = %d, .byte_up_alt = %d, .byte_autofire = %d, .byte_autofire_off = 0,\n", b_f1, b_f2, b_f3, b_up_alt, b_auto);
                 SNIFFER_SERIAL.printf("  .val_up = %d, .val_down = %d, .val_left = %d, .val_right = %d,\n", v_up, v_down, v_left, v_right);
                 SNIFFER_SERIAL.printf("  .val_fire1 = %d, .val_fire2 = %d, .val_fire3 = %d, .val_up_alt = %d, .val_autofire = %d, .val_autofire_off = 0x00,\n", m_f1, m_f2, m_f3, m_up_alt, m_auto);
-                SNIFFER_SERIAL.println("  .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW");
+                SNIFFER_SERIAL.println("  .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW,");
+                SNIFFER_SERIAL.println("  .output_mode = OUT_JOYSTICK,");
+                SNIFFER_SERIAL.printf("  .byte_face3 = %d, .byte_face4 = %d, .byte_shoulder_l = %d, .byte_shoulder_r = %d, .byte_start = %d,\n", b_green, b_yellow, b_sh_l, b_sh_r, b_start);
+                SNIFFER_SERIAL.printf("  .val_face3 = %d, .val_face4 = %d, .val_shoulder_l = %d, .val_shoulder_r = %d, .val_start = %d,\n", m_green, m_yellow, m_sh_l, m_sh_r, m_start);
+                SNIFFER_SERIAL.printf("  .fingerprint = 0x%08lX\n", (unsigned long)connected_fingerprint);
                 SNIFFER_SERIAL.println("},");
                 SNIFFER_SERIAL.println("// -----------------------------------------");
                 config_printed = true;
@@ -304,9 +384,369 @@ inline void run_sniffer(uint16_t vid, uint16_t pid, const uint8_t *data, int len
     }
 }
 
+// ==========================================
+// 📊 PART 2: STATISTICAL AUTO-PROFILER ('auto')
+// ==========================================
+// Free play instead of the guided wizard: every report is folded into running statistics
+// (per-bit toggle counts, per-byte min / max / sum / sum of squares / values seen). Each byte
+// is then classified as button bits, hat switch, 8-bit axis or 16-bit axis, and only
+// Fire 1/2/3 are asked. Reports are compared as 16 x 32-bit words (64 bytes).
+
+#define AP_WORDS          16     // 64-byte report = 16 words
+#define AP_NEUTRAL_MS     1000   // Hands-off window: noise bits and report IDs
+#define AP_PLAY_MS        6000   // Free play window
+#define AP_MIN_TOGGLES    2      // Press + release: a bit that toggled less is not a button
+#define AP_AXIS_RANGE     128    // An 8-bit axis travels at least half of its range...
+#define AP_AXIS_VAR       256    // ...and is spread out (std dev >= 16), unlike a 2-state bit
+#define AP_MIN_DIAGONALS  2      // A bitmask D-pad must show diagonals while rolled
+
+enum AutoStep { AP_IDLE, AP_NEUTRAL, AP_PLAY, AP_FIRE1, AP_FIRE2, AP_FIRE3, AP_DONE };
+enum AutoField : uint8_t { F_NONE, F_BUTTONS, F_HAT, F_AXIS8, F_AXIS16 };
+
+static AutoStep ap_step = AP_IDLE;
+static unsigned long ap_timer = 0;
+static bool ap_first_packet = false;
+static bool ap_wait_release = false;
+static int ap_len = 0;
+
+static uint32_t ap_neutral[AP_WORDS];     // Reference report (end of the hands-off window)
+static uint32_t ap_prev[AP_WORDS];
+static uint32_t ap_noise[AP_WORDS];       // Bits that move with hands off
+static uint32_t ap_moved[AP_WORDS];       // Bits that left their neutral value during play
+static uint32_t ap_btn_mask[AP_WORDS];    // Bits accepted when confirming Fire 1/2/3
+static uint16_t ap_toggles[AP_WORDS * 32];
+static uint8_t  ap_min[64], ap_max[64];
+static uint32_t ap_sum[64];
+static uint64_t ap_sumsq[64];
+static uint32_t ap_seen[64][8];           // Set of values seen per byte (256 bits)
+static uint32_t ap_count = 0;
+
+static bool ap_use_rid = false;
+static uint8_t ap_rid = 0;
+static uint8_t ap_field[64];
+static PadConfig ap_cfg;
+static int ap_fire_byte[3];
+static uint8_t ap_fire_mask[3];
+
+inline uint8_t ap_byte(const uint32_t *w, int i) { return (w[i >> 2] >> ((i & 3) * 8)) & 0xFF; }
+inline bool ap_seen_val(int i, uint8_t v)        { return (ap_seen[i][v >> 5] >> (v & 31)) & 1; }
+
+inline void reset_autoprofiler() {
+    ap_step = AP_NEUTRAL;
+    ap_first_packet = false;
+    ap_wait_release = false;
+    ap_len = 0;
+    ap_count = 0;
+    ap_use_rid = false;
+    memset(ap_noise, 0, sizeof(ap_noise));
+    memset(ap_moved, 0, sizeof(ap_moved));
+    memset(ap_toggles, 0, sizeof(ap_toggles));
+    memset(ap_min, 0xFF, sizeof(ap_min));
+    memset(ap_max, 0, sizeof(ap_max));
+    memset(ap_sum, 0, sizeof(ap_sum));
+    memset(ap_sumsq, 0, sizeof(ap_sumsq));
+    memset(ap_seen, 0, sizeof(ap_seen));
+    memset(ap_field, F_NONE, sizeof(ap_field));
+    ap_timer = millis();
+}
+
+// Streaming statistics of one report: word-wide XORs for the bits, one pass for the bytes
+inline void ap_accumulate(const uint32_t *cur, const uint8_t *data, int len) {
+    for (int w = 0; w < AP_WORDS; w++) {
+        uint32_t diff = cur[w] ^ ap_prev[w];
+        ap_moved[w] |= cur[w] ^ ap_neutral[w];
+        while (diff) {
+            uint16_t &t = ap_toggles[w * 32 + __builtin_ctz(diff)];
+            if (t != 0xFFFF) t++;
+            diff &= diff - 1;
+        }
+        ap_prev[w] = cur[w];
+    }
+    for (int i = 0; i < len; i++) {
+        uint8_t v = data[i];
+        if (v < ap_min[i]) ap_min[i] = v;
+        if (v > ap_max[i]) ap_max[i] = v;
+        ap_sum[i] += v;
+        ap_sumsq[i] += (uint32_t)v * v;
+        ap_seen[i][v >> 5] |= (1UL << (v & 31));
+    }
+    ap_count++;
+}
+
+// Bits of byte i that behaved like buttons (not noise, pressed and released)
+inline uint8_t ap_button_bits(int i) {
+    uint8_t cand = ap_byte(ap_moved, i) & ~ap_byte(ap_noise, i);
+    uint8_t bits = 0;
+    for (int b = 0; b < 8; b++) {
+        if ((cand & (1 << b)) && ap_toggles[i * 8 + b] >= AP_MIN_TOGGLES) bits |= (1 << b);
+    }
+    return bits;
+}
+
+// True when both bits were seen pressed together
+inline bool ap_seen_together(int i, uint8_t a, uint8_t b) {
+    uint8_t both = a | b;
+    for (int v = 0; v < 256; v++) {
+        if ((v & both) == both && ap_seen_val(i, v)) return true;
+    }
+    return false;
+}
+
+// Classifies every byte, then picks the D-pad and sticks. Fills ap_cfg (fires are asked later).
+inline void ap_classify() {
+    int first = ap_use_rid ? 1 : 0;
+    int axis8[4], n_axis8 = 0;
+    int axis16[2], n_axis16 = 0;
+    int hat = -1;
+
+    // 1. 16-bit signed axes: high byte rests on 0x00/0xFF and swings far on both sides
+    for (int i = first; i + 1 < ap_len; i++) {
+        if (ap_field[i] != F_NONE || ap_field[i + 1] != F_NONE) continue;
+        uint8_t hi_n = ap_byte(ap_neutral, i + 1);
+        bool centred = (hi_n == 0x00 || hi_n == 0xFF);
+        bool positive = (ap_seen[i + 1][2] | ap_seen[i + 1][3]) != 0; // 0x40..0x7F
+        bool negative = (ap_seen[i + 1][4] | ap_seen[i + 1][5]) != 0; // 0x80..0xBF
+        if (centred && positive && negative && ap_byte(ap_moved, i) == 0xFF) {
+            ap_field[i] = F_AXIS16; ap_field[i + 1] = F_AXIS16;
+            if (n_axis16 < 2) axis16[n_axis16++] = i;
+            i++;
+        }
+    }
+
+    for (int i = first; i < ap_len; i++) {
+        if (ap_field[i] != F_NONE || ap_count == 0) continue;
+        uint8_t n = ap_byte(ap_neutral, i);
+        float mean = (float)ap_sum[i] / ap_count;
+        float var = (float)ap_sumsq[i] / ap_count - mean * mean;
+
+        // 2. Hat switch: low nibble rests on 8..15 and visits at least 4 of the 8 directions
+        if (hat < 0 && (n & 0x0F) >= 8) {
+            uint16_t nib = 0;
+            for (int v = 0; v < 256; v++) if (ap_seen_val(i, v)) nib |= (1 << (v & 0x0F));
+            if (__builtin_popcount(nib & 0xFF) >= 4) { ap_field[i] = F_HAT; hat = i; continue; }
+        }
+
+        // 3. 8-bit axis: rests near the centre, travels far and spreads its values
+        if (n >= 64 && n <= 192 && (ap_max[i] - ap_min[i]) >= AP_AXIS_RANGE && var >= AP_AXIS_VAR) {
+            ap_field[i] = F_AXIS8;
+            if (n_axis8 < 4) axis8[n_axis8++] = i;
+            continue;
+        }
+
+        // 4. Everything else that moved is a button byte
+        if (ap_byte(ap_moved, i) & ~ap_byte(ap_noise, i)) ap_field[i] = F_BUTTONS;
+    }
+
+    ap_cfg = PadConfig();
+    ap_cfg.name = sniff_profile_name;
+    ap_cfg.vid = connected_vid;
+    ap_cfg.pid = connected_pid;
+    ap_cfg.fingerprint = connected_fingerprint;
+    ap_cfg.use_report_id = ap_use_rid;
+    ap_cfg.report_id_val = ap_rid;
+    ap_cfg.color_fire1 = C_GREEN; ap_cfg.color_fire2 = C_RED; ap_cfg.color_fire3 = C_CYAN;
+    ap_cfg.color_up_alt = C_BLUE; ap_cfg.color_autofire = C_YELLOW;
+    ap_cfg.output_mode = OUT_JOYSTICK;
+
+    // Bitmask D-pad: 4 button bits of one byte, Up/Down and Left/Right never together,
+    // and diagonals seen while rolling (unrelated buttons rarely show that pattern)
+    int dpad_byte = -1;
+    uint8_t dpad_bits[4];
+    for (int i = first; i < ap_len && dpad_byte < 0; i++) {
+        if (ap_field[i] != F_BUTTONS) continue;
+        uint8_t bits = ap_button_bits(i);
+        uint8_t list[8]; int n = 0;
+        for (int b = 0; b < 8; b++) if (bits & (1 << b)) list[n++] = (1 << b);
+        for (int k = 0; k + 3 < n; k++) {
+            uint8_t up = list[k], down = list[k + 1], left = list[k + 2], right = list[k + 3];
+            if (ap_seen_together(i, up, down) || ap_seen_together(i, left, right)) continue;
+            int diagonals = ap_seen_together(i, up, left) + ap_seen_together(i, up, right)
+                          + ap_seen_together(i, down, left) + ap_seen_together(i, down, right);
+            if (diagonals < AP_MIN_DIAGONALS) continue;
+            dpad_byte = i;
+            dpad_bits[0] = up; dpad_bits[1] = down; dpad_bits[2] = left; dpad_bits[3] = right;
+            break;
+        }
+    }
+
+    int next_axis8 = 0;
+    if (hat >= 0) {
+        ap_cfg.dpad_type = HAT_SWITCH;
+        ap_cfg.byte_x = hat; ap_cfg.byte_y = hat;
+    } else if (dpad_byte >= 0) {
+        ap_cfg.dpad_type = (n_axis16 >= 2) ? HYBRID_16BIT_BITMASK : BITMASK;
+        ap_cfg.byte_x = dpad_byte; ap_cfg.byte_y = 0;
+        ap_cfg.val_up = dpad_bits[0]; ap_cfg.val_down = dpad_bits[1];
+        ap_cfg.val_left = dpad_bits[2]; ap_cfg.val_right = dpad_bits[3];
+    } else if (n_axis8 >= 2) {
+        // No digital pad: the first two axes are the directions (cheap arcade / retro pads)
+        ap_cfg.dpad_type = AXIS;
+        ap_cfg.byte_x = axis8[0]; ap_cfg.byte_y = axis8[1];
+        next_axis8 = 2;
+    } else if (n_axis16 >= 2) {
+        ap_cfg.dpad_type = HYBRID_16BIT_BITMASK; // Sticks only, no D-pad bits
+    } else {
+        ap_cfg.dpad_type = BITMASK;
+    }
+
+    if (ap_cfg.dpad_type == HYBRID_16BIT_BITMASK) {
+        ap_cfg.byte_analog_x = axis16[0]; ap_cfg.byte_analog_y = axis16[1];
+    } else {
+        if (next_axis8 + 1 < n_axis8) { ap_cfg.byte_analog_x = axis8[next_axis8]; ap_cfg.byte_analog_y = axis8[next_axis8 + 1]; next_axis8 += 2; }
+        if (next_axis8 + 1 < n_axis8) { ap_cfg.byte_analog_right_x = axis8[next_axis8]; ap_cfg.byte_analog_right_y = axis8[next_axis8 + 1]; }
+    }
+
+    // Fire candidates: button bytes and the spare high nibble of the hat byte, minus the D-pad
+    memset(ap_btn_mask, 0, sizeof(ap_btn_mask));
+    for (int i = first; i < ap_len; i++) {
+        uint8_t m = 0;
+        if (ap_field[i] == F_BUTTONS || ap_field[i] == F_NONE) m = 0xFF;
+        else if (ap_field[i] == F_HAT) m = 0xF0;
+        if (i == dpad_byte) m &= ~(dpad_bits[0] | dpad_bits[1] | dpad_bits[2] | dpad_bits[3]);
+        ap_btn_mask[i >> 2] |= (uint32_t)m << ((i & 3) * 8);
+    }
+    for (int w = 0; w < AP_WORDS; w++) ap_btn_mask[w] &= ~ap_noise[w];
+
+    const char *names[] = { "-", "BUTTONS", "HAT", "AXIS 8", "AXIS 16" };
+    SNIFFER_SERIAL.printf("\n>>> %lu reports analysed (%d bytes):\n", (unsigned long)ap_count, ap_len);
+    for (int i = 0; i < ap_len; i++) {
+        if (ap_field[i] == F_NONE) continue;
+        SNIFFER_SERIAL.printf("  [%2d] %-8s neutral:%3d min:%3d max:%3d", i, names[ap_field[i]], ap_byte(ap_neutral, i), ap_min[i], ap_max[i]);
+        if (ap_field[i] == F_BUTTONS) SNIFFER_SERIAL.printf(" bits:0x%02X", ap_button_bits(i));
+        SNIFFER_SERIAL.println();
+    }
+    const char *dpad_names[] = { "BITMASK", "HAT_SWITCH", "AXIS", "EXACT_VALUE", "HYBRID_16BIT_BITMASK" };
+    SNIFFER_SERIAL.printf(">>> D-PAD: %s on byte %d\n", dpad_names[ap_cfg.dpad_type], ap_cfg.byte_x);
+}
+
+// Fire value as the engine tests it: whole byte for HAT/EXACT pads, bit mask otherwise
+inline uint8_t ap_fire_val(int k) {
+    bool is_exact = (ap_cfg.dpad_type == HAT_SWITCH || ap_cfg.dpad_type == EXACT_VALUE);
+    return is_exact ? (ap_byte(ap_neutral, ap_fire_byte[k]) ^ ap_fire_mask[k]) : ap_fire_mask[k];
+}
+
+inline void ap_print_config() {
+    ap_cfg.byte_fire1 = ap_fire_byte[0]; ap_cfg.val_fire1 = ap_fire_val(0);
+    ap_cfg.byte_fire2 = ap_fire_byte[1]; ap_cfg.val_fire2 = ap_fire_val(1);
+    ap_cfg.byte_fire3 = ap_fire_byte[2]; ap_cfg.val_fire3 = ap_fire_byte[2] ? ap_fire_val(2) : 0;
+
+    const char *dpad_names[] = { "BITMASK", "HAT_SWITCH", "AXIS", "EXACT_VALUE", "HYBRID_16BIT_BITMASK" };
+    const PadConfig &c = ap_cfg;
+    SNIFFER_SERIAL.println("\n// --- COPY THIS INTO JoystickProfiles.h ---");
+    SNIFFER_SERIAL.println("{");
+    SNIFFER_SERIAL.printf("  .name = \"%s\",\n", sniff_profile_name);
+    SNIFFER_SERIAL.printf("  .vid = %d, .pid = %d,\n", c.vid, c.pid);
+    SNIFFER_SERIAL.printf("  .use_report_id = %s, .report_id_val = %d,\n", c.use_report_id ? "true" : "false", c.report_id_val);
+    SNIFFER_SERIAL.printf("  .dpad_type = %s,\n", dpad_names[c.dpad_type]);
+    SNIFFER_SERIAL.printf("  .byte_x = %d, .byte_y = %d, .byte_analog_x = %d, .byte_analog_y = %d, .byte_analog_right_x = %d, .byte_analog_right_y = %d,\n", c.byte_x, c.byte_y, c.byte_analog_x, c.byte_analog_y, c.byte_analog_right_x, c.byte_analog_right_y);
+    SNIFFER_SERIAL.printf("  .byte_fire1 = %d, .byte_fire2 = %d, .byte_fire3 = %d, .byte_up_alt = 0, .byte_autofire = 0, .byte_autofire_off = 0,\n", c.byte_fire1, c.byte_fire2, c.byte_fire3);
+    SNIFFER_SERIAL.printf("  .val_up = %d, .val_down = %d, .val_left = %d, .val_right = %d,\n", c.val_up, c.val_down, c.val_left, c.val_right);
+    SNIFFER_SERIAL.printf("  .val_fire1 = %d, .val_fire2 = %d, .val_fire3 = %d, .val_up_alt = 0, .val_autofire = 0, .val_autofire_off = 0x00,\n", c.val_fire1, c.val_fire2, c.val_fire3);
+    SNIFFER_SERIAL.println("  .color_fire1 = C_GREEN, .color_fire2 = C_RED, .color_fire3 = C_CYAN, .color_up_alt = C_BLUE, .color_autofire = C_YELLOW,");
+    SNIFFER_SERIAL.println("  .output_mode = OUT_JOYSTICK,");
+    SNIFFER_SERIAL.println("  .byte_face3 = 0, .byte_face4 = 0, .byte_shoulder_l = 0, .byte_shoulder_r = 0, .byte_start = 0,");
+    SNIFFER_SERIAL.println("  .val_face3 = 0, .val_face4 = 0, .val_shoulder_l = 0, .val_shoulder_r = 0, .val_start = 0,");
+    SNIFFER_SERIAL.printf("  .fingerprint = 0x%08lX\n", (unsigned long)connected_fingerprint);
+    SNIFFER_SERIAL.println("},");
+
+    // Remaining buttons seen during play: ready for Alt Up / Autofire / CD32 extras
+    for (int i = 0; i < ap_len; i++) {
+        uint8_t bits = ap_button_bits(i) & ap_byte(ap_btn_mask, i);
+        for (int k = 0; k < 3; k++) if (ap_fire_byte[k] == i) bits &= ~ap_fire_mask[k];
+        for (int b = 0; b < 8; b++) {
+            if (bits & (1 << b)) SNIFFER_SERIAL.printf("// Spare button: byte %d, mask %d\n", i, 1 << b);
+        }
+    }
+    if (c.dpad_type == BITMASK || c.dpad_type == HYBRID_16BIT_BITMASK) {
+        SNIFFER_SERIAL.println("// D-pad bits assumed in Up/Down/Left/Right order: check with 'test'.");
+    }
+    SNIFFER_SERIAL.println("// -----------------------------------------");
+}
+
+inline void run_autoprofiler(const uint8_t *data, int len) {
+    if (len <= 0 || ap_step == AP_IDLE || ap_step == AP_DONE) return;
+    if (len > 64) len = 64;
+
+    uint32_t cur[AP_WORDS] = {0};
+    memcpy(cur, data, len);
+    if (len > ap_len) ap_len = len;
+
+    if (ap_step == AP_NEUTRAL) {
+        if (!ap_first_packet) {
+            ap_first_packet = true;
+            memcpy(ap_prev, cur, sizeof(cur));
+            ap_rid = data[0];
+            ap_timer = millis();
+            SNIFFER_SERIAL.println("\n>>> PAD IS AWAKE! Hands off for 1 second...");
+            return;
+        }
+        if (millis() - ap_timer < AP_NEUTRAL_MS) {
+            for (int w = 0; w < AP_WORDS; w++) { ap_noise[w] |= cur[w] ^ ap_prev[w]; ap_prev[w] = cur[w]; }
+            ap_rid = data[0];
+            return;
+        }
+
+        // Byte 0 cycling with hands off = multitap report IDs: lock to the last one seen
+        ap_use_rid = (ap_noise[0] & 0xFF) != 0;
+        memcpy(ap_neutral, ap_prev, sizeof(ap_neutral));
+        if (ap_use_rid) SNIFFER_SERIAL.printf(">>> MULTIPLEXER DETECTED! Profiling Port/ID %d.\n", ap_rid);
+        SNIFFER_SERIAL.println("\n>>> NOW PLAY FREELY for 6 seconds:");
+        SNIFFER_SERIAL.println("    roll the D-pad in circles, sweep both sticks to every corner, press every button.");
+        ap_step = AP_PLAY;
+        ap_timer = millis();
+    }
+
+    if (ap_use_rid && data[0] != ap_rid) return;
+
+    if (ap_step == AP_PLAY) {
+        if (millis() - ap_timer < AP_PLAY_MS) { ap_accumulate(cur, data, len); return; }
+        ap_classify();
+        SNIFFER_SERIAL.println("\n>>> Release everything, then PRESS FIRE 1");
+        ap_step = AP_FIRE1;
+        ap_wait_release = true;
+        ap_fire_byte[0] = ap_fire_byte[1] = ap_fire_byte[2] = 0;
+        ap_fire_mask[0] = ap_fire_mask[1] = ap_fire_mask[2] = 0;
+    }
+
+    // --- Fire confirmation: the first candidate bit away from neutral ---
+    int hit = -1;
+    for (int w = 0; w < AP_WORDS && hit < 0; w++) {
+        uint32_t pressed = (cur[w] ^ ap_neutral[w]) & ap_btn_mask[w];
+        if (pressed) hit = w * 32 + __builtin_ctz(pressed);
+    }
+    if (ap_wait_release) { if (hit < 0) ap_wait_release = false; return; }
+    if (hit < 0) return;
+
+    int k = ap_step - AP_FIRE1;
+    int byte_idx = hit >> 3;
+    uint8_t mask = 1 << (hit & 7);
+
+    if (byte_idx == 0) {
+        SNIFFER_SERIAL.println(">>> That button sits on byte 0, which the engine cannot test. Choose another one.");
+        ap_wait_release = true;
+        return;
+    }
+    if (k == 2 && byte_idx == ap_fire_byte[0] && mask == ap_fire_mask[0]) {
+        SNIFFER_SERIAL.println(">>> Fire 3 skipped.");
+    } else {
+        ap_fire_byte[k] = byte_idx; ap_fire_mask[k] = mask;
+        SNIFFER_SERIAL.printf("OK! B:%d, M:%d\n", byte_idx, mask);
+    }
+    ap_wait_release = true;
+
+    if (ap_step == AP_FIRE1) { SNIFFER_SERIAL.println("[?] PRESS FIRE 2"); ap_step = AP_FIRE2; }
+    else if (ap_step == AP_FIRE2) { SNIFFER_SERIAL.println("[?] PRESS FIRE 3 (Or press FIRE 1 to skip)"); ap_step = AP_FIRE3; }
+    else {
+        ap_step = AP_DONE;
+        ap_print_config();
+        usb_apply_focus_profile(ap_cfg);
+        SNIFFER_SERIAL.println(">>> Profile applied to this pad until reboot: type 'test' to try it, 'exit' to play.");
+    }
+}
+
 
 // ==========================================
-// 🧠 PART 2: SMART AUTO-DUMPER (HTML -> NATIVE)
+// 🧠 PART 3: SMART AUTO-DUMPER (HTML -> NATIVE)
 // ==========================================
 
 inline void execute_html_dump() {
@@ -349,16 +789,16 @@ inline void execute_html_dump() {
     }
 #endif
 
-    String type_str = is_bitmask ? "BITMASK" : "EXACT_VALUE";
+    const char *type_str = is_bitmask ? "BITMASK" : "EXACT_VALUE";
     if (!is_bitmask && v_up == 0 && v_right == 2 && v_down == 4 && v_left == 6) {
         type_str = "HAT_SWITCH";
     }
 
     Serial2.println("\n// --- COPY THIS INTO YOUR JoystickProfiles.h ---");
     Serial2.println("{");
-    Serial2.printf("  .name = \"%s\",\n", sniff_profile_name.c_str());
+    Serial2.printf("  .name = \"%s\",\n", sniff_profile_name);
     Serial2.printf("  .vid = %d, .pid = %d,\n", connected_vid, connected_pid);
-    Serial2.printf("  .dpad_type = %s,\n", type_str.c_str());
+    Serial2.printf("  .dpad_type = %s,\n", type_str);
     Serial2.printf("  .byte_x = %d, .byte_y = %d, .byte_analog_x = %d, .byte_analog_y = %d, .byte_analog_right_x = %d, .byte_analog_right_y = %d,\n", b_left, b_up, b_analog_x, b_analog_y, b_analog_rx, b_analog_ry);
     Serial2.printf("  .byte_fire1 = %d, .byte_fire2 = %d, .byte_fire3 = %d, .byte_up_alt = %d, .byte_autofire = %d, .byte_autofire_off = %d,\n", b_f1, b_f2, b_f3, b_up_alt, b_auto, b_auto_off);
     Serial2.printf("  .val_up = %d, .val_down = %d, .val_left = %d, .val_right = %d,\n", v_up, v_down, v_left, v_right);
@@ -370,279 +810,560 @@ inline void execute_html_dump() {
 
 
 // ==========================================
-// 🛠️ PART 3: SERIAL COMMANDS & SERVICE MENU
+// 🛠️ PART 4: SERIAL COMMANDS & SERVICE MENU
 // ==========================================
 
-inline void handleServiceMenu() {
-    if (Serial2.available() > 0) {
-        String input = Serial2.readStringUntil('\n');
-        input.trim(); 
-        
-        // --- INTERACTIVE SERIAL PROMPTS --- 
-        if (cmd_state == CMD_WAIT_COLOR_CHOICE) {
-            if (input == "exit") {
-                cmd_state = CMD_IDLE;
-                current_mode = MODE_SERVICE; 
-                ws2812b.setBrightness(40); // (Or 89 if you prefer energy saving)
-                Serial2.println("\n>> Exited Color Test. Returned to Service Menu."); 
-            } else {
-                int choice = input.toInt();
-                if (choice >= 1 && choice <= 13) { 
-                    cmd_state = CMD_IDLE; 
-                    
-                    switch(choice) {
-                        case 1:  mix_r = 255; mix_g = 255; mix_b = 255; break; 
-                        case 2:  mix_r = 255; mix_g = 128; mix_b = 0;   break; 
-                        case 3:  mix_r = 0;   mix_g = 100; mix_b = 0;   break; 
-                        case 4:  mix_r = 180; mix_g = 0;   mix_b = 255; break; 
-                        case 5:  mix_r = 120; mix_g = 0;   mix_b = 180; break; 
-                        case 6:  mix_r = 20;  mix_g = 0;   mix_b = 40;  break; 
-                        case 7:  mix_r = 60;  mix_g = 0;   mix_b = 100; break; 
-                        case 8:  mix_r = 5;   mix_g = 0;   mix_b = 8;   break; 
-                        case 9:  mix_r = 0;   mix_g = 255; mix_b = 0;   break; 
-                        case 10: mix_r = 255; mix_g = 0;   mix_b = 0;   break; 
-                        case 11: mix_r = 0;   mix_g = 255; mix_b = 255; break; 
-                        case 12: mix_r = 0;   mix_g = 0;   mix_b = 255; break; 
-                        case 13: mix_r = 255; mix_g = 255; mix_b = 0;   break; 
-                    }
-                    ws2812b.setPixelColor(0, mix_r, mix_g, mix_b);
-                    ws2812b.show(); 
-                    Serial2.printf("\n>>> COLOR SET! Base Values -> R:%d, G:%d, B:%d\n", mix_r, mix_g, mix_b); 
-                    Serial2.println(">>> LIVE TWEAK ACTIVE: Move Joystick UP/DOWN for brightness, FIRE 1 to switch RGB, LEFT/RIGHT to change color."); 
-                } else {
-                    Serial2.println(">>> Invalid choice. Enter a number between 1 and 13, or 'exit'."); 
-                }
+// The CLI runs on its own low-priority task (service_task): a line is assembled one
+// character at a time from whatever the UART already holds, so a half-typed command
+// never blocks, and nothing is allocated on the heap.
+
+#define CLI_LINE_MAX  64   // Longest accepted line (longer lines are dropped)
+#define CLI_POLL_MS   10   // UART polling period of the service task
+
+static char cli_line[CLI_LINE_MAX];
+static uint8_t cli_len = 0;
+static bool cli_overflow = false;
+
+// --- Mouse benchmark: peaks are recorded by the packet loop, the CLI only waits ---
+static volatile bool mouse_bench_active = false;
+static volatile int mouse_bench_max_dx = 0;
+static volatile int mouse_bench_max_dy = 0;
+
+// Collects pending characters. Returns true when cli_line holds a complete, non-empty line.
+inline bool cli_read_line() {
+    while (Serial2.available() > 0) {
+        int c = Serial2.read();
+        power_serial_ms = millis(); // Keeps the chip out of light sleep while someone types
+        if (c == '\r' || c == '\n') {
+            if (cli_overflow) {
+                cli_overflow = false; cli_len = 0;
+                Serial2.println(">>> Line too long, ignored.");
+                continue;
             }
-            return;
+            if (cli_len == 0) continue; // Empty line or the second half of CR/LF
+            cli_line[cli_len] = '\0';
+            cli_len = 0;
+            return true;
         }
-        else if (cmd_state == CMD_WAIT_IMPORT) {
-            String ans = input;
-            ans.toLowerCase(); 
-            if (ans == "y" || ans == "yes") {
-                Serial2.print(">>> Enter a NAME for this profile: ");
-                cmd_state = CMD_WAIT_NAME_IMPORT; 
+        if (cli_len < CLI_LINE_MAX - 1) cli_line[cli_len++] = (char)c;
+        else cli_overflow = true;
+    }
+    return false;
+}
+
+// Strips leading/trailing blanks in place
+inline char* cli_trim(char *str) {
+    while (*str == ' ' || *str == '\t') str++;
+    int n = strlen(str);
+    while (n > 0 && (str[n - 1] == ' ' || str[n - 1] == '\t')) str[--n] = '\0';
+    return str;
+}
+
+// The loop owns the pins: post the request and wait until it has been applied
+inline bool cli_wait_loop(volatile int8_t &req) {
+    uint32_t t0 = millis();
+    while (req >= 0 && millis() - t0 < 1000) vTaskDelay(pdMS_TO_TICKS(2));
+    if (req < 0) return true;
+    req = -1;
+    Serial2.println(">>> ERROR: The main loop did not apply the change.");
+    return false;
+}
+
+// --- INTERACTIVE SERIAL PROMPTS ---
+// 'color' test choices 1-13, shown by the loop (it owns the status LED)
+static const uint8_t COLOR_TEST_RGB[13][3] = {
+    {255, 255, 255}, {255, 128, 0}, {0, 100, 0}, {180, 0, 255}, {120, 0, 180}, {20, 0, 40}, {60, 0, 100},
+    {5, 0, 8}, {0, 255, 0}, {255, 0, 0}, {0, 255, 255}, {0, 0, 255}, {255, 255, 0}
+};
+
+// Returns true when the line was an answer to a pending prompt
+inline bool cli_handle_prompt(const char *input) {
+    if (cmd_state == CMD_WAIT_COLOR_CHOICE) {
+        if (strcmp(input, "exit") == 0) {
+            cmd_state = CMD_IDLE;
+            current_mode = MODE_SERVICE; 
+            led_brightness_request = 40; // (Or 89 if you prefer energy saving)
+            cli_wait_loop(led_brightness_request);
+            Serial2.println("\n>> Exited Color Test. Returned to Service Menu."); 
+        } else {
+            int choice = atoi(input);
+            if (choice >= 1 && choice <= 13) { 
+                cmd_state = CMD_IDLE; 
+                
+                led_color_request = choice - 1;
+                if (!cli_wait_loop(led_color_request)) return true;
+                const uint8_t *rgb = COLOR_TEST_RGB[choice - 1];
+                Serial2.printf("\n>>> COLOR SET! Base Values -> R:%d, G:%d, B:%d\n", rgb[0], rgb[1], rgb[2]); 
+                Serial2.println(">>> LIVE TWEAK ACTIVE: Move Joystick UP/DOWN for brightness, FIRE 1 to switch RGB, LEFT/RIGHT to change color."); 
             } else {
-                Serial2.print(">>> Enter a NAME for the new manual profile: ");
-                cmd_state = CMD_WAIT_NAME_MANUAL; 
+                Serial2.println(">>> Invalid choice. Enter a number between 1 and 13, or 'exit'."); 
             }
-            return;
-        } 
-        else if (cmd_state == CMD_WAIT_NAME_IMPORT) {
-            sniff_profile_name = input;
-            cmd_state = CMD_IDLE; 
-            execute_html_dump(); 
-            return;
-        } 
-        else if (cmd_state == CMD_WAIT_NAME_MANUAL) {
-            sniff_profile_name = input;
-            cmd_state = CMD_IDLE; 
-            current_mode = MODE_SNIFFER; 
-            reset_sniffer(); 
-            xQueueReset(s_pkt_q); 
-            Serial2.println("\n>>> WIZARD ARMED! <<<");
-            Serial2.println("⏳ Waiting for neutral position calibration... (DO NOT touch the gamepad)"); 
-            Serial2.println("If nothing happens within 2 seconds, press and release a button to 'wake' it."); 
-            return;
         }
-
-        // --- NORMAL COMMAND PARSER ---
-        String command = input;
-        command.toLowerCase(); 
-
-        if (command == "service") {
-            current_mode = MODE_SERVICE;
-            Serial2.println("\n=== 🛠️  SERVICE MENU  🛠️ ==="); 
-            Serial2.printf("  ⚙️  ENGINE: %s\n", use_html_configurator ? "HTML HID Configurator" : "Internal Profiler"); 
-            Serial2.println("--------------------------------");
-            Serial2.println(" 🪄 'new'     : Map a new pad or Auto-Import HTML"); 
-            Serial2.println(" 👁️ 'raw'     : Show raw USB hex data stream"); 
-            Serial2.println(" 🎮 'test'    : Test logical buttons mapping (Up, Fire...)"); 
-            Serial2.println(" 🐭 'mousetest': Mouse speed and Packets"); 
-            Serial2.println(" ⏱️ 'lag'     : Measure USB Polling Rate and Input Lag"); 
-            Serial2.println(" 🎛️ 'gpio'    : Real-time dashboard of hardware states"); 
-            Serial2.println(" 🎨 'color'   : Live RGB Color Mixer (Use gamepad)");  
-            Serial2.println(" 🔄 'reboot'  : Restart the device softly");
-            Serial2.println(" ⚡ 'flash'   : Reboot into Programming/DFU Mode"); 
-            Serial2.println(" 🚪 'exit'    : Exit menu and return to normal play"); 
-            Serial2.println("================================\n");
+        return true;
+    }
+    else if (cmd_state == CMD_WAIT_IMPORT) {
+        if (strcasecmp(input, "y") == 0 || strcasecmp(input, "yes") == 0) {
+            Serial2.print(">>> Enter a NAME for this profile: ");
+            cmd_state = CMD_WAIT_NAME_IMPORT; 
+        } else {
+            Serial2.print(">>> Enter a NAME for the new manual profile: ");
+            cmd_state = CMD_WAIT_NAME_MANUAL; 
         }
-        else if (current_mode != MODE_PLAY || command == "exit") {
-            if (command == "new") { 
-                if (device_connected && use_html_configurator) { 
-                    Serial2.println("\n>>> HTML Profile detected! Do you want to Auto-Import it? (Y/N)");
-                    cmd_state = CMD_WAIT_IMPORT; 
-                } else {
-                    Serial2.print("\n>>> Enter a NAME for the new manual profile: ");
-                    cmd_state = CMD_WAIT_NAME_MANUAL; 
-                }
-            }
-            else if (command == "raw")   { current_mode = MODE_RAW; Serial2.println(">>> RAW mode active!"); } 
-            else if (command == "test")  { current_mode = MODE_DEBUG; Serial2.println(">>> TEST mode active!"); } 
-            else if (command == "gpio")  { 
-                current_mode = MODE_GPIO;
-                last_gpio_state = 0xFFFF; 
-                Serial2.println(">>> Starting GPIO Dashboard..."); 
-            }
-            else if (command == "lag") {
-                current_mode = MODE_POLLING;
-                polling_packet_count = 0; 
-                polling_start_time = 0; 
-                polling_neutral_saved = false; 
-                polling_active = true;
-                
-                Serial2.println("\n>>> Starting Polling Tester (Smart Trigger)... <<<"); 
-                Serial2.printf("Connected device: %s (VID:%04x PID:%04x)\n\n", device_connected ? (use_html_configurator ? "HTML Config Pad" : current_profile.name) : "None", connected_vid, connected_pid); 
-                if (!device_connected) {
-                    Serial2.println("⚠️ No gamepad connected! Connect a pad and try again."); 
-                    current_mode = MODE_SERVICE;
-                } else {
-                    Serial2.println("🕹️  Timer is waiting... Move the stick and press buttons to trigger it!"); 
-                }
-            }
-            else if (command == "color") {
-                current_mode = MODE_COLOR_MIXER;
-                cmd_state = CMD_WAIT_COLOR_CHOICE; 
-                
-                Serial2.println("\n=== LED COLOR TEST MENU ===");
-                Serial2.println("Select a color to test on your WS2812B:\n"); 
-                Serial2.println("[ SYSTEM STATES ]");
-                Serial2.println("1.  Amiga Idle     (White)"); 
-                Serial2.println("2.  C64 Idle       (Orange)");
-                Serial2.println("3.  HTML Config    (Green)\n"); 
-                Serial2.println("[ DIRECTIONAL PAD ]");
-                Serial2.println("4.  D-Pad Up       (Bright Purple)"); 
-                Serial2.println("5.  D-Pad Right    (Purple)");
-                Serial2.println("6.  D-Pad Down     (Very Dark Purple)"); 
-                Serial2.println("7.  D-Pad Left     (Dark Purple)");
-                Serial2.println("8.  D-Pad Idle     (Dark)\n"); 
-                Serial2.println("[ ACTION BUTTONS ]");
-                Serial2.println("9.  Fire 1         (Green)"); 
-                Serial2.println("10. Fire 2         (Red)"); 
-                Serial2.println("11. Fire 3         (Cyan)"); 
-                Serial2.println("12. Up Alt         (Blue)"); 
-                Serial2.println("13. Autofire       (Yellow)\n"); 
-                
-                Serial2.println("Type a number (1-13) to set the color.");
-                Serial2.println("Type 'exit' to return to the Service Menu.\n"); 
-                
-                Serial2.println("[!] LIVE BRIGHTNESS CONTROL:"); 
-                Serial2.println("Move your connected gamepad UP or DOWN to adjust the LED brightness dynamically!");
-                Serial2.println("[!] LIVE RGB COLOR TWEAKING:"); 
-                Serial2.println("Press FIRE 1 to switch between R, G, B channels, and move LEFT or RIGHT to change the color value!"); 
-                Serial2.println("Press FIRE 2 to print the final C++ code.");
-                Serial2.println("==========================="); 
-            }
-            else if (command == "exit")  { 
-                current_mode = MODE_PLAY;
-                ws2812b.setBrightness(40); 
-                Serial2.println("\n\n>>> PLAY mode (Zero-Lag) restored! Normal operation resumed. <<<");
-            }
-            else if (command == "amiga") { configure_console_mode(true); } 
-            else if (command == "c64")   { configure_console_mode(false); } 
-            else if (command == "reboot") {
-                Serial2.println("\n>>> REBOOTING DEVICE... <<<");
-                delay(500); 
-                ESP.restart();
-            }
-            else if (command == "flash") {
-                Serial2.println("\n>>> REBOOTING INTO PROGRAMMING/DFU Mode... <<<");
-                delay(500); 
-                REG_WRITE(RTC_CNTL_OPTION1_REG, RTC_CNTL_FORCE_DOWNLOAD_BOOT);
-                ESP.restart();
-            }
-            // --- VIRTUAL LOGIC PROBE (ONLY IN GPIO MODE) ---
-            else if (command.startsWith("gp")) {
-                if (current_mode != MODE_GPIO) {
-                    Serial2.println(">>> ERROR: Command available ONLY in 'gpio' mode. Type 'gpio' first.");
-                } else {
-                    String pinStr = command.substring(2);
-                    pinStr.trim();
-                    
-                    if (pinStr.length() > 0) {
-                        int pinNum = pinStr.toInt();
-                        
-                        if (pinNum >= 0 && pinNum <= 48) {
-                            
-                            // 1. Force refresh and print the TABLE NOW
-                            last_gpio_state = 0xFFFF; 
-                            run_gpio_diagnostics(); 
-
-                            // 2. Read the pin and print the RESULT BELOW the table
-                            int val = digitalRead(pinNum);
-                            Serial2.println("===========================");
-                            Serial2.printf(" 🔎 LOGIC PROBE: GPIO %02d \n", pinNum);
-                            Serial2.println("===========================");
-                            Serial2.printf(" STATE: %s \n", val ? "HIGH" : "LOW");
-                            Serial2.println("===========================\n");
-                            
-                        } else {
-                            Serial2.println("\n>>> ERROR: Invalid GPIO pin (0-48).");
-                        }
-                    } else {
-                        Serial2.println("\n>>> ERROR: Syntax is 'gp<number>' (e.g., gp10).");
-                    }
-                }
-            }
-            // --- MOUSE BENCHMARK (FLUIDITY TEST) ---
-            else if (command == "mousetest") {
-                if (!is_mouse_connected) {
-                    Serial2.println(">>> ERROR: No mouse detected. Connect a USB mouse before running the test.");
-                } else {
-                    Serial2.println("\n>>> 🐭 MOUSE BENCHMARK STARTED <<<");
-                    Serial2.println("Move the mouse around in circles on the pad quickly for 5 seconds...");
-                    
-                    int max_dx = 0;
-                    int max_dy = 0;
-                    unsigned long start_time = millis();
-                    
-                    // 5-second loop that drains USB packets
-                    while(millis() - start_time < 5000) {
-                        // Keep USB enumeration alive
-                        usb_host_client_handle_events(s_client, 1);
-                        
-                        pkt_t p;
-                        // Read from USB queue
-                        if (xQueueReceive(s_pkt_q, &p, 0) == pdTRUE) {
-                            int offset = (p.len >= 5) ? 1 : 0;
-                            int8_t dx = (int8_t)p.data[1 + offset];
-                            int8_t dy = (int8_t)p.data[2 + offset];
-                            
-                            // Record absolute maximum peaks
-                            if (abs(dx) > max_dx) max_dx = abs(dx);
-                            if (abs(dy) > max_dy) max_dy = abs(dy);
-                        }
-                    }
-                    
-                    // Print Diagnosis
-                    Serial2.println("\n=======================================");
-                    Serial2.println(" 📊 MOUSE BENCHMARK RESULTS ");
-                    Serial2.println("=======================================");
-                    Serial2.printf(" Max peak X: %d DPI per packet\n", max_dx);
-                    Serial2.printf(" Max peak Y: %d DPI per packet\n", max_dy);
-                    Serial2.println("---------------------------------------");
-                    
-                    if (max_dx < 15) {
-                        Serial2.println(" 🎯 Diagnosis: PERFECT Mouse (Retro-Friendly).");
-                        Serial2.println("    No divider needed (dpi_divider = 1.0).");
-                    } 
-                    else if (max_dx < 35) {
-                        Serial2.println(" ⚠️ Diagnosis: AVERAGE Mouse.");
-                        Serial2.println("    Recommended: dpi_divider = 2.0");
-                    } 
-                    else if (max_dx < 80) {
-                        Serial2.println(" 🏎️ Diagnosis: FAST Mouse.");
-                        Serial2.println("    Recommended: dpi_divider = 3.0 or 4.0");
-                    } 
-                    else {
-                        Serial2.println(" 🚀 Diagnosis: GAMING Mouse (Ultra-High DPI).");
-                        Serial2.println("    Recommended: dpi_divider = 5.0 or higher!");
-                    }
-                    Serial2.println("=======================================\n");
-                }
-            }
-            else {
-                Serial2.println(">>> Unknown command. Type 'service' for help.");
-            }
-        } 
+        return true;
     } 
+    else if (cmd_state == CMD_WAIT_NAME_IMPORT) {
+        strlcpy(sniff_profile_name, input, sizeof(sniff_profile_name));
+        cmd_state = CMD_IDLE; 
+        execute_html_dump(); 
+        return true;
+    } 
+    else if (cmd_state == CMD_WAIT_NAME_MANUAL) {
+        strlcpy(sniff_profile_name, input, sizeof(sniff_profile_name));
+        cmd_state = CMD_IDLE; 
+        current_mode = MODE_SNIFFER; 
+        reset_sniffer(); 
+        xQueueReset(s_pkt_q); 
+        Serial2.println("\n>>> WIZARD ARMED! <<<");
+        Serial2.println("⏳ Waiting for neutral position calibration... (DO NOT touch the gamepad)"); 
+        Serial2.println("If nothing happens within 2 seconds, press and release a button to 'wake' it."); 
+        return true;
+    }
+    else if (cmd_state == CMD_WAIT_NAME_AUTO) {
+        strlcpy(sniff_profile_name, input, sizeof(sniff_profile_name));
+        cmd_state = CMD_IDLE; 
+        current_mode = MODE_AUTOPROFILE; 
+        reset_autoprofiler(); 
+        xQueueReset(s_pkt_q); 
+        Serial2.println("\n>>> AUTO-PROFILER ARMED! <<<");
+        Serial2.println("⏳ Hands off: measuring the neutral state... (DO NOT touch the gamepad)"); 
+        Serial2.println("If nothing happens within 2 seconds, press and release a button to 'wake' it."); 
+        return true;
+    }
+    return false;
+}
+
+// --- COMMAND HANDLERS ---
+inline void cmd_service(const char *arg) {
+    current_mode = MODE_SERVICE;
+    Serial2.println("\n=== 🛠️  SERVICE MENU  🛠️ ==="); 
+    Serial2.printf("  ⚙️  ENGINE: %s\n", use_html_configurator ? "HTML HID Configurator" : "Internal Profiler"); 
+    Serial2.println("--------------------------------");
+    Serial2.println(" 🪄 'new'     : Map a new pad or Auto-Import HTML"); 
+    Serial2.println(" 📊 'auto'    : Auto-profile a new pad from free play"); 
+    Serial2.println(" 👁️ 'raw'     : Show raw USB hex data stream"); 
+    Serial2.println(" 🎮 'test'    : Test logical buttons mapping (Up, Fire...)"); 
+    Serial2.println(" 🐭 'mousetest': Mouse speed and Packets"); 
+    Serial2.println(" ⏱️ 'lag'     : Measure USB Polling Rate and Input Lag"); 
+    Serial2.println(" 🎛️ 'gpio'    : Real-time dashboard of hardware states"); 
+    Serial2.println(" 🎨 'color'   : Live RGB Color Mixer (Use gamepad)");  
+    Serial2.println(" 🎛️ 'paddle'  : Toggle Paddle / duty-cycle stick mode");
+    Serial2.println(" 🎮 'cd32'    : Toggle Amiga CD32 7-button pad mode");
+    Serial2.println(" 🖱️ 'stickmouse': Toggle analog stick -> 1351 / Amiga mouse pointer");
+    Serial2.println(" ⏱️ 'boot'    : Boot trace and power-on -> first report time");
+    Serial2.println(" 🔌 'usb'     : List the connected USB devices (hub)");
+    Serial2.println(" 🔀 'route'   : Toggle multi-device routing (OR / PRIORITY)");
+    Serial2.println(" 🔀 'mux'     : Cycle multitap port merge (OR / PRIORITY / SELECT)");
+    Serial2.println(" 🧹 'debounce': Cycle glitch filter (OFF / FAST / FULL)");
+    Serial2.println(" 📦 'mem'     : Memory budget per subsystem and heap use since boot");
+    Serial2.println(" 📈 'top'     : Live CPU % per task, free stack and ISR time");
+    Serial2.println(" ⏱️ 'bench'   : Decoder cycle counts on synthetic reports (CSV)");
+    Serial2.println(" 📍 'edges'   : Timestamps DB9 line changes, USB report -> pin latency");
+    Serial2.println(" 🔋 'power'   : Power governor benchmark (idle % vs lag)");
+    Serial2.println(" 📡 'telemetry': Binary live stream for tools/telemetry_viewer");
+    Serial2.println(" 💉 'inject'  : Drive the DB9 from timed frames sent by a PC");
+    Serial2.println(" 🔄 'reboot'  : Restart the device softly");
+    Serial2.println(" ⚡ 'flash'   : Reboot into Programming/DFU Mode"); 
+    Serial2.println(" 🚪 'exit'    : Exit menu and return to normal play"); 
+    Serial2.println("================================\n");
+}
+
+inline void cmd_new(const char *arg) {
+    if (device_connected && use_html_configurator) { 
+        Serial2.println("\n>>> HTML Profile detected! Do you want to Auto-Import it? (Y/N)");
+        cmd_state = CMD_WAIT_IMPORT; 
+    } else {
+        Serial2.print("\n>>> Enter a NAME for the new manual profile: ");
+        cmd_state = CMD_WAIT_NAME_MANUAL; 
+    }
+}
+
+inline void cmd_auto(const char *arg) {
+    Serial2.print("\n>>> Enter a NAME for the new auto profile: ");
+    cmd_state = CMD_WAIT_NAME_AUTO; 
+}
+
+inline void cmd_raw(const char *arg)  { current_mode = MODE_RAW; Serial2.println(">>> RAW mode active!"); }
+inline void cmd_test(const char *arg) { current_mode = MODE_DEBUG; Serial2.println(">>> TEST mode active!"); }
+
+inline void cmd_gpio(const char *arg) {
+    current_mode = MODE_GPIO;
+    last_gpio_state = 0xFFFF; 
+    Serial2.println(">>> Starting GPIO Dashboard..."); 
+}
+
+inline void cmd_lag(const char *arg) {
+    current_mode = MODE_POLLING;
+    polling_packet_count = 0; 
+    polling_start_time = 0; 
+    polling_neutral_saved = false; 
+    polling_active = true;
+    
+    Serial2.println("\n>>> Starting Polling Tester (Smart Trigger)... <<<"); 
+    Serial2.printf("Connected device: %s (VID:%04x PID:%04x)\n\n", device_connected ? (use_html_configurator ? "HTML Config Pad" : current_profile.name) : "None", connected_vid, connected_pid); 
+    if (!device_connected) {
+        Serial2.println("⚠️ No gamepad connected! Connect a pad and try again."); 
+        current_mode = MODE_SERVICE;
+    } else {
+        Serial2.println("🕹️  Timer is waiting... Move the stick and press buttons to trigger it!"); 
+    }
+}
+
+inline void cmd_color(const char *arg) {
+    current_mode = MODE_COLOR_MIXER;
+    cmd_state = CMD_WAIT_COLOR_CHOICE; 
+    
+    Serial2.println("\n=== LED COLOR TEST MENU ===");
+    Serial2.println("Select a color to test on your WS2812B:\n"); 
+    Serial2.println("[ SYSTEM STATES ]");
+    Serial2.println("1.  Amiga Idle     (White)"); 
+    Serial2.println("2.  C64 Idle       (Orange)");
+    Serial2.println("3.  HTML Config    (Green)\n"); 
+    Serial2.println("[ DIRECTIONAL PAD ]");
+    Serial2.println("4.  D-Pad Up       (Bright Purple)"); 
+    Serial2.println("5.  D-Pad Right    (Purple)");
+    Serial2.println("6.  D-Pad Down     (Very Dark Purple)"); 
+    Serial2.println("7.  D-Pad Left     (Dark Purple)");
+    Serial2.println("8.  D-Pad Idle     (Dark)\n"); 
+    Serial2.println("[ ACTION BUTTONS ]");
+    Serial2.println("9.  Fire 1         (Green)"); 
+    Serial2.println("10. Fire 2         (Red)"); 
+    Serial2.println("11. Fire 3         (Cyan)"); 
+    Serial2.println("12. Up Alt         (Blue)"); 
+    Serial2.println("13. Autofire       (Yellow)\n"); 
+    
+    Serial2.println("Type a number (1-13) to set the color.");
+    Serial2.println("Type 'exit' to return to the Service Menu.\n"); 
+    
+    Serial2.println("[!] LIVE BRIGHTNESS CONTROL:"); 
+    Serial2.println("Move your connected gamepad UP or DOWN to adjust the LED brightness dynamically!");
+    Serial2.println("[!] LIVE RGB COLOR TWEAKING:"); 
+    Serial2.println("Press FIRE 1 to switch between R, G, B channels, and move LEFT or RIGHT to change the color value!"); 
+    Serial2.println("Press FIRE 2 to print the final C++ code.");
+    Serial2.println("==========================="); 
+}
+
+inline void cmd_exit(const char *arg) {
+    current_mode = MODE_PLAY;
+    led_brightness_request = 40;
+    cli_wait_loop(led_brightness_request);
+    Serial2.println("\n\n>>> PLAY mode (Zero-Lag) restored! Normal operation resumed. <<<");
+}
+
+inline bool cli_request_output_mode(OutputMode mode) {
+    output_mode_request = mode;
+    return cli_wait_loop(output_mode_request);
+}
+
+inline void cmd_paddle(const char *arg) {
+    if (!cli_request_output_mode(active_output_mode == OUT_PADDLE ? OUT_JOYSTICK : OUT_PADDLE)) return;
+    if (active_output_mode == OUT_PADDLE) {
+        Serial2.printf(">>> PADDLE mode active! Analog stick -> %s\n", is_amiga ? "Amiga duty-cycle joystick (digital lines)" : "C64 POT X / POT Y (Fire 1/2 -> paddle buttons)");
+    } else {
+        Serial2.println(">>> JOYSTICK mode restored (8-way digital).");
+    }
+}
+
+inline void cmd_cd32(const char *arg) {
+    if (!is_amiga) {
+        Serial2.println(">>> ERROR: CD32 pad mode is available ONLY in Amiga mode.");
+    } else {
+        if (!cli_request_output_mode(active_output_mode == OUT_CD32 ? OUT_JOYSTICK : OUT_CD32)) return;
+        Serial2.println(active_output_mode == OUT_CD32 ? ">>> CD32 PAD mode active! (Pin 5 = mode, Pin 6 = clock, Pin 9 = data)" : ">>> JOYSTICK mode restored (2-button Amiga).");
+    }
+}
+
+inline void cmd_stickmouse(const char *arg) {
+    if (!cli_request_output_mode(active_output_mode == OUT_MOUSE ? OUT_JOYSTICK : OUT_MOUSE)) return;
+    if (active_output_mode == OUT_MOUSE) {
+        Serial2.printf(">>> STICK MOUSE mode active! Analog stick -> %s pointer, %d Hz integrator, up to %d counts/s (speed %u)\n",
+                       is_amiga ? "Amiga quadrature" : "C64 1351", STICK_MOUSE_HZ, STICK_MOUSE_MAX_CPS, is_amiga ? mouse_speed_amiga : mouse_speed_c64);
+        Serial2.println("    Fire 1 = left button, Fire 2 = right button, Fire 3 = middle button");
+    } else {
+        Serial2.println(">>> JOYSTICK mode restored (8-way digital).");
+    }
+}
+
+inline void cmd_boot(const char *arg) { print_boot_trace(); }
+inline void cmd_usb(const char *arg)  { print_usb_devices(); }
+
+inline void cmd_mux(const char *arg) {
+    mux_mode = (MuxMode)((mux_mode + 1) % 3);
+    const char *names[] = { "OR (every port drives the DB9)", "PRIORITY (active port with the lowest report ID wins)", "SELECT (port that pressed START/PLAY)" };
+    Serial2.printf(">>> MULTITAP MERGE: %s\n", names[mux_mode]);
+}
+
+inline void cmd_debounce(const char *arg) {
+    debounce_mode = (DebounceMode)((debounce_mode + 1) % 3);
+    const char *names[] = { "OFF (reports go straight to the pins)", "FAST (zero-latency presses, release blips filtered)", "FULL (presses and releases filtered)" };
+    Serial2.printf(">>> GLITCH FILTER: %s\n", names[debounce_mode]);
+    Serial2.println(">>> Suppressed glitches per device: type 'usb'.");
+}
+
+inline void cmd_route(const char *arg) {
+    route_mode = (route_mode == ROUTE_OR) ? ROUTE_PRIORITY : ROUTE_OR;
+    Serial2.println(route_mode == ROUTE_OR ? ">>> ROUTING: OR (co-pilot, every device drives the port)" : ">>> ROUTING: PRIORITY (first active device owns the port, mouse first)");
+}
+
+inline void cmd_amiga(const char *arg) { console_mode_request = 1; cli_wait_loop(console_mode_request); }
+inline void cmd_c64(const char *arg)   { console_mode_request = 0; cli_wait_loop(console_mode_request); }
+
+inline void cmd_reboot(const char *arg) {
+    Serial2.println("\n>>> REBOOTING DEVICE... <<<");
+    delay(500); 
+    ESP.restart();
+}
+
+inline void cmd_flash(const char *arg) {
+    Serial2.println("\n>>> REBOOTING INTO PROGRAMMING/DFU Mode... <<<");
+    delay(500); 
+    REG_WRITE(RTC_CNTL_OPTION1_REG, RTC_CNTL_FORCE_DOWNLOAD_BOOT);
+    ESP.restart();
+}
+
+// --- VIRTUAL LOGIC PROBE (ONLY IN GPIO MODE) ---
+inline void cmd_gp(const char *arg) {
+    if (current_mode != MODE_GPIO) {
+        Serial2.println(">>> ERROR: Command available ONLY in 'gpio' mode. Type 'gpio' first.");
+        return;
+    }
+    if (*arg == '\0') {
+        Serial2.println("\n>>> ERROR: Syntax is 'gp<number>' (e.g., gp10).");
+        return;
+    }
+
+    int pinNum = atoi(arg);
+    if (pinNum >= 0 && pinNum <= 48) {
+        
+        // 1. Force refresh and print the TABLE NOW (the loop draws it, past the rate limit)
+        gpio_redraw_request = true;
+        uint32_t t0 = millis();
+        while (gpio_redraw_request && millis() - t0 < 1000) vTaskDelay(pdMS_TO_TICKS(2));
+
+        // 2. Read the pin and print the RESULT BELOW the table
+        int val = digitalRead(pinNum);
+        Serial2.println("===========================");
+        Serial2.printf(" 🔎 LOGIC PROBE: GPIO %02d \n", pinNum);
+        Serial2.println("===========================");
+        Serial2.printf(" STATE: %s \n", val ? "HIGH" : "LOW");
+        Serial2.println("===========================\n");
+        
+    } else {
+        Serial2.println("\n>>> ERROR: Invalid GPIO pin (0-48).");
+    }
+}
+
+// --- MOUSE BENCHMARK (FLUIDITY TEST) ---
+inline void cmd_mousetest(const char *arg) {
+    if (!is_mouse_connected) {
+        Serial2.println(">>> ERROR: No mouse detected. Connect a USB mouse before running the test.");
+        return;
+    }
+    Serial2.println("\n>>> 🐭 MOUSE BENCHMARK STARTED <<<");
+    Serial2.println("Move the mouse around in circles on the pad quickly for 5 seconds...");
+    
+    // The packet loop records the absolute peaks while the flag is set
+    mouse_bench_max_dx = 0;
+    mouse_bench_max_dy = 0;
+    mouse_bench_active = true;
+    vTaskDelay(pdMS_TO_TICKS(5000));
+    mouse_bench_active = false;
+    int max_dx = mouse_bench_max_dx;
+    int max_dy = mouse_bench_max_dy;
+    
+    // Print Diagnosis
+    Serial2.println("\n=======================================");
+    Serial2.println(" 📊 MOUSE BENCHMARK RESULTS ");
+    Serial2.println("=======================================");
+    Serial2.printf(" Max peak X: %d DPI per packet\n", max_dx);
+    Serial2.printf(" Max peak Y: %d DPI per packet\n", max_dy);
+    Serial2.println("---------------------------------------");
+    
+    if (max_dx < 15) {
+        Serial2.println(" 🎯 Diagnosis: PERFECT Mouse (Retro-Friendly).");
+        Serial2.println("    No divider needed (dpi_divider = 1.0).");
+    } 
+    else if (max_dx < 35) {
+        Serial2.println(" ⚠️ Diagnosis: AVERAGE Mouse.");
+        Serial2.println("    Recommended: dpi_divider = 2.0");
+    } 
+    else if (max_dx < 80) {
+        Serial2.println(" 🏎️ Diagnosis: FAST Mouse.");
+        Serial2.println("    Recommended: dpi_divider = 3.0 or 4.0");
+    } 
+    else {
+        Serial2.println(" 🚀 Diagnosis: GAMING Mouse (Ultra-High DPI).");
+        Serial2.println("    Recommended: dpi_divider = 5.0 or higher!");
+    }
+    Serial2.println("=======================================\n");
+}
+
+// --- POWER GOVERNOR BENCHMARK ---
+// 'power' measures the current mode, 'power max' / 'power auto' switch mode first
+inline void cmd_power(const char *arg) {
+    if (strcmp(arg, "max") == 0)       power_force_max = true;
+    else if (strcmp(arg, "auto") == 0) power_force_max = false;
+    else if (*arg) {
+        Serial2.println(">>> Usage: power [max|auto]");
+        return;
+    }
+    Serial2.printf("\n>>> 🔋 POWER BENCHMARK (%s) - play normally for 5 seconds...\n", power_force_max ? "MAX" : "AUTO");
+    run_power_benchmark(5000);
+}
+
+// --- BINARY TELEMETRY ---
+// 'telemetry [baud]' starts the stream, 'telemetry off' stops it
+inline void cmd_telemetry(const char *arg) {
+    if (strcmp(arg, "off") == 0) { telemetry_stop(); return; }
+    uint32_t baud = *arg ? strtoul(arg, nullptr, 10) : TELEMETRY_BAUD;
+    if (!telemetry_start(baud)) {
+        Serial2.println(">>> Usage: telemetry [115200|230400|460800|921600|1000000|2000000|off]");
+    }
+}
+
+// --- SERIAL INPUT INJECTION ---
+// 'inject [baud]' hands the DB9 to the binary frame stream (Inject.h) until the host sends INJ_EXIT
+inline void cmd_inject(const char *arg) {
+    uint32_t baud = *arg ? strtoul(arg, nullptr, 10) : TELEMETRY_BAUD;
+    if (baud != 115200 && baud != 230400 && baud != 460800 && baud != 921600 && baud != 1000000 && baud != 2000000) {
+        Serial2.println(">>> Usage: inject [115200|230400|460800|921600|1000000|2000000]");
+        return;
+    }
+    inject_start(baud);
+}
+
+// --- MEMORY BUDGET ---
+inline void cmd_mem(const char *arg) {
+    run_mem_report();
+}
+
+// --- TASK / ISR PROFILER ---
+inline void cmd_top(const char *arg) {
+    run_top();
+}
+
+// --- DB9 EDGE CAPTURE ---
+// 'edges [seconds]' captures while playing, 'edges sid [seconds]' adds the C64 SID timing lines,
+// 'edges dump' prints the last capture for tools/pin_sim
+inline void cmd_edges(const char *arg) {
+    if (strcmp(arg, "dump") == 0) { run_edges_dump(); return; }
+    bool sid = strncmp(arg, "sid", 3) == 0 && (arg[3] == 0 || arg[3] == ' ');
+    if (sid) arg += (arg[3] == ' ') ? 4 : 3;
+    uint32_t s = *arg ? strtoul(arg, nullptr, 10) : EDGE_CAPTURE_S;
+    if (s < 1 || s > 120) {
+        Serial2.println(">>> Usage: edges [sid] [1-120] | edges dump");
+        return;
+    }
+    run_edges(s, sid);
+}
+
+// --- DECODER MICRO-BENCHMARK ---
+// The loop runs it (Bench.h) between two reports; this task only waits for the CSV to be printed
+inline void cmd_bench(const char *arg) {
+    Serial2.println("\n>>> ⏱️ BENCHMARK: synthetic reports through every decoder (pins stubbed)...");
+    bench_request = true;
+    uint32_t t0 = millis();
+    while (bench_request && millis() - t0 < 10000) vTaskDelay(pdMS_TO_TICKS(10));
+    if (bench_request) Serial2.println(">>> ERROR: The main loop did not run the benchmark.");
+}
+
+// --- COMMAND TABLE ---
+typedef void (*CliHandler)(const char *arg);
+
+#define CLI_ANY_MODE 0x01  // Accepted during normal play too
+#define CLI_PREFIX   0x02  // Name is a prefix, the rest of the line is the argument
+
+struct CliCommand {
+    const char *name;
+    CliHandler fn;
+    uint8_t flags;
+};
+
+static const CliCommand CLI_COMMANDS[] = {
+    { "service",   cmd_service,   CLI_ANY_MODE },
+    { "exit",      cmd_exit,      CLI_ANY_MODE },
+    { "new",       cmd_new,       0 },
+    { "auto",      cmd_auto,      0 },
+    { "raw",       cmd_raw,       0 },
+    { "test",      cmd_test,      0 },
+    { "gpio",      cmd_gpio,      0 },
+    { "lag",       cmd_lag,       0 },
+    { "color",     cmd_color,     0 },
+    { "paddle",    cmd_paddle,    0 },
+    { "cd32",      cmd_cd32,      0 },
+    { "stickmouse", cmd_stickmouse, 0 },
+    { "boot",      cmd_boot,      0 },
+    { "usb",       cmd_usb,       0 },
+    { "mux",       cmd_mux,       0 },
+    { "debounce",  cmd_debounce,  0 },
+    { "route",     cmd_route,     0 },
+    { "amiga",     cmd_amiga,     0 },
+    { "c64",       cmd_c64,       0 },
+    { "reboot",    cmd_reboot,    0 },
+    { "flash",     cmd_flash,     0 },
+    { "mousetest", cmd_mousetest, 0 },
+    { "top",       cmd_top,       0 },
+    { "mem",       cmd_mem,       CLI_ANY_MODE },
+    { "bench",     cmd_bench,     0 },
+    { "edges",     cmd_edges,     CLI_ANY_MODE | CLI_PREFIX },
+    { "power",     cmd_power,     CLI_ANY_MODE | CLI_PREFIX },
+    { "telemetry", cmd_telemetry, CLI_ANY_MODE | CLI_PREFIX },
+    { "inject",    cmd_inject,    CLI_PREFIX },
+    { "gp",        cmd_gp,        CLI_PREFIX },
+};
+static const int NUM_CLI_COMMANDS = sizeof(CLI_COMMANDS) / sizeof(CliCommand);
+
+inline void cli_dispatch(char *command) {
+    for (char *c = command; *c; c++) *c = tolower((unsigned char)*c);
+
+    for (int i = 0; i < NUM_CLI_COMMANDS; i++) {
+        const CliCommand &cmd = CLI_COMMANDS[i];
+        const char *arg = "";
+        if (cmd.flags & CLI_PREFIX) {
+            size_t n = strlen(cmd.name);
+            if (strncmp(command, cmd.name, n) != 0) continue;
+            arg = cli_trim(command + n);
+        } else if (strcmp(command, cmd.name) != 0) {
+            continue;
+        }
+
+        // Service commands are ignored during normal play
+        if (current_mode == MODE_PLAY && !(cmd.flags & CLI_ANY_MODE)) return;
+        cmd.fn(arg);
+        return;
+    }
+
+    if (current_mode != MODE_PLAY) Serial2.println(">>> Unknown command. Type 'service' for help.");
+}
+
+inline void handleServiceMenu() {
+    while (cli_read_line()) {
+        char *input = cli_trim(cli_line);
+        if (*input == '\0') continue;
+        if (cli_handle_prompt(input)) continue;
+        cli_dispatch(input);
+    }
+}
+
+// Low-priority CLI task: typing in the terminal never delays the USB -> DB9 loop
+void service_task(void *arg) {
+    while (true) {
+        // Inject mode reads binary frames and polls every tick to keep its queue ahead of the clock
+        if (current_mode == MODE_INJECT) {
+            inject_service();
+            vTaskDelay(1);
+        } else {
+            handleServiceMenu();
+            vTaskDelay(pdMS_TO_TICKS(CLI_POLL_MS));
+        }
+    }
 }
\ No newline at end of file
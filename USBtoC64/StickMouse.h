@@ -0,0 +1,125 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: StickMouse.h
+// Description: Analog stick as a mouse (OUT_MOUSE): fixed-rate velocity integrator feeding the 1351 / quadrature engines
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "Globals.h"
+
+// ==========================================
+// 📈 PART 1: VELOCITY TABLE
+// ==========================================
+// Deflection (0-127) -> mouse counts per integrator tick in Q16 fixed point, deadzone and curve
+// included, built once at boot. Full deflection = STICK_MOUSE_MAX_CPS counts per second.
+
+#define SM_Q16 65536
+static int32_t sm_speed_lut[128];
+
+inline void build_stick_mouse_table() {
+    const float full = (float)STICK_MOUSE_MAX_CPS * (float)SM_Q16 / (float)STICK_MOUSE_HZ;
+    for (int mag = 0; mag < 128; mag++) {
+        float n = 0.0f;
+        if (mag > STICK_MOUSE_DEADZONE) {
+            n = (float)(mag - STICK_MOUSE_DEADZONE) / (float)(127 - STICK_MOUSE_DEADZONE);
+            if (STICK_MOUSE_CURVE_EXP == 2) n = n * n;
+        }
+        sm_speed_lut[mag] = (int32_t)(n * full + 0.5f);
+    }
+}
+
+// Raw axis byte (128 = centre) -> signed Q16 velocity
+inline int32_t sm_velocity(uint8_t raw) {
+    int v = (int)raw - 128;
+    int mag = v < 0 ? -v : v;
+    if (mag > 127) mag = 127;
+    return v < 0 ? -sm_speed_lut[mag] : sm_speed_lut[mag];
+}
+
+
+// ==========================================
+// ⏱️ PART 2: FIXED-RATE INTEGRATOR (esp_timer TASK)
+// ==========================================
+// The decoder only stores the latest velocity; the timer adds it to the position every tick, so
+// a held stick keeps moving between reports and a fast pad does not move faster. The loop takes
+// the whole counts and leaves the fraction for the next tick.
+
+static volatile int32_t sm_vel_x = 0, sm_vel_y = 0;   // Q16 counts per tick
+static int32_t sm_acc_x = 0, sm_acc_y = 0;            // Q16 counts not yet sent to the port
+static portMUX_TYPE sm_mux = portMUX_INITIALIZER_UNLOCKED;
+static const DevState *sm_owner = nullptr;            // Pad whose stick is moving the pointer
+static esp_timer_handle_t sm_timer = nullptr;
+static bool sm_running = false;
+
+#define SM_ACC_LIMIT (127 * SM_Q16) // One loop pass never owes more than a full mouse report
+
+static void sm_tick(void *) {
+    portENTER_CRITICAL(&sm_mux);
+    int32_t x = sm_acc_x + sm_vel_x, y = sm_acc_y + sm_vel_y;
+    sm_acc_x = constrain(x, -SM_ACC_LIMIT, SM_ACC_LIMIT);
+    sm_acc_y = constrain(y, -SM_ACC_LIMIT, SM_ACC_LIMIT);
+    portEXIT_CRITICAL(&sm_mux);
+}
+
+inline void stick_mouse_stop() {
+    portENTER_CRITICAL(&sm_mux);
+    sm_vel_x = 0; sm_vel_y = 0;
+    sm_acc_x = 0; sm_acc_y = 0;
+    portEXIT_CRITICAL(&sm_mux);
+    sm_owner = nullptr;
+}
+
+// Setup: the timer is created once, before the memory budget is sealed
+inline void stick_mouse_init() {
+    esp_timer_create_args_t args = {};
+    args.callback = &sm_tick;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "stick_mouse";
+    args.skip_unhandled_events = true;
+    if (esp_timer_create(&args, &sm_timer) != ESP_OK) sm_timer = nullptr;
+}
+
+// set_output_mode(): the timer only runs in OUT_MOUSE
+inline void stick_mouse_enable(bool on) {
+    if (on == sm_running || !sm_timer) return;
+    stick_mouse_stop();
+    if (on) esp_timer_start_periodic(sm_timer, 1000000ULL / STICK_MOUSE_HZ);
+    else    esp_timer_stop(sm_timer);
+    sm_running = on;
+}
+
+
+// ==========================================
+// 🎚️ PART 3: DECODER AND LOOP SIDES
+// ==========================================
+
+// Decoder, once per report. The last pad to move its stick owns the pointer, so the keepalive
+// reports of an idle second pad do not stop it. The D-Pad stands in for a centred stick.
+inline void stick_mouse_update(const DevState *ds, uint8_t raw_x, uint8_t raw_y, bool l, bool r, bool u, bool d) {
+    if (l != r) raw_x = (uint8_t)(128 + (l ? -STICK_MOUSE_DPAD_DEFL : STICK_MOUSE_DPAD_DEFL));
+    if (u != d) raw_y = (uint8_t)(128 + (u ? -STICK_MOUSE_DPAD_DEFL : STICK_MOUSE_DPAD_DEFL));
+    int32_t vx = sm_velocity(raw_x), vy = sm_velocity(raw_y);
+    bool moving = (vx | vy) != 0;
+    if (!moving && sm_owner != ds) return;
+    sm_owner = moving ? ds : nullptr;
+    sm_vel_x = vx;
+    sm_vel_y = vy;
+}
+
+// Its pad was unplugged
+inline void stick_mouse_release(const DevState *ds) {
+    if (sm_owner == ds) stick_mouse_stop();
+}
+
+// Loop: whole counts since the last call (truncated towards zero, the fraction stays)
+inline bool stick_mouse_take(int8_t &dx, int8_t &dy) {
+    portENTER_CRITICAL(&sm_mux);
+    int32_t ix = sm_acc_x / SM_Q16, iy = sm_acc_y / SM_Q16;
+    sm_acc_x -= ix * SM_Q16;
+    sm_acc_y -= iy * SM_Q16;
+    portEXIT_CRITICAL(&sm_mux);
+    dx = (int8_t)ix; dy = (int8_t)iy;
+    return (ix | iy) != 0;
+}
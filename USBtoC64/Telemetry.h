@@ -0,0 +1,126 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: Telemetry.h
+// Description: Streaming binary telemetry on Serial2 (frames in TelemetryProtocol.h)
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include "Globals.h"
+#include "TelemetryProtocol.h"
+
+// ==========================================
+// 📡 PART 1: STATE
+// ==========================================
+// The loop builds one frame per pass that handled reports (plus a heartbeat), and only
+// writes it when the UART has room for the whole frame: the stream never stalls the pins.
+
+static volatile bool telem_active = false;
+static uint16_t telem_seq = 0;
+static uint8_t  telem_drops = 0;
+static uint32_t telem_last_ms = 0;
+static uint16_t telem_reports = 0;
+static int32_t  telem_mouse_dx = 0;   // Summed by the mouse path of process_usb_packet()
+static int32_t  telem_mouse_dy = 0;
+
+inline bool telemetry_baud_ok(uint32_t baud) {
+    return baud == 115200 || baud == 230400 || baud == 460800 || baud == 921600 || baud == 1000000 || baud == 2000000;
+}
+
+inline uint8_t telemetry_read_pins() {
+    uint8_t pins = 0;
+    if (!digitalRead(GP_UP))    pins |= TELEM_PIN_UP;
+    if (!digitalRead(GP_DOWN))  pins |= TELEM_PIN_DOWN;
+    if (!digitalRead(GP_LEFT))  pins |= TELEM_PIN_LEFT;
+    if (!digitalRead(GP_RIGHT)) pins |= TELEM_PIN_RIGHT;
+    if (!digitalRead(GP_FIRE1)) pins |= TELEM_PIN_FIRE1;
+    // C64 POT fire lines are active HIGH (Hardware.h)
+    if (digitalRead(GP_FIRE2) == (is_amiga ? LOW : HIGH)) pins |= TELEM_PIN_FIRE2;
+    if (digitalRead(GP_POTY) == (is_amiga ? LOW : HIGH))  pins |= TELEM_PIN_POTY;
+    if (!is_amiga && !digitalRead(GP_C64_SIG_MODE_SW)) pins |= TELEM_PIN_C64_SIG;
+    return pins;
+}
+
+inline uint16_t telem_sat_us(uint32_t us) {
+    return us > 65535 ? 65535 : (uint16_t)us;
+}
+
+inline int16_t telem_sat16(int32_t v) {
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+
+// ==========================================
+// 📤 PART 2: FRAME OUTPUT
+// ==========================================
+
+// Called by the loop after the pins were written.
+// t_first_us = arrival of the oldest report of this pass, t_deq_us = when the loop woke up.
+inline void telemetry_update(int reports, uint32_t t_first_us, uint32_t t_deq_us) {
+    if (!telem_active) return;
+    telem_reports += reports;
+    if (!reports && millis() - telem_last_ms < TELEMETRY_HEARTBEAT_MS) return;
+
+    uint8_t frame[TELEM_HEADER_LEN + sizeof(TelemState) + TELEM_CRC_LEN];
+    TelemState st;
+    uint32_t now = micros();
+    st.t_us = now;
+    st.word = joy_word;
+    st.pins = telemetry_read_pins();
+    st.mode = (uint8_t)current_mode;
+    st.lat_queue_us = reports ? telem_sat_us(t_deq_us - t_first_us) : 0;
+    st.lat_pins_us  = reports ? telem_sat_us(now - t_deq_us) : 0;
+    st.mouse_dx = telem_sat16(telem_mouse_dx);
+    st.mouse_dy = telem_sat16(telem_mouse_dy);
+    st.reports = telem_reports > 255 ? 255 : telem_reports;
+    st.drops = telem_drops;
+    st.flags = (is_amiga ? TELEM_FLAG_AMIGA : 0) | (device_connected ? TELEM_FLAG_DEVICE : 0) | (is_mouse_connected ? TELEM_FLAG_MOUSE : 0);
+
+    // Frames are dropped, never queued: a stale sample is worth less than on-time pins
+    if (Serial2.availableForWrite() < (int)sizeof(frame)) {
+        if (telem_drops < 255) telem_drops++;
+        return;
+    }
+
+    telem_build_frame(frame, TELEM_TYPE_STATE, telem_seq, &st, sizeof(st));
+    Serial2.write(frame, sizeof(frame));
+
+    telem_seq++;
+    telem_drops = 0;
+    telem_reports = 0;
+    telem_mouse_dx = 0;
+    telem_mouse_dy = 0;
+    telem_last_ms = millis();
+}
+
+
+// ==========================================
+// 🎛️ PART 3: START / STOP (service task)
+// ==========================================
+
+bool telemetry_start(uint32_t baud) {
+    if (!telemetry_baud_ok(baud)) return false;
+    Serial2.printf("\n>>> 📡 TELEMETRY ON @ %lu baud. Reconnect the terminal or start tools/telemetry_viewer.\n", (unsigned long)baud);
+    Serial2.println(">>> Send 'telemetry off' (at the new speed) to go back to text.");
+    Serial2.flush();
+    Serial2.updateBaudRate(baud);
+    telem_seq = 0;
+    telem_drops = 0;
+    telem_reports = 0;
+    telem_mouse_dx = 0;
+    telem_mouse_dy = 0;
+    telem_active = true;
+    return true;
+}
+
+void telemetry_stop() {
+    if (!telem_active) {
+        Serial2.println(">>> Telemetry is not running.");
+        return;
+    }
+    telem_active = false;
+    vTaskDelay(pdMS_TO_TICKS(5)); // Let the loop finish a frame in flight
+    Serial2.flush();
+    Serial2.updateBaudRate(115200);
+    Serial2.println("\n>>> 📡 TELEMETRY OFF. Back to 115200 baud text.");
+}
@@ -0,0 +1,147 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: TelemetryProtocol.h
+// Description: Binary frame layout for 'telemetry' and 'inject', shared by the firmware and the host tools
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Frame on the wire, both directions (all fields little-endian):
+//   [0xA5][0x5A][type][len][seq lo][seq hi][payload: len bytes][crc lo][crc hi]
+// The CRC (CRC-16/CCITT-FALSE) covers type .. payload. A receiver hunts for the sync pair,
+// so text printed by the firmware in between is simply skipped.
+
+#define TELEM_SYNC0        0xA5
+#define TELEM_SYNC1        0x5A
+#define TELEM_HEADER_LEN   6
+#define TELEM_CRC_LEN      2
+#define TELEM_MAX_PAYLOAD  64
+
+// Adapter -> host
+#define TELEM_TYPE_STATE       0x01  // TelemState ('telemetry')
+#define TELEM_TYPE_INJ_STATUS  0x81  // InjStatus ('inject')
+// Host -> adapter ('inject' mode)
+#define TELEM_TYPE_INJ_FRAMES  0x10  // 1..10 InjFrame back to back
+#define TELEM_TYPE_INJ_SYNC    0x11  // uint32 tag, answered at once with an InjStatus carrying it
+#define TELEM_TYPE_INJ_RESET   0x12  // Empty: drop queued frames, release the lines, clock back to 0
+#define TELEM_TYPE_INJ_END     0x13  // Empty: no more frames, an empty queue is no longer an underrun
+#define TELEM_TYPE_INJ_EXIT    0x14  // Empty: leave inject mode (back to 115200 text)
+
+// TelemState.pins: DB9 lines, bit set = line active. Active = pulled LOW, except the C64 POT fire
+// lines (FIRE2 / POTY), which are driven HIGH when pressed. In the C64 analog modes those two
+// carry SID timing and their bit is just a sample.
+#define TELEM_PIN_UP       (1 << 0)
+#define TELEM_PIN_DOWN     (1 << 1)
+#define TELEM_PIN_LEFT     (1 << 2)
+#define TELEM_PIN_RIGHT    (1 << 3)
+#define TELEM_PIN_FIRE1    (1 << 4)
+#define TELEM_PIN_FIRE2    (1 << 5)
+#define TELEM_PIN_POTY     (1 << 6)  // Fire 3 / CD32 mode line
+#define TELEM_PIN_C64_SIG  (1 << 7)
+
+// TelemState.flags
+#define TELEM_FLAG_AMIGA   (1 << 0)
+#define TELEM_FLAG_DEVICE  (1 << 1)  // A pad / keyboard is connected
+#define TELEM_FLAG_MOUSE   (1 << 2)
+
+#pragma pack(push, 1)
+struct TelemState {
+    uint32_t t_us;          // micros() when the pins were written
+    uint16_t word;          // Logical JS_* word driving the port
+    uint8_t  pins;          // TELEM_PIN_* bits
+    uint8_t  mode;          // SystemMode
+    uint16_t lat_queue_us;  // Oldest report: USB arrival -> loop dequeue
+    uint16_t lat_pins_us;   // Loop dequeue -> pins written
+    int16_t  mouse_dx;      // Mouse movement summed since the previous frame
+    int16_t  mouse_dy;
+    uint8_t  reports;       // Reports handled since the previous frame (saturates at 255)
+    uint8_t  drops;         // Frames dropped because the UART was full (saturates at 255)
+    uint8_t  flags;         // TELEM_FLAG_*
+};
+
+// One scripted controller state, applied by a hardware timer when the inject clock reaches t_us
+struct InjFrame {
+    uint32_t t_us;          // Inject clock (us since the last RESET / 'inject')
+    uint16_t word;          // Logical JS_* word
+};
+
+struct InjStatus {
+    uint32_t clock_us;      // Inject clock when the status was sent
+    uint32_t tag;           // Echo of the last INJ_SYNC tag
+    uint16_t ring_free;     // Frames the adapter can still queue
+    uint16_t ring_size;
+    uint32_t applied;       // Frames written to the pins since the last RESET
+    uint32_t underruns;     // Queue ran dry before INJ_END
+    uint32_t overruns;      // Frames lost because the queue was full
+    uint32_t late;          // Frames received after their time (applied at once)
+    uint32_t max_late_us;
+};
+#pragma pack(pop)
+
+#define TELEM_INJ_MAX_FRAMES (TELEM_MAX_PAYLOAD / sizeof(InjFrame))
+
+inline uint16_t telem_crc16(const uint8_t *p, size_t n, uint16_t crc = 0xFFFF) {
+    while (n--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+// Byte-at-a-time frame receiver: hunts for the sync pair, then checks the length and the CRC.
+// Anything else (text in the stream, line noise) is counted and skipped.
+struct TelemDecoder {
+    uint8_t buf[TELEM_HEADER_LEN + TELEM_MAX_PAYLOAD + TELEM_CRC_LEN];
+    size_t n = 0;
+    unsigned long skipped = 0, crc_errors = 0;
+
+    // Returns true when buf holds a complete, valid frame
+    bool push(uint8_t c) {
+        if (n == 0 && c != TELEM_SYNC0) { skipped++; return false; }
+        if (n == 1 && c != TELEM_SYNC1) { n = 0; skipped++; return push(c); }
+        buf[n++] = c;
+        if (n < TELEM_HEADER_LEN) return false;
+        size_t len = buf[3];
+        if (len > TELEM_MAX_PAYLOAD) { resync(); return false; }
+        if (n < TELEM_HEADER_LEN + len + TELEM_CRC_LEN) return false;
+
+        uint16_t crc = telem_crc16(buf + 2, TELEM_HEADER_LEN - 2 + len);
+        uint16_t got = buf[TELEM_HEADER_LEN + len] | (buf[TELEM_HEADER_LEN + len + 1] << 8);
+        if (crc != got) { crc_errors++; resync(); return false; }
+        n = 0;
+        return true;
+    }
+
+    // Drops the first byte and re-scans the rest for another sync pair
+    void resync() {
+        uint8_t tmp[sizeof(buf)];
+        size_t m = n - 1;
+        memcpy(tmp, buf + 1, m);
+        n = 0;
+        skipped++;
+        for (size_t i = 0; i < m; i++) push(tmp[i]);
+    }
+
+    uint8_t type() const { return buf[2]; }
+    uint8_t len() const { return buf[3]; }
+    uint16_t seq() const { return buf[4] | (buf[5] << 8); }
+    const uint8_t *payload() const { return buf + TELEM_HEADER_LEN; }
+};
+
+// Builds a complete frame in out (room for TELEM_HEADER_LEN + len + TELEM_CRC_LEN bytes), returns its size
+inline size_t telem_build_frame(uint8_t *out, uint8_t type, uint16_t seq, const void *payload, uint8_t len) {
+    out[0] = TELEM_SYNC0;
+    out[1] = TELEM_SYNC1;
+    out[2] = type;
+    out[3] = len;
+    out[4] = seq & 0xFF;
+    out[5] = seq >> 8;
+    if (len) memcpy(out + TELEM_HEADER_LEN, payload, len);
+    uint16_t crc = telem_crc16(out + 2, TELEM_HEADER_LEN - 2 + len);
+    out[TELEM_HEADER_LEN + len] = crc & 0xFF;
+    out[TELEM_HEADER_LEN + len + 1] = crc >> 8;
+    return TELEM_HEADER_LEN + len + TELEM_CRC_LEN;
+}
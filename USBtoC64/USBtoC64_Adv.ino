@@ -7,6 +7,7 @@
 #include "soc/rtc_cntl_reg.h" 
 #include <WiFi.h>
 #include "esp_bt.h"
+#include "esp_system.h"
 #include <Preferences.h>
 
 #include "usb/usb_host.h"
@@ -17,12 +18,20 @@ Preferences prefs;
 int active_driver = 0; 
 
 #include "Globals.h"
+#include "MemBudget.h"
 #include "Hardware.h"
 #include "ServiceTools.h"
 #include "InputEngine.h"
+#include "AnalogEngine.h"
+#include "KeyboardEngine.h"
+#include "UsbDevices.h"
+#include "PowerGovernor.h"
+#include "Inject.h"
 #include "CoreTasks.h"
+#include "Bench.h"
 
 void IRAM_ATTR switchMJHandler() {
+    ISR_PROBE(ISR_SWITCH);
     static unsigned long last_interrupt_time = 0;
     unsigned long interrupt_time = millis();
     if (interrupt_time - last_interrupt_time > 200) { 
@@ -34,147 +43,7 @@ void IRAM_ATTR switchMJHandler() {
 // ==========================================
 // 🕹️ ENGINE 0: RAW USB HOST (JOYSTICK & GLOBAL INSPECTOR)
 // ==========================================
-static void in_transfer_cb(usb_transfer_t *xfer) {
-    if (xfer->status == USB_TRANSFER_STATUS_COMPLETED) {
-        pkt_t p;
-        p.len = xfer->actual_num_bytes;
-        memcpy(p.data, xfer->data_buffer, p.len > 64 ? 64 : p.len);
-        xQueueSendFromISR(s_pkt_q, &p, nullptr);
-        usb_host_transfer_submit(xfer);
-    }
-}
-
-// This function now parses the entire device to decide which driver handles it
-void start_sniff(uint8_t addr) {
-    if (active_driver == 0 && device_connected) return;
-    usb_device_handle_t temp_dev;
-    if (usb_host_device_open(s_client, addr, &temp_dev) != ESP_OK) return;
-
-    const usb_device_desc_t *dev_desc;
-    usb_host_get_device_descriptor(temp_dev, &dev_desc);
-    uint16_t vid = dev_desc->idVendor;
-    uint16_t pid = dev_desc->idProduct;
-
-    const usb_config_desc_t *cfg_desc;
-    usb_host_get_active_config_descriptor(temp_dev, &cfg_desc);
-
-    bool has_mouse = false;
-    int offset = 0;
-    const usb_standard_desc_t *next_desc = (const usb_standard_desc_t *)cfg_desc;
-    uint8_t temp_if_num = 0;
-    uint8_t temp_in_ep = 0;
-    uint16_t temp_in_mps = 0;
-
-    // Scan all interfaces present on the device
-    while (next_desc) {
-        if (next_desc->bDescriptorType == USB_B_DESCRIPTOR_TYPE_INTERFACE) {
-            const usb_intf_desc_t *intf = (const usb_intf_desc_t *)next_desc;
-            if (intf->bInterfaceClass == 3 && intf->bInterfaceProtocol == 2) {
-                has_mouse = true;
-            }
-            if (!has_mouse) {
-                temp_if_num = intf->bInterfaceNumber;
-            }
-        }
-        if (next_desc->bDescriptorType == USB_B_DESCRIPTOR_TYPE_ENDPOINT) {
-            const usb_ep_desc_t *ep = (const usb_ep_desc_t *)next_desc;
-            if ((ep->bmAttributes & 0x03) == 0x03 && (ep->bEndpointAddress & 0x80)) {
-                if (temp_in_ep == 0) {
-                    temp_in_ep = ep->bEndpointAddress;
-                    temp_in_mps = ep->wMaxPacketSize;
-                }
-            }
-        }
-        next_desc = usb_parse_next_descriptor(next_desc, cfg_desc->wTotalLength, &offset);
-    }
-
-    // --- CROSS-REBOOT LOGIC ---
-    if (has_mouse && active_driver == 0) {
-        Serial2.println("\n>>> MOUSE DETECTED! SWITCHING TO HID DRIVER... <<<");
-        usb_host_device_close(s_client, temp_dev);
-        prefs.putInt("drv_mode", 1);
-        delay(100);
-        esp_restart();
-        return;
-    }
-
-    if (!has_mouse && active_driver == 1) {
-        Serial2.println("\n>>> JOYSTICK DETECTED! SWITCHING TO RAW DRIVER... <<<");
-        usb_host_device_close(s_client, temp_dev);
-        prefs.putInt("drv_mode", 0);
-        delay(100);
-        esp_restart();
-        return;
-    }
-
-    if (active_driver == 1) {
-        // It's a mixed device or mouse.
-        // We close the raw channel so we don't interfere.
-        // Leave the field open for the hid_host engine.
-        usb_host_device_close(s_client, temp_dev);
-        return;
-    }
-
-    // --- JOYSTICK ALLOCATION ---
-    s_dev = temp_dev;
-    connected_vid = vid;
-    connected_pid = pid;
-    s_if_num = temp_if_num;
-    s_in_ep = temp_in_ep;
-    s_in_mps = temp_in_mps;
-    is_mouse_connected = false;
-
-    bool found_internal = false;
-    for (int i = 0; i < NUM_PROFILES; i++) {
-        if (connected_vid == PROFILES[i].vid && connected_pid == PROFILES[i].pid) {
-            current_profile = PROFILES[i];
-            found_internal = true;
-            break;
-        }
-    }
-
-    Serial2.printf("\n*** CONNECTED: %s (VID:%04x PID:%04x) ***\n",
-                   found_internal ? current_profile.name : "UNKNOWN PAD",
-                   connected_vid, connected_pid);
-    use_html_configurator = false;
-
-    if (s_in_ep) {
-        usb_host_interface_claim(s_client, s_dev, s_if_num, 0);
-        usb_host_transfer_alloc(s_in_mps, 0, &s_in_xfer);
-        s_in_xfer->device_handle = s_dev;
-        s_in_xfer->callback = in_transfer_cb;
-        s_in_xfer->bEndpointAddress = s_in_ep;
-        s_in_xfer->num_bytes = s_in_mps;
-        usb_host_transfer_submit(s_in_xfer);
-        device_connected = true;
-    }
-}
-
-static void client_event_cb(const usb_host_client_event_msg_t *msg, void *arg) {
-    if (msg->event == USB_HOST_CLIENT_EVENT_NEW_DEV) {
-        s_new_dev_addr = msg->new_dev.address;
-    } 
-    else if (msg->event == USB_HOST_CLIENT_EVENT_DEV_GONE) {
-        if (s_dev) {
-            if (s_in_xfer) {
-                usb_host_endpoint_clear(s_dev, s_in_ep);
-                usb_host_transfer_free(s_in_xfer);
-                s_in_xfer = nullptr;
-            }
-            usb_host_interface_release(s_client, s_dev, s_if_num);
-            usb_host_device_close(s_client, s_dev);
-            s_dev = nullptr;
-            device_connected = false;
-        }
-    }
-}
-
-void usb_lib_task(void *arg) { 
-    while (1) { 
-        uint32_t f;
-        usb_host_lib_handle_events(portMAX_DELAY, &f);
-    }
-}
+// Device pool, start_sniff() and the client callbacks live in UsbDevices.h, the hot-plug states in UsbLifecycle.h
 
 // ==========================================
 // 🐭 ENGINE 1: HID HOST (MOUSE / DONGLE)
@@ -187,6 +56,9 @@ typedef struct {
     void *arg;
 } hid_host_event_queue_t;
 
+MEM_QUEUE_STORAGE(hid_evt_q, 10, hid_host_event_queue_t);
+MEM_TASK_STORAGE(hid_lib, 4096);
+
 void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, const hid_host_interface_event_t event, void *arg) {
     uint8_t data[64] = {0};
     size_t data_length = 0;
@@ -196,14 +68,26 @@ void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, con
         
         pkt_t p;
         p.len = data_length;
+        p.src = (uint8_t)(uintptr_t)arg; // Interface protocol, set when the interface was opened
+        p.slot = 0;
+        p.t_us = micros();
         memcpy(p.data, data, data_length > 64 ? 64 : data_length);
         xQueueSendFromISR(s_pkt_q, &p, nullptr);
     } 
     else if (event == HID_HOST_INTERFACE_EVENT_DISCONNECTED) {
         ESP_ERROR_CHECK(hid_host_device_close(hid_device_handle));
-        Serial2.println("\n*** DISCONNECTED: NATIVE HID MOUSE ***");
-        is_mouse_connected = false;
-        device_connected = false;
+        if ((uintptr_t)arg == PKT_SRC_KEYBOARD) {
+            Serial2.println("\n*** DISCONNECTED: NATIVE HID KEYBOARD ***");
+            is_keyboard_connected = false;
+            hid_kbd_state.word = 0;
+            set_joy_word(0);
+        } else {
+            Serial2.println("\n*** DISCONNECTED: NATIVE HID MOUSE ***");
+            is_mouse_connected = false;
+            mouse_btn_word = 0; // Held clicks leave the keyboard's lines
+            set_joy_word(usb_route_word());
+        }
+        device_connected = is_mouse_connected || is_keyboard_connected;
     }
 }
 
@@ -211,7 +95,8 @@ void hid_host_device_event(hid_host_device_handle_t hid_device_handle, const hid
     hid_host_dev_params_t dev_params;
     ESP_ERROR_CHECK(hid_host_device_get_params(hid_device_handle, &dev_params));
 
-    const hid_host_device_config_t dev_config = {.callback = hid_host_interface_callback, .callback_arg = NULL};
+    // The interface protocol travels with every report so the loop can route it
+    const hid_host_device_config_t dev_config = {.callback = hid_host_interface_callback, .callback_arg = (void *)(uintptr_t)dev_params.proto};
 
     if (event == HID_HOST_DRIVER_EVENT_CONNECTED) {
         if (HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class && HID_PROTOCOL_MOUSE == dev_params.proto) {
@@ -221,9 +106,17 @@ void hid_host_device_event(hid_host_device_handle_t hid_device_handle, const hid
             ESP_ERROR_CHECK(hid_host_device_open(hid_device_handle, &dev_config));
             ESP_ERROR_CHECK(hid_class_request_set_protocol(hid_device_handle, HID_REPORT_PROTOCOL_BOOT)); 
             ESP_ERROR_CHECK(hid_host_device_start(hid_device_handle));
+        } else if (HID_SUBCLASS_BOOT_INTERFACE == dev_params.sub_class && HID_PROTOCOL_KEYBOARD == dev_params.proto) {
+            // Keyboard half of a combo dongle: drives the joystick lines next to the mouse
+            Serial2.println("\n*** CONNECTED: NATIVE HID KEYBOARD ***");
+            is_keyboard_connected = true;
+            device_connected = true;
+            ESP_ERROR_CHECK(hid_host_device_open(hid_device_handle, &dev_config));
+            ESP_ERROR_CHECK(hid_class_request_set_protocol(hid_device_handle, HID_REPORT_PROTOCOL_BOOT)); 
+            ESP_ERROR_CHECK(hid_host_device_start(hid_device_handle));
         } else {
-            // Peacefully ignore anything that is not a native mouse (e.g., keyboards or media keys on dongles)
-            Serial2.println("\n>>> NON-MOUSE INTERFACE DETECTED (IGNORED BY HID) <<<");
+            // Peacefully ignore anything else (e.g., media keys on dongles)
+            Serial2.println("\n>>> NON-BOOT INTERFACE DETECTED (IGNORED BY HID) <<<");
         }
     }
 }
@@ -234,8 +127,6 @@ void hid_host_device_callback(hid_host_device_handle_t hid_device_handle, const
 }
 
 void hid_lib_task(void *arg) {
-    hid_host_event_queue = xQueueCreate(10, sizeof(hid_host_event_queue_t));
-
     const hid_host_driver_config_t hid_host_driver_config = {
         .create_background_task = true,
         .task_priority = 5,
@@ -258,34 +149,109 @@ void hid_lib_task(void *arg) {
 // ==========================================
 // 🚀 MAIN SETUP
 // ==========================================
+
+// Pulls D+/D- LOW so a device that survived a soft reset re-enumerates
+void usb_line_reset() {
+#if FAST_BOOT
+    // Cold power-on: the device is enumerating from scratch anyway
+    if (esp_reset_reason() == ESP_RST_POWERON) return;
+#endif
+    pinMode(19, OUTPUT); pinMode(20, OUTPUT);
+    digitalWrite(19, LOW);
+    digitalWrite(20, LOW);
+#if FAST_BOOT
+    delay(USB_LINE_RESET_MS);
+    pinMode(19, INPUT); pinMode(20, INPUT);
+    // Wait for the device pull-up (D+ full speed, D- low speed) instead of a fixed delay
+    unsigned long t0 = millis();
+    while (!digitalRead(20) && !digitalRead(19) && millis() - t0 < USB_LINE_WAIT_MS) { }
+#else
+    delay(200);
+    pinMode(19, INPUT); pinMode(20, INPUT);
+    delay(100);
+#endif
+}
+
+// Reads the C64/Amiga switch once it stopped bouncing
+bool read_switch_settled() {
+#if FAST_BOOT
+    unsigned long t0 = millis();
+    unsigned long stable_since = t0;
+    int last = digitalRead(SWITCH_MJ);
+    while (millis() - stable_since < SWITCH_STABLE_MS && millis() - t0 < SWITCH_SETTLE_MAX_MS) {
+        int now = digitalRead(SWITCH_MJ);
+        if (now != last) { last = now; stable_since = millis(); }
+    }
+    return last == LOW;
+#else
+    return digitalRead(SWITCH_MJ) == LOW;
+#endif
+}
+
+MEM_QUEUE_STORAGE(pkt_q, PKT_QUEUE_LEN, pkt_t);
+MEM_QUEUE_STORAGE(dev_evt_q, USB_DEV_EVT_LEN, UsbDevEvent);
+MEM_TASK_STORAGE(usb_lib, 4096);
+MEM_TASK_STORAGE(usb_client, 6144);
+MEM_TASK_STORAGE(service_cli, 6144);
+
+// USB host + client + device pool (+ hid_host engine when selected)
+void start_usb_host() {
+    s_pkt_q = mem_queue("usb", "packet queue", PKT_QUEUE_LEN, sizeof(pkt_t), MEM_QUEUE_ARGS(pkt_q));
+    s_dev_evt_q = mem_queue("usb", "device events", USB_DEV_EVT_LEN, sizeof(UsbDevEvent), MEM_QUEUE_ARGS(dev_evt_q));
+
+    // The Global Watchdog always listens
+    usb_host_config_t host_cfg = { .skip_phy_setup = false, .intr_flags = ESP_INTR_FLAG_LEVEL1 };
+    ESP_ERROR_CHECK(usb_host_install(&host_cfg));
+    mem_task(usb_lib_task, "usb_lib", 4096, 10, 0, "usb", MEM_TASK_ARGS(usb_lib));
+
+    usb_host_client_config_t client_cfg = { .is_synchronous = false, .max_num_event_msg = 5, .async = { .client_event_callback = client_event_cb, .callback_arg = nullptr } };
+    usb_host_client_register(&client_cfg, &s_client);
+    usb_devices_init();
+    mem_task(usb_client_task, "usb_client", 6144, 9, 0, "usb", MEM_TASK_ARGS(usb_client));
+
+    // The specialized engine is started only if needed
+    if (active_driver == 1) {
+        // The queue exists before the task that installs the driver feeding it
+        hid_host_event_queue = mem_queue("hid", "event queue", 10, sizeof(hid_host_event_queue_t), MEM_QUEUE_ARGS(hid_evt_q));
+        mem_task(hid_lib_task, "hid_lib", 4096, 10, 0, "hid", MEM_TASK_ARGS(hid_lib));
+        mem_budget_add("hid", "hid_host driver", 4096, MEM_HEAP_SETUP); // Its background task, created by the component
+    }
+}
+
 void setup() {
+    BOOT_MARK("setup() entry");
    
+    Serial2.setRxBufferSize(SERIAL_RX_BUFFER);
     Serial2.begin(115200, SERIAL_8N1, GP_RX, GP_TX);
     WiFi.mode(WIFI_OFF);
     btStop();
+#if !FAST_BOOT
     delay(1000);
+#endif
+    BOOT_MARK("serial + radios off");
 
     prefs.begin("usbconfig", false);
     active_driver = prefs.getInt("drv_mode", 0);
+    BOOT_MARK("preferences read");
     
     Serial2.println("\n=================================");
     Serial2.println("  USB -> DB9 ADAPTER v3.0.5 (DUAL) ");
     Serial2.println("=================================");
     Serial2.printf(">> ACTIVE DRIVER: %s <<\n", active_driver == 1 ? "HID (MOUSE)" : "RAW (JOYSTICK)");
 
-    pinMode(19, OUTPUT); pinMode(20, OUTPUT);
-    digitalWrite(19, LOW);
-    digitalWrite(20, LOW);
-    delay(200);
-    pinMode(19, INPUT); pinMode(20, INPUT);
-    delay(100);
+    usb_line_reset();
+    BOOT_MARK("USB line reset");
+
+#if FAST_BOOT
+    // Enumeration runs on core 0 while the DB9 side is prepared below
+    start_usb_host();
+    BOOT_MARK("USB host installed");
+#endif
 
     pinMode(SWITCH_MJ, INPUT_PULLUP);
+    bool amiga_boot = read_switch_settled();
     attachInterrupt(digitalPinToInterrupt(SWITCH_MJ), switchMJHandler, CHANGE);
-
-    
-    bool amiga_boot = (digitalRead(SWITCH_MJ) == LOW);
- 
+    BOOT_MARK("C64/Amiga switch read");
     
     ws2812b.begin();
     ws2812b.setBrightness(40);
@@ -293,7 +259,17 @@ void setup() {
     ws2812b.show();
 
     configure_console_mode(amiga_boot);
+    build_paddle_tables();
+    build_stick_mouse_table();
+    stick_mouse_init();
+    inject_init();
+    build_debounce_masks();
+    build_stick_tables();
+    build_keyboard_masks();
+#if !FAST_BOOT
     delay(600);
+#endif
+    BOOT_MARK("console mode + tables");
 
     if (!is_amiga) {
         timerOnX = timerBegin(10000000); timerAlarm(timerOnX, delayOnX, false, 0);
@@ -313,6 +289,11 @@ void setup() {
         timerOffY = timerBegin(10000000);
         timerAlarm(timerOffY, delayOffY, false, 0);
         timerAttachInterrupt(timerOffX, &turnOffJoyX); timerAttachInterrupt(timerOffY, &turnOffJoyY);
+
+        // Duty-cycle joystick frame clock (idle until paddle mode publishes a pulse)
+        timerDutyPeriod = timerBegin(10000000);
+        timerAttachInterrupt(timerDutyPeriod, &amigaDutyFrame);
+        timerAlarm(timerDutyPeriod, AMIGA_DUTY_PERIOD_TICKS, true, 0);
     }
 
     set_joy_pin(GP_UP, false); set_joy_pin(GP_DOWN, false);
@@ -320,43 +301,54 @@ void setup() {
     set_joy_pin(GP_FIRE1, false); set_joy_pin(GP_FIRE2, false);
     set_fire3_pin(false);
     //if (!amiga_boot) pinMode(GP_POTY, INPUT);
+    BOOT_MARK("timers + DB9 pins released");
 
-    s_pkt_q = xQueueCreate(16, sizeof(pkt_t));
+#if !FAST_BOOT
+    start_usb_host();
+    BOOT_MARK("USB host installed");
+#endif
 
-    // The Global Watchdog always listens
-    usb_host_config_t host_cfg = { .skip_phy_setup = false, .intr_flags = ESP_INTR_FLAG_LEVEL1 };
-    ESP_ERROR_CHECK(usb_host_install(&host_cfg));
-    xTaskCreatePinnedToCore(usb_lib_task, "usb_lib", 4096, nullptr, 10, nullptr, 0);
+    power_init();
 
-    usb_host_client_config_t client_cfg = { .is_synchronous = false, .max_num_event_msg = 5, .async = { .client_event_callback = client_event_cb, .callback_arg = nullptr } };
-    usb_host_client_register(&client_cfg, &s_client);
+    // Service CLI: low priority on core 0, the play loop never waits on the UART
+    mem_task(service_task, "service_cli", 6144, 1, 0, "cli", MEM_TASK_ARGS(service_cli));
 
-    // The specialized engine is started only if needed
-    if (active_driver == 1) {
-        xTaskCreatePinnedToCore(hid_lib_task, "hid_lib", 4096, nullptr, 10, nullptr, 0);
-    }
+    mem_budget_add("cli", "serial rx buffer", SERIAL_RX_BUFFER, MEM_HEAP_SETUP);
+    mem_budget_add("inject", "frame ring", sizeof(inj_ring), MEM_STATIC);
+    mem_budget_add("edges", "edge ring", sizeof(edge_ring) + sizeof(edge_lat), MEM_STATIC);
+    mem_seal();
 }
 
 void loop() {
-    handleServiceMenu();
     check_polling_timer();
+    if (bench_request) { run_bench(); bench_request = false; }
+    apply_cli_requests();
     
-    // We always process global events for hotplug
-    usb_host_client_handle_events(s_client, 1);
-    if (s_new_dev_addr) { 
-        uint8_t a = s_new_dev_addr; 
-        s_new_dev_addr = 0;
-        start_sniff(a);
-    }
-    
+    // Sleep until a report arrives (hot-plug and transfers are pumped by usb_client_task)
     pkt_t p;
-    while (xQueueReceive(s_pkt_q, &p, 0) == pdTRUE) {
-        process_usb_packet(p);
+    bool had_reports = (xQueueReceive(s_pkt_q, &p, power_loop_wait()) == pdTRUE);
+    uint32_t t0 = micros();
+    uint32_t t_first = (had_reports && p.src < PKT_SRC_ATTACH) ? p.t_us : 0;
+    int reports = 0;
+    if (had_reports) {
+        do {
+            if (p.src >= PKT_SRC_ATTACH) { usb_apply_device_event(p); continue; }
+            power_on_report(p);
+            edge_note_report(p.t_us);
+            process_usb_packet(p);
+            usb_lc_first_report(p.slot, micros());
+            reports++;
+        } while (xQueueReceive(s_pkt_q, &p, 0) == pdTRUE);
     }
 
     run_gpio_diagnostics();
     update_hardware_and_leds();
+    run_stick_mouse();
+    usb_report_ctrl_errors();
+    telemetry_update(reports, t_first, t0);
     
     // 🛡️ HARDWARE WATCHDOG
     check_switch_mismatch(); 
+
+    power_update(had_reports, t_first, micros() - t0);
 }
\ No newline at end of file
@@ -0,0 +1,802 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: UsbDevices.h
+// Description: Raw USB Host engine with a fixed device pool (hub support) and output routing
+// ==========================================
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "usb/usb_host.h"
+#include "Globals.h"
+#include "MemBudget.h"
+#include "InputEngine.h"
+#include "AnalogEngine.h"
+#include "KeyboardEngine.h"
+#include "UsbLifecycle.h"
+#include "ChordLayer.h"
+
+// Link to the driver selection from the main file
+extern Preferences prefs;
+extern int active_driver;
+
+// ==========================================
+// 🔌 PART 1: DEVICE POOL
+// ==========================================
+// Every slot owns its transfer ring, profile and decode state. Transfers are allocated
+// once in setup(), so hot-plugging only claims a free slot and re-targets its transfers.
+// When a slot may be claimed, drained and closed is decided by UsbLifecycle.h (usb_life[]);
+// in_use only says whether its reports are routed.
+
+struct UsbSlot {
+    bool in_use;
+    uint8_t kind;              // PKT_SRC_PAD / PKT_SRC_KEYBOARD / PKT_SRC_MOUSE
+    uint8_t addr;
+    usb_device_handle_t dev;
+    uint8_t if_num;
+    uint8_t in_ep;
+    uint16_t in_mps;
+    uint8_t in_interval;       // bInterval of the pad's IN endpoint, ms (debounce counts silent intervals)
+    uint16_t vid, pid;
+    uint32_t fingerprint;      // Report descriptor + interface layout hash (0 = unknown)
+    usb_transfer_t *xfer[USB_XFER_RING];
+    usb_transfer_t *ctrl;      // SET_PROTOCOL (boot) for a raw mouse or an undescribed keyboard (one per slot)
+    volatile bool ctrl_busy;   // ...still in flight
+    PadConfig profile;
+    PadConfig bank[CHORD_BANKS];  // Mapping banks (ChordLayer.h), bank[0] = profile
+    const PadConfig *map;         // Bank the decoder reads: a chord only moves this pointer
+    uint8_t num_banks, bank_idx;
+    DevState state;
+    RelevanceMask rel;         // Report filter (in_transfer_cb), rebuilt with the profile
+    KbdLayout kbd;             // PKT_SRC_KEYBOARD: report IDs from the report descriptor
+};
+
+static UsbSlot usb_slots[USB_MAX_DEVICES];
+static uint8_t usb_focus_slot = 0;              // Last attached device: sniffer, 'lag' and LED colors follow it
+static DevState hid_kbd_state;                  // Keyboard opened by the hid_host engine (driver 1)
+
+// Attach / detach events, in bus order (a hub can report several in one event pass)
+#define USB_DEV_EVT_LEN 16
+static QueueHandle_t s_dev_evt_q = nullptr;
+static uint32_t usb_dev_evt_dropped = 0;
+
+#define USB_IN_BUF_SIZE  64
+#define HID_REQ_SET_PROTOCOL 0x0B
+#define USB_REQ_GET_DESCRIPTOR 0x06
+#define HID_DESC_TYPE_HID    0x21
+#define HID_DESC_TYPE_REPORT 0x22
+
+#define USB_DESC_BUF_SIZE    512  // Report descriptor bytes read for the fingerprint
+#define USB_DESC_TIMEOUT_MS  100
+#define FNV_OFFSET_BASIS     2166136261UL
+#define FNV_PRIME            16777619UL
+
+static usb_transfer_t *usb_desc_xfer = nullptr; // GET_DESCRIPTOR (Report) at enumeration
+static volatile bool usb_desc_busy = false;  // Cleared by desc_transfer_cb, may outlive the timeout
+static uint32_t usb_ctrl_failed = 0;            // SET_PROTOCOL failures, reported by the loop
+
+
+// ==========================================
+// 🔀 PART 2: OUTPUT ROUTING
+// ==========================================
+
+// Merges every device into one JS_* word for the DB9 port
+inline uint16_t usb_route_word() {
+    uint16_t w = hid_kbd_state.word;
+    if (route_mode == ROUTE_OR && is_mouse_connected) w |= mouse_btn_word; // Combo dongle / hub: mouse clicks next to the keys
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        const UsbSlot &s = usb_slots[i];
+        if (!s.in_use || s.kind == PKT_SRC_MOUSE) continue;
+        if (route_mode == ROUTE_OR) w |= s.state.word;
+        else if (w == 0) w = s.state.word; // Priority: first device with input owns the port
+    }
+    return w;
+}
+
+// A pad or keyboard is feeding the joystick lines
+inline bool usb_joystick_source() {
+    if (active_driver == 1) return is_keyboard_connected;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        if (usb_slots[i].in_use && usb_slots[i].kind != PKT_SRC_MOUSE) return true;
+    }
+    return false;
+}
+
+inline void usb_refresh_flags() {
+    bool any = false, mouse = false, kbd = false;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        if (!usb_slots[i].in_use) continue;
+        any = true;
+        if (usb_slots[i].kind == PKT_SRC_MOUSE) mouse = true;
+        if (usb_slots[i].kind == PKT_SRC_KEYBOARD) kbd = true;
+    }
+    device_connected = any;
+    is_mouse_connected = mouse;
+    is_keyboard_connected = kbd;
+}
+
+// The sniffer, 'lag' and LED colors follow one device: the last one plugged in
+inline void usb_set_focus(int idx) {
+    usb_focus_slot = idx;
+    current_profile = usb_slots[idx].profile;
+    connected_vid = usb_slots[idx].vid;
+    connected_pid = usb_slots[idx].pid;
+    connected_fingerprint = usb_slots[idx].fingerprint;
+}
+
+// Banks and relevance mask are built together: the mask covers every bank, so a bank switch
+// never has to touch the USB callback
+inline void usb_build_banks(UsbSlot &s) {
+    s.num_banks = build_chord_banks(s.profile, s.bank);
+    s.bank_idx = 0;
+    s.map = &s.bank[0];
+    build_relevance_mask(s.bank[0], s.rel);
+    for (int b = 1; b < s.num_banks; b++) {
+        RelevanceMask extra;
+        build_relevance_mask(s.bank[b], extra);
+        for (int i = 0; i < 16; i++) s.rel.mask[i] |= extra.mask[i];
+        if (extra.words > s.rel.words) s.rel.words = extra.words;
+    }
+}
+
+// 'auto' profiler result: the focused pad uses the inferred mapping right away (until reboot)
+inline void usb_apply_focus_profile(const PadConfig &cfg) {
+    UsbSlot &s = usb_slots[usb_focus_slot];
+    s.profile = cfg;
+    memset(&s.state, 0, sizeof(s.state));
+    usb_build_banks(s);
+    current_profile = cfg;
+}
+
+// A chord picked on a pad (ChordLayer.h): applied at once, confirmed on the LED
+inline void usb_apply_chord(int slot, ChordCmd cmd) {
+    static const char *const OUT_NAMES[] = { "JOYSTICK", "PADDLE", "CD32", "MOUSE" };
+    UsbSlot &s = usb_slots[slot];
+    uint8_t shown = 1;
+    switch (cmd) {
+        case CHORD_DO_BANK:
+            s.bank_idx = (s.bank_idx + 1) % s.num_banks;
+            s.map = &s.bank[s.bank_idx];
+            shown = s.bank_idx + 1;
+            break;
+        case CHORD_DO_AUTOFIRE:
+            autofire_preset = (autofire_preset + 1) % AUTOFIRE_PRESETS;
+            shown = autofire_preset + 1;
+            break;
+        case CHORD_DO_MOUSE: {
+            uint8_t &speed = is_amiga ? mouse_speed_amiga : mouse_speed_c64;
+            speed = speed >= 5 ? 1 : speed + 1;
+            shown = speed;
+            break;
+        }
+        case CHORD_DO_OUTPUT: {
+            OutputMode m = OUT_JOYSTICK;
+            if (active_output_mode == OUT_JOYSTICK) m = OUT_PADDLE;
+            else if (active_output_mode == OUT_PADDLE) m = is_amiga ? OUT_CD32 : OUT_MOUSE;
+            else if (active_output_mode == OUT_CD32) m = OUT_MOUSE;
+            set_output_mode(m);
+            shown = (uint8_t)m + 1;
+            break;
+        }
+        case CHORD_DO_DEFAULTS:
+            s.bank_idx = 0;
+            s.map = &s.bank[0];
+            autofire_preset = 0;
+            mouse_speed_amiga = AMIGA_MOUSE_SPEED;
+            mouse_speed_c64 = C64_MOUSE_SPEED;
+            set_output_mode(s.profile.output_mode);
+            break;
+        default:
+            return;
+    }
+    chord_flash(cmd, shown);
+    Serial2.printf("\n*** CHORD [%d]: bank %d/%d, autofire %u ms, mouse speed %u, output %s ***\n", slot, s.bank_idx + 1, s.num_banks,
+                   AUTOFIRE_HALF_MS[autofire_preset], is_amiga ? mouse_speed_amiga : mouse_speed_c64, OUT_NAMES[active_output_mode]);
+}
+
+// Chord deadlines between reports (ChordLayer.h): an armed pad stops driving the port at once
+inline void usb_chord_tick(uint32_t now_ms) {
+    bool blanked = false;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        UsbSlot &s = usb_slots[i];
+        if (!s.in_use || s.kind != PKT_SRC_PAD) continue;
+        if (chord_tick(s.state.chord, now_ms)) { s.state.word = 0; blanked = true; }
+    }
+    if (blanked) set_joy_word(usb_route_word());
+}
+
+// Debounce counts between reports (InputEngine.h): a pad that went silent still lands its change
+inline void usb_debounce_tick(uint32_t now_ms) {
+    bool moved = false;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        UsbSlot &s = usb_slots[i];
+        if (!s.in_use || s.kind != PKT_SRC_PAD) continue;
+        if (!debounce_tick(s.state.deb, now_ms, s.in_interval)) continue;
+        s.state.word = s.state.deb.state;
+        ChordCmd chord = chord_step(s.state.chord, s.state.word, now_ms);
+        if (chord != CHORD_DO_NONE) usb_apply_chord(i, chord);
+        moved = true;
+    }
+    if (moved) set_joy_word(usb_route_word());
+}
+
+inline const char* usb_kind_name(uint8_t kind) {
+    if (kind == PKT_SRC_MOUSE) return "MOUSE";
+    if (kind == PKT_SRC_KEYBOARD) return "KEYBOARD";
+    return "PAD";
+}
+
+// Hot-plug counters and NEW_DEV -> first routed report times (UsbLifecycle.h)
+inline void print_usb_hotplug() {
+    const UsbLcStats &st = usb_lc_stats;
+    Serial2.printf(" HOT-PLUG: %lu attached, %lu detached, %lu deferred, %lu rejected, %lu open failed, %lu drain retries, %lu events dropped\n",
+                   (unsigned long)st.attaches, (unsigned long)st.detaches, (unsigned long)st.deferred, (unsigned long)st.rejected,
+                   (unsigned long)st.open_failed, (unsigned long)st.drain_retries, (unsigned long)usb_dev_evt_dropped);
+    uint32_t n = st.lat_n < USB_LC_HISTORY ? st.lat_n : USB_LC_HISTORY;
+    if (!n) return;
+    uint32_t v[USB_LC_HISTORY];
+    memcpy(v, st.lat_us, sizeof(v));
+    for (uint32_t i = 1; i < n; i++) {
+        uint32_t x = v[i];
+        int j = (int)i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+    uint32_t last = st.lat_us[(st.lat_n - 1) % USB_LC_HISTORY];
+    Serial2.printf(" RECONNECT (device event -> first report, last %lu): last %.1f  min %.1f  p50 %.1f  max %.1f ms, longest drain %.1f ms\n",
+                   (unsigned long)n, last / 1000.0f, v[0] / 1000.0f, v[n / 2] / 1000.0f, v[n - 1] / 1000.0f, st.drain_max_us / 1000.0f);
+}
+
+void print_usb_devices() {
+    Serial2.println("\n=== 🔌 USB DEVICES ===");
+    Serial2.printf(" ROUTING: %s\n", route_mode == ROUTE_OR ? "OR (co-pilot)" : "PRIORITY (first active wins)");
+    int n = 0;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        const UsbSlot &s = usb_slots[i];
+        if (!s.in_use) continue;
+        Serial2.printf(" [%d]%s %-8s %-24s VID:%04x PID:%04x FP:%08lx IF:%d EP:%02x STATE:%04x GLITCH:%lu SKIP:%lu BANK:%d/%d\n",
+                       i, i == usb_focus_slot ? "*" : " ", usb_kind_name(s.kind), s.profile.name ? s.profile.name : "UNKNOWN PAD",
+                       s.vid, s.pid, (unsigned long)s.fingerprint, s.if_num, s.in_ep, s.state.word, (unsigned long)s.state.deb.glitches,
+                       (unsigned long)s.rel.skipped, s.bank_idx + 1, s.num_banks);
+        if (s.profile.use_report_id) {
+            for (int k = 0; k < MUX_SLOTS; k++) {
+                if (s.state.mux.id[k] == 0) continue;
+                Serial2.printf("       MUX port %d: ID %3d STATE:%04x%s\n", k, s.state.mux.id[k], s.state.mux.word[k],
+                               (mux_mode == MUX_SELECT && k == s.state.mux.selected) ? " (selected)" : "");
+            }
+        }
+        n++;
+    }
+    if (n == 0) Serial2.println(" (no devices)");
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        if (usb_life[i].phase == SLOT_DRAINING) Serial2.printf(" [%d]  draining, %u transfers in flight\n", i, usb_life[i].inflight);
+    }
+    print_usb_hotplug();
+    if (active_driver == 1) Serial2.println(" Driver: HID (mouse / keyboard handled by hid_host)");
+    Serial2.println("======================\n");
+}
+
+
+// ==========================================
+// 🧬 PART 3: DEVICE FINGERPRINT
+// ==========================================
+// Clones often share a VID:PID with a different report layout. Every device is hashed
+// (FNV-1a) over its configuration descriptor (interface / endpoint layout), its HID report
+// descriptor and its input report size. Profiles carrying that hash win over VID:PID.
+
+struct FpEntry {
+    uint32_t fp;
+    uint8_t profile;
+};
+
+static FpEntry fp_index[NUM_PROFILES];
+static int fp_index_len = 0;
+
+inline uint32_t fnv1a(uint32_t h, const uint8_t *p, int n) {
+    while (n-- > 0) { h ^= *p++; h *= FNV_PRIME; }
+    return h;
+}
+
+// Sorted once at boot, looked up with a binary search at every attach
+inline void build_fingerprint_index() {
+    fp_index_len = 0;
+    for (int i = 0; i < NUM_PROFILES; i++) {
+        if (PROFILES[i].fingerprint == 0) continue;
+        FpEntry e = { PROFILES[i].fingerprint, (uint8_t)i };
+        int k = fp_index_len++;
+        while (k > 0 && fp_index[k - 1].fp > e.fp) { fp_index[k] = fp_index[k - 1]; k--; }
+        fp_index[k] = e;
+    }
+}
+
+inline int fp_lookup(uint32_t fp) {
+    int lo = 0, hi = fp_index_len - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (fp_index[mid].fp == fp) return fp_index[mid].profile;
+        if (fp_index[mid].fp < fp) lo = mid + 1; else hi = mid - 1;
+    }
+    return -1;
+}
+
+// Fingerprint first, then VID:PID (profiles without a fingerprint are preferred there)
+inline int usb_match_profile(uint16_t vid, uint16_t pid, uint32_t fp, bool *by_fp) {
+    int i = fp ? fp_lookup(fp) : -1;
+    *by_fp = (i >= 0);
+    if (i >= 0) return i;
+
+    int fallback = -1;
+    for (i = 0; i < NUM_PROFILES; i++) {
+        if (vid != PROFILES[i].vid || pid != PROFILES[i].pid) continue;
+        if (PROFILES[i].fingerprint == 0) return i;
+        if (fallback < 0) fallback = i;
+    }
+    return fallback;
+}
+
+// start_sniff() runs in usb_client_task (usb_lc_open), the task that pumps the client
+// events, so the control transfer is completed here by polling the events for a short
+// while. A request that times out still owns the transfer until its callback comes back.
+inline int usb_read_report_descriptor(usb_device_handle_t dev, uint8_t if_num, uint16_t len, const uint8_t **out) {
+    if (len == 0 || usb_desc_busy) return 0;
+    if (len > USB_DESC_BUF_SIZE) len = USB_DESC_BUF_SIZE;
+
+    usb_setup_packet_t *setup = (usb_setup_packet_t *)usb_desc_xfer->data_buffer;
+    setup->bmRequestType = 0x81; // Device->host, standard, interface
+    setup->bRequest = USB_REQ_GET_DESCRIPTOR;
+    setup->wValue = (HID_DESC_TYPE_REPORT << 8);
+    setup->wIndex = if_num;
+    setup->wLength = len;
+    usb_desc_xfer->device_handle = dev;
+    usb_desc_xfer->bEndpointAddress = 0;
+    usb_desc_xfer->num_bytes = USB_SETUP_PACKET_SIZE + len;
+    usb_desc_busy = true;
+    if (usb_host_transfer_submit_control(s_client, usb_desc_xfer) != ESP_OK) {
+        usb_desc_busy = false;
+        return 0;
+    }
+
+    unsigned long t0 = millis();
+    while (usb_desc_busy && millis() - t0 < USB_DESC_TIMEOUT_MS) {
+        usb_host_client_handle_events(s_client, 1);
+    }
+    if (usb_desc_busy || usb_desc_xfer->status != USB_TRANSFER_STATUS_COMPLETED) return 0;
+
+    *out = usb_desc_xfer->data_buffer + USB_SETUP_PACKET_SIZE;
+    return usb_desc_xfer->actual_num_bytes - USB_SETUP_PACKET_SIZE;
+}
+
+inline uint32_t usb_fingerprint(usb_device_handle_t dev, const usb_config_desc_t *cfg_desc, uint8_t if_num, uint16_t report_desc_len, uint16_t in_mps) {
+    uint32_t h = fnv1a(FNV_OFFSET_BASIS, (const uint8_t *)cfg_desc, cfg_desc->wTotalLength);
+
+    const uint8_t *report = nullptr;
+    int n = usb_read_report_descriptor(dev, if_num, report_desc_len, &report);
+    if (n > 0) h = fnv1a(h, report, n);
+
+    uint8_t mps[2] = { (uint8_t)(in_mps & 0xFF), (uint8_t)(in_mps >> 8) };
+    h = fnv1a(h, mps, 2);
+    return h ? h : 1; // 0 is reserved for 'no fingerprint'
+}
+
+
+// ==========================================
+// 🕹️ PART 4: RAW USB HOST ENGINE
+// ==========================================
+
+// Relevance filter: false = the bits the profile reads match the last report, skip the decode.
+// The inspection tools ('new', 'auto', 'raw', 'lag') and mice / keyboards see every report.
+inline bool usb_report_relevant(UsbSlot &s, const pkt_t &p, uint32_t now_us) {
+#if RELEVANCE_FILTER
+    RelevanceMask &rm = s.rel;
+    bool inspect = (current_mode == MODE_SNIFFER || current_mode == MODE_AUTOPROFILE || current_mode == MODE_RAW || current_mode == MODE_POLLING);
+    if (s.kind != PKT_SRC_PAD || inspect || !rm.words) return true;
+
+    // Word-wide compare over the mapped prefix only (a PS4 report is 64 bytes, its buttons sit in the first 10)
+    uint32_t diff = (p.len != rm.len || !rm.primed);
+    int n = (p.len + 3) / 4;
+    if (n > rm.words) n = rm.words;
+    for (int i = 0; i < n; i++) {
+        uint32_t w = 0;
+        int b = p.len - 4 * i;
+        memcpy(&w, p.data + 4 * i, b < 4 ? b : 4);
+        diff |= (w ^ rm.last[i]) & rm.mask[i];
+        rm.last[i] = w;
+    }
+    if (diff) rm.tail = (debounce_mode != DEB_OFF) ? RELEVANCE_TAIL : 0; // Debounce counts in reports
+    else if (rm.tail) rm.tail--;
+    else if (now_us - rm.t_last_us < RELEVANCE_KEEPALIVE_MS * 1000UL) { rm.skipped++; return false; }
+    rm.len = (uint8_t)p.len;
+    rm.primed = true;
+    rm.t_last_us = now_us;
+#endif
+    return true;
+}
+
+// Runs inside usb_client_task's event pump; cancelled transfers come back here too
+static void in_transfer_cb(usb_transfer_t *xfer) {
+    UsbSlot *s = (UsbSlot *)xfer->context;
+    int slot = (int)(s - usb_slots);
+    bool completed = (xfer->status == USB_TRANSFER_STATUS_COMPLETED);
+    uint32_t now = micros();
+    if (completed && s->in_use) {
+        pkt_t p;
+        p.len = xfer->actual_num_bytes;
+        p.src = s->kind;
+        p.slot = (uint8_t)slot;
+        p.t_us = now;
+        memcpy(p.data, xfer->data_buffer, p.len > 64 ? 64 : p.len);
+        if (usb_report_relevant(*s, p, now)) xQueueSendFromISR(s_pkt_q, &p, nullptr);
+    }
+    int k = 0;
+    while (k < USB_XFER_RING - 1 && s->xfer[k] != xfer) k++;
+    usb_lc_xfer_done(slot, k, completed, now);
+}
+
+static void ctrl_transfer_cb(usb_transfer_t *xfer) {
+    if (xfer->status != USB_TRANSFER_STATUS_COMPLETED) usb_ctrl_failed++;
+    ((UsbSlot *)xfer->context)->ctrl_busy = false;
+}
+
+// Loop: the client callback only counts, the message is printed here
+inline void usb_report_ctrl_errors() {
+    static uint32_t reported = 0;
+    uint32_t n = usb_ctrl_failed;
+    if (n == reported) return;
+    reported = n;
+    Serial2.printf(">>> SET_PROTOCOL (BOOT) FAILED (%lu so far), mouse / keyboard reports may be in report format <<<\n", (unsigned long)n);
+}
+
+static void desc_transfer_cb(usb_transfer_t *xfer) {
+    usb_desc_busy = false;
+}
+
+
+// Called once from setup(), after the client is registered
+inline void usb_devices_init() {
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        UsbSlot &s = usb_slots[i];
+        s.in_use = false;
+        for (int k = 0; k < USB_XFER_RING; k++) {
+            usb_host_transfer_alloc(USB_IN_BUF_SIZE, 0, &s.xfer[k]);
+            s.xfer[k]->callback = in_transfer_cb;
+            s.xfer[k]->context = &s;
+        }
+        usb_host_transfer_alloc(USB_SETUP_PACKET_SIZE, 0, &s.ctrl);
+        s.ctrl->callback = ctrl_transfer_cb;
+        s.ctrl->context = &s;
+        s.ctrl_busy = false;
+    }
+    usb_host_transfer_alloc(USB_SETUP_PACKET_SIZE + USB_DESC_BUF_SIZE, 0, &usb_desc_xfer);
+    usb_desc_xfer->callback = desc_transfer_cb;
+    build_fingerprint_index();
+
+    // Transfer buffers must be DMA-capable: allocated here once, never per connect
+    mem_budget_add("usb", "transfer buffers", USB_MAX_DEVICES * USB_XFER_RING * USB_IN_BUF_SIZE
+                   + USB_SETUP_PACKET_SIZE * (USB_MAX_DEVICES + 1) + USB_DESC_BUF_SIZE, MEM_HEAP_SETUP);
+    mem_budget_add("usb", "device pool", sizeof(usb_slots) + sizeof(fp_index), MEM_STATIC);
+    mem_budget_add("usb", "hot-plug state", sizeof(usb_life) + sizeof(usb_lc_stats) + sizeof(usb_lc_pending), MEM_STATIC);
+    usb_lc_reset();
+}
+
+// Raw boot mouse (or a keyboard without a readable report descriptor): the hid_host engine is not
+// running, so ask for the boot report ourselves
+// Each slot has its own transfer: two mice enumerating back to back (hub at power-on) never share one
+inline void usb_set_boot_protocol(UsbSlot &s) {
+    if (s.ctrl_busy) { usb_ctrl_failed++; return; } // Previous device's request never came back
+    usb_setup_packet_t *setup = (usb_setup_packet_t *)s.ctrl->data_buffer;
+    setup->bmRequestType = 0x21; // Host->device, class, interface
+    setup->bRequest = HID_REQ_SET_PROTOCOL;
+    setup->wValue = 0;           // 0 = boot protocol
+    setup->wIndex = s.if_num;
+    setup->wLength = 0;
+    s.ctrl->device_handle = s.dev;
+    s.ctrl->bEndpointAddress = 0;
+    s.ctrl->num_bytes = USB_SETUP_PACKET_SIZE;
+    s.ctrl_busy = true;
+    if (usb_host_transfer_submit_control(s_client, s.ctrl) != ESP_OK) {
+        s.ctrl_busy = false;
+        usb_ctrl_failed++;
+    }
+}
+
+inline int usb_bus_device_count() {
+    uint8_t list[16];
+    int n = 0;
+    usb_host_device_addr_list_fill(sizeof(list), list, &n);
+    return n;
+}
+
+// This function parses the entire device to decide which driver handles it.
+// Returns the open, claimed device, or nullptr when the raw engine does not keep it.
+usb_device_handle_t start_sniff(int slot, uint8_t addr) {
+    usb_device_handle_t temp_dev;
+    if (usb_host_device_open(s_client, addr, &temp_dev) != ESP_OK) return nullptr;
+
+    const usb_device_desc_t *dev_desc;
+    usb_host_get_device_descriptor(temp_dev, &dev_desc);
+    uint16_t vid = dev_desc->idVendor;
+    uint16_t pid = dev_desc->idProduct;
+
+    const usb_config_desc_t *cfg_desc;
+    usb_host_get_active_config_descriptor(temp_dev, &cfg_desc);
+
+    bool has_mouse = false;
+    bool in_mouse_if = false;
+    uint8_t mouse_if_num = 0, mouse_in_ep = 0;
+    uint16_t mouse_in_mps = 0;
+    bool has_keyboard = false;
+    bool in_keyboard_if = false;
+    uint8_t kbd_if_num = 0, kbd_in_ep = 0;
+    uint16_t kbd_in_mps = 0;
+    int offset = 0;
+    const usb_standard_desc_t *next_desc = (const usb_standard_desc_t *)cfg_desc;
+    uint8_t temp_if_num = 0;
+    uint8_t temp_in_ep = 0;
+    uint16_t temp_in_mps = 0;
+    uint8_t temp_in_interval = 0;
+    uint8_t cur_if_num = 0;
+    uint16_t report_desc_len[8] = {0}; // Per interface, from the HID class descriptor
+
+    // Scan all interfaces present on the device
+    while (next_desc) {
+        if (next_desc->bDescriptorType == USB_B_DESCRIPTOR_TYPE_INTERFACE) {
+            const usb_intf_desc_t *intf = (const usb_intf_desc_t *)next_desc;
+            cur_if_num = intf->bInterfaceNumber;
+            in_mouse_if = (intf->bInterfaceClass == 3 && intf->bInterfaceProtocol == 2 && !has_mouse);
+            if (in_mouse_if) {
+                has_mouse = true;
+                mouse_if_num = intf->bInterfaceNumber;
+            }
+            if (!has_mouse) {
+                temp_if_num = intf->bInterfaceNumber;
+            }
+            // First keyboard interface: remember it so we claim the right endpoint
+            in_keyboard_if = (intf->bInterfaceClass == 3 && intf->bInterfaceProtocol == 1 && !has_keyboard);
+            if (in_keyboard_if) {
+                has_keyboard = true;
+                kbd_if_num = intf->bInterfaceNumber;
+            }
+        }
+        if (next_desc->bDescriptorType == HID_DESC_TYPE_HID && next_desc->bLength >= 9 && cur_if_num < 8) {
+            const uint8_t *hid = (const uint8_t *)next_desc;
+            report_desc_len[cur_if_num] = hid[7] | (hid[8] << 8); // wDescriptorLength of the first (report) descriptor
+        }
+        if (next_desc->bDescriptorType == USB_B_DESCRIPTOR_TYPE_ENDPOINT) {
+            const usb_ep_desc_t *ep = (const usb_ep_desc_t *)next_desc;
+            if ((ep->bmAttributes & 0x03) == 0x03 && (ep->bEndpointAddress & 0x80)) {
+                if (temp_in_ep == 0) {
+                    temp_in_ep = ep->bEndpointAddress;
+                    temp_in_mps = ep->wMaxPacketSize;
+                    temp_in_interval = ep->bInterval;
+                }
+                if (in_keyboard_if && kbd_in_ep == 0) {
+                    kbd_in_ep = ep->bEndpointAddress;
+                    kbd_in_mps = ep->wMaxPacketSize;
+                }
+                if (in_mouse_if && mouse_in_ep == 0) {
+                    mouse_in_ep = ep->bEndpointAddress;
+                    mouse_in_mps = ep->wMaxPacketSize;
+                }
+            }
+        }
+        next_desc = usb_parse_next_descriptor(next_desc, cfg_desc->wTotalLength, &offset);
+    }
+
+    // --- CROSS-REBOOT LOGIC ---
+    // A lone mouse goes to the hid_host engine. Behind a hub (more devices on the bus)
+    // the raw engine adopts it, so it can share the port with the pads.
+    bool adopt_mouse = false;
+    if (has_mouse && active_driver == 0) {
+        if (usb_bus_device_count() > 1 && mouse_in_ep) {
+            adopt_mouse = true;
+        } else {
+            Serial2.println("\n>>> MOUSE DETECTED! SWITCHING TO HID DRIVER... <<<");
+            usb_host_device_close(s_client, temp_dev);
+            prefs.putInt("drv_mode", 1);
+            delay(100);
+            esp_restart();
+            return nullptr;
+        }
+    }
+
+    if (!has_mouse && active_driver == 1) {
+        Serial2.println("\n>>> JOYSTICK DETECTED! SWITCHING TO RAW DRIVER... <<<");
+        usb_host_device_close(s_client, temp_dev);
+        prefs.putInt("drv_mode", 0);
+        delay(100);
+        esp_restart();
+        return nullptr;
+    }
+
+    if (active_driver == 1) {
+        // It's a mixed device or mouse.
+        // We close the raw channel so we don't interfere.
+        // Leave the field open for the hid_host engine.
+        usb_host_device_close(s_client, temp_dev);
+        return nullptr;
+    }
+
+    // --- SLOT ALLOCATION ---
+    UsbSlot &s = usb_slots[slot];
+    s.dev = temp_dev;
+    s.addr = addr;
+    s.vid = vid;
+    s.pid = pid;
+    s.kind = PKT_SRC_PAD;
+    s.if_num = temp_if_num;
+    s.in_ep = temp_in_ep;
+    s.in_mps = temp_in_mps;
+    s.in_interval = temp_in_interval ? temp_in_interval : 1;
+    s.profile = PadConfig();
+    s.fingerprint = usb_fingerprint(temp_dev, cfg_desc, temp_if_num, temp_if_num < 8 ? report_desc_len[temp_if_num] : 0, temp_in_mps);
+
+    bool by_fp = false;
+    int match = usb_match_profile(vid, pid, s.fingerprint, &by_fp);
+    bool found_internal = (match >= 0);
+    if (found_internal) s.profile = PROFILES[match];
+
+    // --- KEYBOARD / MOUSE (no matching pad profile) ---
+    bool kbd_boot = false;
+    if (!found_internal && adopt_mouse) {
+        s.kind = PKT_SRC_MOUSE;
+        s.profile.name = "USB MOUSE";
+        found_internal = true;
+        s.if_num = mouse_if_num;
+        s.in_ep = mouse_in_ep;
+        s.in_mps = mouse_in_mps;
+    } else if (!found_internal && has_keyboard && kbd_in_ep) {
+        s.kind = PKT_SRC_KEYBOARD;
+        s.profile = KEYBOARD_PROFILE;
+        found_internal = true;
+        s.if_num = kbd_if_num;
+        s.in_ep = kbd_in_ep;
+        s.in_mps = kbd_in_mps;
+        const uint8_t *report = nullptr;
+        int n = usb_read_report_descriptor(s.dev, kbd_if_num, kbd_if_num < 8 ? report_desc_len[kbd_if_num] : 0, &report);
+        s.kbd = kbd_scan_report_descriptor(report, n);
+        if (!s.kbd.num_fields) { // Descriptor unreadable: switch the keyboard to the boot report below
+            s.kbd = KBD_LAYOUT_BOOT;
+            kbd_boot = true;
+        }
+    }
+    if (s.in_mps > USB_IN_BUF_SIZE) s.in_mps = USB_IN_BUF_SIZE;
+
+    Serial2.printf("\n*** CONNECTED [%d]: %s (VID:%04x PID:%04x FP:%08lx%s) ***\n", slot,
+                   found_internal ? s.profile.name : "UNKNOWN PAD", vid, pid, (unsigned long)s.fingerprint, by_fp ? ", fingerprint match" : "");
+
+    if (!s.in_ep) {
+        usb_host_device_close(s_client, s.dev);
+        return nullptr;
+    }
+
+    usb_host_interface_claim(s_client, s.dev, s.if_num, 0);
+    if (s.kind == PKT_SRC_MOUSE || kbd_boot) usb_set_boot_protocol(s);
+
+    for (int k = 0; k < USB_XFER_RING; k++) {
+        usb_transfer_t *x = s.xfer[k];
+        x->device_handle = s.dev;
+        x->bEndpointAddress = s.in_ep;
+        x->num_bytes = s.in_mps;
+    }
+    usb_build_banks(s); // Before the lifecycle submits the ring
+    s.in_use = true;
+
+    // Focus, flags and output mode are loop state: queued ahead of the first report
+    pkt_t p = {};
+    p.src = PKT_SRC_ATTACH;
+    p.slot = (uint8_t)slot;
+    p.t_us = micros();
+    p.data[0] = (uint8_t)(found_internal ? s.profile.output_mode : OUT_JOYSTICK);
+    xQueueSend(s_pkt_q, &p, portMAX_DELAY);
+    return s.dev;
+}
+
+// Loop side of PKT_SRC_ATTACH / PKT_SRC_DETACH
+inline void usb_apply_device_event(const pkt_t &p) {
+    UsbSlot &s = usb_slots[p.slot];
+    if (p.src == PKT_SRC_ATTACH) {
+        memset(&s.state, 0, sizeof(s.state));
+        usb_set_focus(p.slot);
+        usb_refresh_flags();
+        use_html_configurator = false;
+        if (s.kind == PKT_SRC_PAD) set_output_mode((OutputMode)p.data[0]);
+    } else {
+        Serial2.printf("\n*** DISCONNECTED [%d]: %s ***\n", p.slot, (const char *)p.data);
+        if (!s.in_use) {
+            s.state.word = 0;
+            memset(&s.state.mux, 0, sizeof(s.state.mux)); // Multitap ports are released with their device
+            stick_mouse_release(&s.state);
+        }
+        usb_refresh_flags();
+        for (int i = 0; i < USB_MAX_DEVICES; i++) {
+            if (usb_slots[i].in_use) { usb_set_focus(i); break; }
+        }
+    }
+    set_joy_word(usb_route_word());
+}
+
+
+// ==========================================
+// 🔁 PART 5: HOT-PLUG HOOKS (UsbLifecycle.h)
+// ==========================================
+
+void *usb_lc_open(int slot, uint8_t addr) {
+    return (void *)start_sniff(active_driver == 0 ? slot : 0, addr);
+}
+
+bool usb_lc_submit(int slot, int k) {
+    return usb_host_transfer_submit(usb_slots[slot].xfer[k]) == ESP_OK;
+}
+
+// Stop routing, then cancel whatever is still queued: the callbacks drain the ring
+void usb_lc_cancel(int slot) {
+    UsbSlot &s = usb_slots[slot];
+    bool was_routed = s.in_use;
+    s.in_use = false;
+    usb_host_endpoint_halt(s.dev, s.in_ep);
+    usb_host_endpoint_flush(s.dev, s.in_ep);
+    if (!was_routed) return; // Drain retry
+
+    // Routing, focus and the log line are loop work: queued behind the slot's last reports
+    pkt_t p = {};
+    p.src = PKT_SRC_DETACH;
+    p.slot = (uint8_t)slot;
+    p.t_us = micros();
+    strncpy((char *)p.data, s.profile.name ? s.profile.name : "UNKNOWN PAD", sizeof(p.data) - 1);
+    xQueueSend(s_pkt_q, &p, portMAX_DELAY);
+}
+
+// Every transfer is back: the device can be closed and the slot reused
+void usb_lc_close(int slot) {
+    UsbSlot &s = usb_slots[slot];
+    usb_host_endpoint_clear(s.dev, s.in_ep);
+    usb_host_interface_release(s_client, s.dev, s.if_num);
+    usb_host_device_close(s_client, s.dev);
+    s.dev = nullptr;
+}
+
+// Host library context: only queue the event, usb_client_task acts on it
+static void client_event_cb(const usb_host_client_event_msg_t *msg, void *arg) {
+    UsbDevEvent e = {};
+    e.t_us = micros();
+    if (msg->event == USB_HOST_CLIENT_EVENT_NEW_DEV) {
+        e.type = USB_EV_NEW;
+        e.addr = msg->new_dev.address;
+    } else if (msg->event == USB_HOST_CLIENT_EVENT_DEV_GONE) {
+        e.type = USB_EV_GONE;
+        e.dev = (void *)msg->dev_gone.dev_hdl;
+    } else {
+        return;
+    }
+    if (xQueueSend(s_dev_evt_q, &e, 0) != pdTRUE) usb_dev_evt_dropped++;
+}
+
+// Applies the queued attach / detach events in order (called from usb_client_task)
+inline void usb_poll_device_events() {
+    UsbDevEvent e;
+    while (xQueueReceive(s_dev_evt_q, &e, 0) == pdTRUE) {
+        UsbLcResult r = usb_lc_event(e, micros());
+        if (r == LC_POOL_FULL) Serial2.println("\n>>> USB DEVICE POOL FULL: device ignored <<<");
+        if (r == LC_DEFERRED) Serial2.println("\n>>> USB DEVICE POOL BUSY: device waits for a slot to drain <<<");
+    }
+    usb_lc_poll(micros());
+}
+
+// Client event pump: sleeps until the USB stack has something for us (transfers, hot-plug).
+// Devices are opened here too, so the synchronous descriptor reads never race the pump.
+// While a slot drains, the pump wakes every 20 ms so a stuck drain is retried.
+void usb_client_task(void *arg) {
+    while (1) {
+        bool draining = false;
+        for (int i = 0; i < USB_MAX_DEVICES; i++) if (usb_life[i].phase == SLOT_DRAINING) draining = true;
+        usb_host_client_handle_events(s_client, draining ? pdMS_TO_TICKS(20) : portMAX_DELAY);
+        usb_poll_device_events();
+    }
+}
+
+void usb_lib_task(void *arg) {
+    while (1) {
+        uint32_t f;
+        usb_host_lib_handle_events(portMAX_DELAY, &f);
+    }
+}
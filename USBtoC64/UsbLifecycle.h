@@ -0,0 +1,194 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Advanced v1.1
+// File: UsbLifecycle.h
+// Description: Per-device hot-plug state machine (attach, drain, close) and reconnect timing
+// ==========================================
+#pragma once
+
+// Plain C++ on purpose (no Arduino / ESP-IDF headers): tools/hotplug_stress.cpp compiles it on
+// a PC against a mocked host. USB_MAX_DEVICES and USB_XFER_RING come from Globals.h there too.
+#include <stdint.h>
+#include <string.h>
+
+// ==========================================
+// 🔁 PART 1: STATES AND EVENTS
+// ==========================================
+// FREE -> ACTIVE    NEW_DEV event, the device opened and claimed: the IN ring is submitted
+// ACTIVE -> DRAINING DEV_GONE event: endpoint halted and flushed, nothing is resubmitted
+// DRAINING -> FREE   the last in-flight transfer called back: interface released, device closed
+// A slot is never reused while one of its transfers is still owned by the host stack, and the
+// device is never closed under a transfer (ESP-IDF refuses it and the handle leaks until reboot).
+// All calls come from the USB client task (the transfer callbacks run inside its event pump),
+// except usb_lc_first_report() which the loop calls with its own slot.
+
+enum UsbLcPhase : uint8_t { SLOT_FREE, SLOT_ACTIVE, SLOT_DRAINING };
+enum UsbDevEventType : uint8_t { USB_EV_NEW, USB_EV_GONE };
+
+struct UsbDevEvent {
+    uint8_t type;
+    uint8_t addr;      // USB_EV_NEW
+    void *dev;         // USB_EV_GONE: the handle the open hook returned
+    uint32_t t_us;     // When the host library reported it
+};
+
+struct UsbLcSlot {
+    uint8_t phase;
+    uint8_t inflight;          // Transfers owned by the host stack
+    void *dev;
+    uint32_t t_event_us;       // NEW_DEV event
+    uint32_t t_open_us;        // Opened, claimed, ring submitted
+    uint32_t t_first_us;       // First report routed by the loop (0 = none yet)
+    uint32_t t_drain_us;       // DEV_GONE handled
+    uint32_t t_cancel_us;      // Last halt + flush of the drain
+};
+
+#define USB_LC_HISTORY        32    // Reconnect times kept for 'usb'
+#define USB_LC_PENDING        4     // NEW_DEV events waiting for a draining slot
+#define USB_LC_DRAIN_RETRY_US 100000 // A drain still open after this is cancelled again
+
+struct UsbLcStats {
+    uint32_t attaches, detaches, rejected, deferred, drain_retries, open_failed;
+    uint32_t drain_max_us;
+    uint32_t lat_us[USB_LC_HISTORY];   // NEW_DEV -> first routed report
+    uint32_t lat_n;                    // Total samples (ring index = lat_n % USB_LC_HISTORY)
+};
+
+enum UsbLcResult : uint8_t { LC_OK, LC_IGNORED, LC_DEFERRED, LC_POOL_FULL, LC_OPEN_FAILED };
+
+static UsbLcSlot usb_life[USB_MAX_DEVICES];
+static UsbLcStats usb_lc_stats;
+static UsbDevEvent usb_lc_pending[USB_LC_PENDING];
+static int usb_lc_num_pending = 0;
+
+// --- Platform hooks (UsbDevices.h on the adapter, the mock in tools/hotplug_stress.cpp) ---
+void *usb_lc_open(int slot, uint8_t addr);   // Open, parse, claim. nullptr = not ours / failed
+bool usb_lc_submit(int slot, int k);         // Submit IN transfer k of the slot
+void usb_lc_cancel(int slot);                // Halt + flush: every in-flight transfer calls back
+void usb_lc_close(int slot);                 // Release the interface, close the device
+
+
+// ==========================================
+// ⚙️ PART 2: TRANSITIONS
+// ==========================================
+
+inline void usb_lc_reset() {
+    memset(usb_life, 0, sizeof(usb_life));
+    memset(&usb_lc_stats, 0, sizeof(usb_lc_stats));
+    usb_lc_num_pending = 0;
+}
+
+inline void usb_lc_finish_drain(int slot, uint32_t now_us) {
+    UsbLcSlot &l = usb_life[slot];
+    usb_lc_close(slot);
+    uint32_t d = now_us - l.t_drain_us;
+    if (d > usb_lc_stats.drain_max_us) usb_lc_stats.drain_max_us = d;
+    l.phase = SLOT_FREE;
+    l.dev = nullptr;
+}
+
+inline UsbLcResult usb_lc_attach(const UsbDevEvent &e, uint32_t now_us) {
+    int slot = -1;
+    bool draining = false;
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        if (usb_life[i].phase == SLOT_FREE && slot < 0) slot = i;
+        if (usb_life[i].phase == SLOT_DRAINING) draining = true;
+    }
+    if (slot < 0) {
+        // A slot frees up as soon as its drain completes: retry then instead of dropping the pad
+        if (draining && usb_lc_num_pending < USB_LC_PENDING) {
+            usb_lc_pending[usb_lc_num_pending++] = e;
+            usb_lc_stats.deferred++;
+            return LC_DEFERRED;
+        }
+        usb_lc_stats.rejected++;
+        return LC_POOL_FULL;
+    }
+
+    void *dev = usb_lc_open(slot, e.addr);
+    if (!dev) return LC_IGNORED;
+
+    UsbLcSlot &l = usb_life[slot];
+    l.dev = dev;
+    l.inflight = 0;
+    l.t_event_us = e.t_us;
+    l.t_first_us = 0;
+    l.phase = SLOT_ACTIVE;
+    for (int k = 0; k < USB_XFER_RING; k++) {
+        if (usb_lc_submit(slot, k)) l.inflight++;
+    }
+    l.t_open_us = now_us;
+    if (!l.inflight) {
+        // Nothing could be queued: give the slot back right away
+        usb_lc_stats.open_failed++;
+        l.t_drain_us = now_us;
+        usb_lc_cancel(slot);
+        usb_lc_finish_drain(slot, now_us);
+        return LC_OPEN_FAILED;
+    }
+    usb_lc_stats.attaches++;
+    return LC_OK;
+}
+
+inline void usb_lc_detach(const UsbDevEvent &e, uint32_t now_us) {
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        UsbLcSlot &l = usb_life[i];
+        if (l.phase != SLOT_ACTIVE || l.dev != e.dev) continue;
+        l.phase = SLOT_DRAINING;
+        l.t_drain_us = now_us;
+        l.t_cancel_us = now_us;
+        usb_lc_stats.detaches++;
+        usb_lc_cancel(i);
+        if (!l.inflight) usb_lc_finish_drain(i, now_us);
+    }
+}
+
+// One device event from the queue
+inline UsbLcResult usb_lc_event(const UsbDevEvent &e, uint32_t now_us) {
+    if (e.type == USB_EV_NEW) return usb_lc_attach(e, now_us);
+    usb_lc_detach(e, now_us);
+    return LC_OK;
+}
+
+// Transfer callback, after the report (if any) was queued. True = transfer resubmitted.
+inline bool usb_lc_xfer_done(int slot, int k, bool completed, uint32_t now_us) {
+    UsbLcSlot &l = usb_life[slot];
+    if (l.inflight) l.inflight--;
+    if (l.phase == SLOT_ACTIVE && completed) {
+        if (usb_lc_submit(slot, k)) { l.inflight++; return true; }
+        return false;
+    }
+    if (l.phase == SLOT_DRAINING && !l.inflight) usb_lc_finish_drain(slot, now_us);
+    return false;
+}
+
+// After every event pump pass: stuck drains are cancelled again, deferred arrivals retried
+inline void usb_lc_poll(uint32_t now_us) {
+    for (int i = 0; i < USB_MAX_DEVICES; i++) {
+        UsbLcSlot &l = usb_life[i];
+        if (l.phase == SLOT_DRAINING && now_us - l.t_cancel_us > USB_LC_DRAIN_RETRY_US) {
+            usb_lc_stats.drain_retries++;
+            l.t_cancel_us = now_us;
+            usb_lc_cancel(i);
+        }
+    }
+    int n = usb_lc_num_pending;
+    if (!n) return;
+    UsbDevEvent retry[USB_LC_PENDING];
+    memcpy(retry, usb_lc_pending, sizeof(UsbDevEvent) * n);
+    usb_lc_num_pending = 0;
+    for (int i = 0; i < n; i++) {
+        bool free_slot = false;
+        for (int s = 0; s < USB_MAX_DEVICES; s++) if (usb_life[s].phase == SLOT_FREE) free_slot = true;
+        if (free_slot) usb_lc_attach(retry[i], now_us);
+        else usb_lc_pending[usb_lc_num_pending++] = retry[i];
+    }
+}
+
+// Loop task: a report of this slot was routed to the DB9
+inline void usb_lc_first_report(int slot, uint32_t now_us) {
+    UsbLcSlot &l = usb_life[slot];
+    if (l.phase != SLOT_ACTIVE || l.t_first_us) return;
+    l.t_first_us = now_us ? now_us : 1;
+    usb_lc_stats.lat_us[usb_lc_stats.lat_n % USB_LC_HISTORY] = now_us - l.t_event_us;
+    usb_lc_stats.lat_n++;
+}
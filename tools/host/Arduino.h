@@ -0,0 +1,94 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/Arduino.h
+// Description: Arduino core on a PC, enough to compile the firmware's decode path (InputEngine.h)
+//              and the configurator's JoystickMapping.h into tools/trace_replay.cpp
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+#include <cstdlib>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+
+using std::abs;
+
+#define LOW  0
+#define HIGH 1
+#define INPUT             0x01
+#define OUTPUT            0x03
+#define INPUT_PULLUP      0x05
+#define INPUT_PULLDOWN    0x09
+#define OUTPUT_OPEN_DRAIN 0x13
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+#define SERIAL_8N1 0x800001c
+
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+
+// --- Time: the replay clock (host_time_us, esp_timer.h), never the wall clock ---
+inline unsigned long millis() { return (unsigned long)(host_time_us / 1000); }
+inline unsigned long micros() { return (unsigned long)host_time_us; }
+inline void delay(uint32_t) {}
+inline void delayMicroseconds(uint32_t) {}
+
+// --- Pins: nothing is wired, every line reads released (HIGH) ---
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+#define digitalPinToInterrupt(p) (p)
+inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+inline void attachInterruptArg(uint8_t, void (*)(void *), void *, int) {}
+inline void detachInterrupt(uint8_t) {}
+
+typedef struct hw_timer_s hw_timer_t;
+inline hw_timer_t *timerBegin(uint32_t) { return nullptr; }
+inline void timerAlarm(hw_timer_t *, uint64_t, bool, uint64_t) {}
+inline void timerWrite(hw_timer_t *, uint64_t) {}
+inline uint64_t timerRead(hw_timer_t *) { return 0; }
+inline void timerStart(hw_timer_t *) {}
+inline void timerStop(hw_timer_t *) {}
+inline void timerAttachInterrupt(hw_timer_t *, void (*)(void)) {}
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+inline bool setCpuFrequencyMhz(uint32_t) { return true; }
+
+inline size_t strlcpy(char *d, const char *s, size_t n) {
+    size_t len = strlen(s);
+    if (n) { size_t k = len < n - 1 ? len : n - 1; memcpy(d, s, k); d[k] = 0; }
+    return len;
+}
+
+// --- Serial: the CLI never runs on the host, its output is dropped ---
+class HardwareSerial {
+public:
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void updateBaudRate(unsigned long) {}
+    void flush() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t) { return 1; }
+    size_t write(const uint8_t *, size_t n) { return n; }
+    template <class T> size_t print(const T &, int = 10) { return 0; }
+    template <class T> size_t println(const T &, int = 10) { return 0; }
+    size_t println() { return 0; }
+    size_t printf(const char *, ...) __attribute__((format(printf, 2, 3))) { return 0; }
+};
+inline HardwareSerial Serial, Serial2;
+
+struct EspClass { void restart() {} };
+inline EspClass ESP;
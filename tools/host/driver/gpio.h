@@ -0,0 +1,11 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/driver/gpio.h
+// Description: GPIO driver types
+// ==========================================
+#pragma once
+
+#include "esp_err.h"
+#include "soc/gpio_struct.h"
+
+typedef int gpio_num_t;
@@ -0,0 +1,12 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_attr.h
+// Description: Placement attributes are no-ops on a PC
+// ==========================================
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
@@ -0,0 +1,13 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_cpu.h
+// Description: Cycle counter (host clock, for the profiler probes)
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+
+inline uint32_t esp_cpu_get_cycle_count() {
+    return (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+}
@@ -0,0 +1,14 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_err.h
+// Description: ESP-IDF error codes (tools/trace_replay.cpp)
+// ==========================================
+#pragma once
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERROR_CHECK(x) (void)(x)
+inline const char* esp_err_to_name(esp_err_t) { return "ESP_ERR"; }
@@ -0,0 +1,25 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_heap_caps.h
+// Description: Heap capability queries (all empty on a PC)
+// ==========================================
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+typedef struct {
+    size_t total_free_bytes, total_allocated_bytes, largest_free_block, minimum_free_bytes;
+    size_t allocated_blocks, free_blocks, total_blocks;
+} multi_heap_info_t;
+
+inline void heap_caps_get_info(multi_heap_info_t *info, uint32_t) { memset(info, 0, sizeof(*info)); }
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return 0; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
@@ -0,0 +1,12 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_system.h
+// Description: Restart and heap queries
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+
+inline void esp_restart(void) {}
+inline uint32_t esp_get_free_heap_size(void) { return 0; }
+inline uint32_t esp_get_minimum_free_heap_size(void) { return 0; }
@@ -0,0 +1,28 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/esp_timer.h
+// Description: esp_timer on the replay clock (host_time_us); timers never fire
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+inline uint64_t host_time_us = 0; // Set by the host tool (trace_replay: the report's time stamp)
+
+typedef struct esp_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *);
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *, esp_timer_handle_t *out) { *out = nullptr; return ESP_FAIL; }
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t, uint64_t) { return ESP_OK; }
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t) { return ESP_OK; }
+inline esp_err_t esp_timer_stop(esp_timer_handle_t) { return ESP_OK; }
+inline int64_t esp_timer_get_time(void) { return (int64_t)host_time_us; }
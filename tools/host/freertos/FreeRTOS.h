@@ -0,0 +1,39 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/freertos/FreeRTOS.h
+// Description: FreeRTOS types; critical sections are no-ops (one thread)
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t StackType_t;
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define configNUMBER_OF_CORES 2
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY 0x7fffffff
+
+typedef struct { int x; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(m)      (void)(m)
+#define portEXIT_CRITICAL(m)       (void)(m)
+#define portENTER_CRITICAL_ISR(m)  (void)(m)
+#define portEXIT_CRITICAL_ISR(m)   (void)(m)
+#define portENTER_CRITICAL_SAFE(m) (void)(m)
+#define portEXIT_CRITICAL_SAFE(m)  (void)(m)
+#define portYIELD_FROM_ISR(...) do {} while (0)
+#define xPortInIsrContext() 0
+
+typedef struct { uint8_t d[128]; } StaticTask_t;
+typedef struct { uint8_t d[96]; } StaticQueue_t;
+
+inline BaseType_t xPortGetCoreID(void) { return 1; } // The loop's core
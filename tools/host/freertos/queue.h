@@ -0,0 +1,18 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/freertos/queue.h
+// Description: Queue API (always empty)
+// ==========================================
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t) { return nullptr; }
+inline QueueHandle_t xQueueCreateStatic(UBaseType_t, UBaseType_t, uint8_t *, StaticQueue_t *) { return nullptr; }
+inline BaseType_t xQueueSend(QueueHandle_t, const void *, TickType_t) { return pdFALSE; }
+inline BaseType_t xQueueSendFromISR(QueueHandle_t, const void *, BaseType_t *) { return pdFALSE; }
+inline BaseType_t xQueueReceive(QueueHandle_t, void *, TickType_t) { return pdFALSE; }
+inline BaseType_t xQueueReset(QueueHandle_t) { return pdPASS; }
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t) { return 0; }
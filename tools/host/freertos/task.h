@@ -0,0 +1,33 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/freertos/task.h
+// Description: Task API (nothing is ever scheduled)
+// ==========================================
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef enum { eRunning, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *h, BaseType_t) { *h = nullptr; return pdFALSE; }
+inline TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, StackType_t *, StaticTask_t *, BaseType_t) { return nullptr; }
+inline void vTaskDelay(TickType_t) {}
+inline TickType_t xTaskGetTickCount(void) { return 0; }
+inline UBaseType_t uxTaskGetNumberOfTasks(void) { return 0; }
+inline UBaseType_t uxTaskGetSystemState(TaskStatus_t *, UBaseType_t, uint32_t *total) { if (total) *total = 0; return 0; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+inline TaskHandle_t xTaskGetCurrentTaskHandle(void) { return nullptr; }
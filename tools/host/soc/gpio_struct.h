@@ -0,0 +1,15 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/soc/gpio_struct.h
+// Description: GPIO register block as plain memory: writes land nowhere
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t out, out_w1ts, out_w1tc, enable, enable_w1ts, enable_w1tc, in, status, status_w1tc;
+    struct { volatile uint32_t val; } out1, out1_w1ts, out1_w1tc, in1;
+} gpio_dev_t;
+
+inline gpio_dev_t GPIO;
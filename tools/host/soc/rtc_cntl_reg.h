@@ -0,0 +1,10 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/soc/rtc_cntl_reg.h
+// Description: RTC register used by the 'flash' command
+// ==========================================
+#pragma once
+
+#define RTC_CNTL_OPTION1_REG 0
+#define RTC_CNTL_FORCE_DOWNLOAD_BOOT 1
+#define REG_WRITE(r, v) (void)(v)
@@ -0,0 +1,8 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/usb/usb_helpers.h
+// Description: USB descriptor helpers (unused on a PC)
+// ==========================================
+#pragma once
+
+#include "usb_host.h"
@@ -0,0 +1,12 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Host build shim
+// File: tools/host/usb/usb_host.h
+// Description: USB host library types (Globals.h only holds handles)
+// ==========================================
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct usb_host_client_s *usb_host_client_handle_t;
+typedef struct usb_device_s *usb_device_handle_t;
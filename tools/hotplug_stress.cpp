@@ -0,0 +1,299 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Hot-Plug Stress (host tool)
+// File: tools/hotplug_stress.cpp
+// Description: Drives the firmware's hot-plug state machine (USBtoC64/UsbLifecycle.h) through
+//              thousands of attach/detach cycles against a mocked USB host stack, checks the
+//              host API rules and prints reconnect-time percentiles.
+//
+// Build: g++ -O2 -std=c++17 -o hotplug_stress tools/hotplug_stress.cpp
+// Usage: hotplug_stress [--cycles 5000] [--ports 6] [--seed 1] [-v]
+//   --cycles  plug/unplug actions to run
+//   --ports   hub ports (more ports than USB_MAX_DEVICES exercises the pool-full / deferred paths)
+//   -v        print every attach, detach and rule violation
+// ==========================================
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#define USB_MAX_DEVICES 4
+#define USB_XFER_RING   2
+#include "../USBtoC64/UsbLifecycle.h"
+
+// ==========================================
+// 🎲 PART 1: MOCK TIMING (one pseudo-random stream per seed)
+// ==========================================
+// Enumeration 30-150 ms after plug-in, reports every 1-8 ms, DEV_GONE 1-5 ms after the pull,
+// cancelled transfers back within 0.5 ms. 2 % of cancels are lost by the mock, so the drain
+// retry path runs too. 20 % of replugs come back within 10 ms.
+
+static uint64_t rng_state = 1;
+
+static uint32_t rnd(uint32_t lo, uint32_t hi) {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lo + (uint32_t)((rng_state >> 33) % (hi - lo + 1));
+}
+
+static bool verbose = false;
+static uint64_t now_us = 0;
+
+enum SimKind { EV_ENUM_DONE, EV_GONE_MSG, EV_XFER_BACK, EV_ACTION, EV_PULL_ALL, EV_IDLE };
+
+struct SimEvent {
+    uint64_t t;
+    uint64_t seq;
+    int kind;
+    int a, b;       // port / slot, transfer
+    uint32_t gen;   // transfer generation (stale completions are ignored)
+    bool operator>(const SimEvent &o) const { return t != o.t ? t > o.t : seq > o.seq; }
+};
+
+static std::priority_queue<SimEvent, std::vector<SimEvent>, std::greater<SimEvent>> sim_q;
+static uint64_t sim_seq = 0;
+
+static void schedule(uint64_t t, int kind, int a, int b = 0, uint32_t gen = 0) {
+    sim_q.push({ t, sim_seq++, kind, a, b, gen });
+}
+
+
+// ==========================================
+// 🔌 PART 2: MOCKED HOST STACK
+// ==========================================
+// Mirrors the ESP-IDF rules the firmware depends on: a gone device takes no transfers, a
+// transfer cannot be submitted twice, a device with transfers in flight cannot be closed.
+
+struct MockDev {
+    int port;
+    uint8_t addr;
+    bool present;      // Still on the bus
+    bool enumerated;   // NEW_DEV delivered
+    bool opened, closed;
+    uint64_t t_plug;
+    uint32_t period_us;
+};
+
+struct MockXfer {
+    bool inflight;
+    uint32_t gen;
+    int dev;           // Index in devs
+};
+
+static std::vector<MockDev> devs;
+static int port_dev[16];
+static MockXfer xfers[USB_MAX_DEVICES][USB_XFER_RING];
+static int slot_dev[USB_MAX_DEVICES];
+static uint8_t next_addr = 1;
+
+static uint64_t violations = 0, lost_cancels = 0, open_races = 0;
+static std::vector<uint32_t> lat_plug, lat_event;
+
+static void violation(const char *what, int slot) {
+    violations++;
+    if (verbose || violations <= 10) printf("  !! %8.3f ms  slot %d: %s\n", now_us / 1000.0, slot, what);
+}
+
+static void *handle_of(int d) { return (void *)(uintptr_t)(d + 1); }
+
+void *usb_lc_open(int slot, uint8_t addr) {
+    for (int k = 0; k < USB_XFER_RING; k++) {
+        if (xfers[slot][k].inflight) violation("slot reused with a transfer in flight", slot);
+    }
+    // Addresses wrap after 127 devices: the newest device holding it is the one the event meant
+    for (int d = (int)devs.size() - 1; d >= 0; d--) {
+        MockDev &m = devs[d];
+        if (m.addr != addr) continue;
+        if (m.opened) return nullptr;
+        if (!m.present) { open_races++; return nullptr; } // Pulled between NEW_DEV and open
+        m.opened = true;
+        slot_dev[slot] = d;
+        if (verbose) printf("  %8.3f ms  attach port %d -> slot %d\n", now_us / 1000.0, m.port, slot);
+        return handle_of(d);
+    }
+    return nullptr;
+}
+
+bool usb_lc_submit(int slot, int k) {
+    MockXfer &x = xfers[slot][k];
+    MockDev &m = devs[slot_dev[slot]];
+    if (x.inflight) { violation("transfer submitted twice", slot); return false; }
+    if (m.closed) { violation("submit on a closed device", slot); return false; }
+    if (!m.present) return false; // ESP_ERR_INVALID_STATE
+    x.inflight = true;
+    x.dev = slot_dev[slot];
+    x.gen++;
+    schedule(now_us + m.period_us, EV_XFER_BACK, slot, k, x.gen);
+    return true;
+}
+
+void usb_lc_cancel(int slot) {
+    for (int k = 0; k < USB_XFER_RING; k++) {
+        MockXfer &x = xfers[slot][k];
+        if (!x.inflight) continue;
+        x.gen++; // The pending completion is replaced by the cancel callback
+        if (rnd(1, 100) <= 2) { lost_cancels++; continue; }
+        schedule(now_us + rnd(0, 500), EV_XFER_BACK, slot, k, x.gen);
+    }
+}
+
+void usb_lc_close(int slot) {
+    for (int k = 0; k < USB_XFER_RING; k++) {
+        if (xfers[slot][k].inflight) violation("device closed under a transfer", slot);
+    }
+    MockDev &m = devs[slot_dev[slot]];
+    if (m.closed) violation("device closed twice", slot);
+    m.closed = true;
+    if (verbose) printf("  %8.3f ms  closed slot %d (port %d)\n", now_us / 1000.0, slot, m.port);
+}
+
+
+// ==========================================
+// 🔁 PART 3: EVENT PUMP (usb_client_task)
+// ==========================================
+
+static void pump(const SimEvent &e) {
+    switch (e.kind) {
+        case EV_ENUM_DONE: {
+            MockDev &m = devs[e.a];
+            if (!m.present) break; // Pulled during enumeration: the host library never reports it
+            m.enumerated = true;
+            UsbDevEvent ev = {};
+            ev.type = USB_EV_NEW;
+            ev.addr = m.addr;
+            ev.t_us = (uint32_t)now_us;
+            usb_lc_event(ev, (uint32_t)now_us);
+            break;
+        }
+        case EV_GONE_MSG: {
+            UsbDevEvent ev = {};
+            ev.type = USB_EV_GONE;
+            ev.dev = handle_of(e.a);
+            ev.t_us = (uint32_t)now_us;
+            usb_lc_event(ev, (uint32_t)now_us);
+            break;
+        }
+        case EV_XFER_BACK: {
+            MockXfer &x = xfers[e.a][e.b];
+            if (!x.inflight || x.gen != e.gen) break; // Superseded by a cancel
+            x.inflight = false;
+            bool completed = devs[x.dev].present && usb_life[e.a].phase == SLOT_ACTIVE;
+            if (completed && !usb_life[e.a].t_first_us) {
+                // The loop routes the report ~100 us later
+                uint32_t t = (uint32_t)now_us + 100;
+                usb_lc_first_report(e.a, t);
+                lat_event.push_back(t - usb_life[e.a].t_event_us);
+                lat_plug.push_back((uint32_t)(t - devs[x.dev].t_plug));
+            }
+            usb_lc_xfer_done(e.a, e.b, completed, (uint32_t)now_us);
+            break;
+        }
+        default:
+            break;
+    }
+    usb_lc_poll((uint32_t)now_us);
+}
+
+static void plug(int port) {
+    MockDev m = {};
+    m.port = port;
+    m.addr = next_addr;
+    next_addr = next_addr >= 127 ? 1 : next_addr + 1;
+    m.present = true;
+    m.t_plug = now_us;
+    m.period_us = 1000u * rnd(1, 8);
+    devs.push_back(m);
+    port_dev[port] = (int)devs.size() - 1;
+    schedule(now_us + 1000ull * rnd(30, 150), EV_ENUM_DONE, port_dev[port]);
+}
+
+static void unplug(int port) {
+    int d = port_dev[port];
+    port_dev[port] = -1;
+    devs[d].present = false;
+    // Transfers already in flight still call back at their time, as failed: they race DEV_GONE
+    if (devs[d].enumerated) schedule(now_us + rnd(1000, 5000), EV_GONE_MSG, d);
+}
+
+
+// ==========================================
+// 📊 PART 4: MAIN
+// ==========================================
+
+static void percentiles(const char *name, std::vector<uint32_t> &v) {
+    if (v.empty()) { printf(" %-26s (no samples)\n", name); return; }
+    std::sort(v.begin(), v.end());
+    auto p = [&](double q) { return v[std::min(v.size() - 1, (size_t)(q * v.size()))] / 1000.0; };
+    printf(" %-26s n=%zu  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms\n", name, v.size(), p(0.5), p(0.9), p(0.99),
+           v.back() / 1000.0);
+}
+
+int main(int argc, char **argv) {
+    int cycles = 5000, ports = 6;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--cycles") && i + 1 < argc) cycles = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ports") && i + 1 < argc) ports = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) rng_state = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-v")) verbose = true;
+        else {
+            fprintf(stderr, "Usage: %s [--cycles N] [--ports 1-16] [--seed S] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ports < 1 || ports > 16) ports = 6;
+    for (int &p : port_dev) p = -1;
+    usb_lc_reset();
+
+    // Actions: a random port is plugged or pulled, sometimes right after its last change
+    uint64_t t_action = 0;
+    for (int c = 0; c < cycles; c++) {
+        t_action += rnd(1, 100) <= 20 ? rnd(0, 10000) : 1000ull * rnd(20, 400);
+        schedule(t_action, EV_ACTION, (int)rnd(0, ports - 1));
+    }
+    bool idle_armed = false;
+    // Everything pulled at the end: every slot must come back
+    schedule(t_action + 1000000, EV_PULL_ALL, 0);
+    while (!sim_q.empty()) {
+        SimEvent e = sim_q.top();
+        sim_q.pop();
+        now_us = e.t;
+        if (e.kind == EV_ACTION) {
+            if (port_dev[e.a] < 0) plug(e.a);
+            else unplug(e.a);
+            continue;
+        }
+        if (e.kind == EV_PULL_ALL) {
+            for (int p = 0; p < ports; p++) if (port_dev[p] >= 0) unplug(p);
+            continue;
+        }
+        if (e.kind == EV_IDLE) idle_armed = false;
+        pump(e);
+        // usb_client_task wakes every 20 ms while a slot drains
+        for (int s = 0; s < USB_MAX_DEVICES && !idle_armed; s++) {
+            if (usb_life[s].phase == SLOT_DRAINING) {
+                schedule(now_us + 20000, EV_IDLE, 0);
+                idle_armed = true;
+            }
+        }
+    }
+
+    size_t leaked = 0;
+    for (const MockDev &m : devs) if (m.opened && !m.closed) leaked++;
+    int busy = 0;
+    for (int s = 0; s < USB_MAX_DEVICES; s++) if (usb_life[s].phase != SLOT_FREE) busy++;
+    const UsbLcStats &st = usb_lc_stats;
+
+    printf("=== HOT-PLUG STRESS: %d actions on %d ports, %d slots, %d transfers each, %.1f s simulated ===\n",
+           cycles, ports, USB_MAX_DEVICES, USB_XFER_RING, now_us / 1e6);
+    printf(" Devices   : %zu plugged, %lu attached, %lu detached, %lu deferred, %lu rejected (pool full)\n", devs.size(),
+           (unsigned long)st.attaches, (unsigned long)st.detaches, (unsigned long)st.deferred, (unsigned long)st.rejected);
+    printf(" Races     : %llu pulled before open, %llu cancels lost by the stack -> %lu drain retries, longest drain %.2f ms\n",
+           (unsigned long long)open_races, (unsigned long long)lost_cancels, (unsigned long)st.drain_retries, st.drain_max_us / 1000.0);
+    percentiles("NEW_DEV -> first report", lat_event);
+    percentiles("plug-in -> first report", lat_plug);
+    printf(" Rules     : %llu violations, %zu devices left open, %d slots not free at the end\n",
+           (unsigned long long)violations, leaked, busy);
+    bool ok = !violations && !leaked && !busy;
+    printf(" %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,236 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Inject Player (Linux host tool)
+// File: tools/inject_player.cpp
+// Description: Streams a timed joystick script to the adapter's 'inject' mode and reports
+//              underruns / late frames. Flow control follows the adapter's status frames.
+//
+// Build: g++ -O2 -std=c++17 -o inject_player tools/inject_player.cpp
+// Usage: inject_player /dev/ttyUSB0 script.txt [-b 921600] [--start] [--lead 100] [--stay]
+//   --start   open the port at 115200 and send 'inject <baud>' first
+//   --lead    ms between the clock reset and script time 0 (head start for the queue)
+//   --stay    do not leave inject mode at the end
+//
+// Script: one frame per line, '<time ms> <state>' with state '-' (all released), a hex word
+// (0x0011) or names joined by '+': UP DOWN LEFT RIGHT FIRE1 FIRE2 FIRE3. '#' starts a comment.
+//   0     -
+//   500   RIGHT
+//   520   RIGHT+FIRE1
+//   600.5 -
+// ==========================================
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../USBtoC64/TelemetryProtocol.h"
+
+static double now_s() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ==========================================
+// 🔌 PART 1: SERIAL PORT
+// ==========================================
+
+static speed_t baud_constant(unsigned long baud) {
+    switch (baud) {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default:      return 0;
+    }
+}
+
+static bool set_baud(int fd, unsigned long baud) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, baud_constant(baud));
+    cfsetospeed(&tio, baud_constant(baud));
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) return false;
+    tcflush(fd, TCIOFLUSH);
+    return true;
+}
+
+static uint16_t g_seq = 0;
+
+static void send_frame(int fd, uint8_t type, const void *payload, uint8_t len) {
+    uint8_t out[TELEM_HEADER_LEN + TELEM_MAX_PAYLOAD + TELEM_CRC_LEN];
+    size_t n = telem_build_frame(out, type, g_seq++, payload, len);
+    if (write(fd, out, n) != (ssize_t)n) perror("write");
+}
+
+// Reads for up to timeout_s; returns true and fills st when a status frame arrived
+static bool read_status(int fd, TelemDecoder &dec, InjStatus &st, double timeout_s) {
+    double end = now_s() + timeout_s;
+    bool got = false;
+    uint8_t rx[512];
+    do {
+        pollfd p = { fd, POLLIN, 0 };
+        int ms = (int)((end - now_s()) * 1000);
+        if (poll(&p, 1, ms < 0 ? 0 : ms) <= 0) break;
+        ssize_t n = read(fd, rx, sizeof(rx));
+        for (ssize_t i = 0; i < n; i++) {
+            if (dec.push(rx[i]) && dec.type() == TELEM_TYPE_INJ_STATUS && dec.len() >= sizeof(InjStatus)) {
+                memcpy(&st, dec.payload(), sizeof(st));
+                got = true;
+            }
+        }
+    } while (!got);
+    return got;
+}
+
+// ==========================================
+// 📜 PART 2: SCRIPT
+// ==========================================
+
+static bool parse_state(const char *s, uint16_t &w) {
+    static const struct { const char *name; uint16_t bit; } NAMES[] = {
+        { "UP", 1 << 0 }, { "DOWN", 1 << 1 }, { "LEFT", 1 << 2 }, { "RIGHT", 1 << 3 },
+        { "FIRE1", 1 << 4 }, { "FIRE2", 1 << 5 }, { "FIRE3", 1 << 6 },
+    };
+    w = 0;
+    if (!strcmp(s, "-")) return true;
+    if (!strncmp(s, "0x", 2)) { w = (uint16_t)strtoul(s, nullptr, 16); return true; }
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", s);
+    for (char *tok = strtok(buf, "+"); tok; tok = strtok(nullptr, "+")) {
+        bool found = false;
+        for (auto &n : NAMES) if (!strcasecmp(tok, n.name)) { w |= n.bit; found = true; }
+        if (!found) return false;
+    }
+    return true;
+}
+
+static bool load_script(const char *path, std::vector<InjFrame> &out, uint32_t lead_us) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[256];
+    int ln = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ln++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        double t_ms;
+        char state[128];
+        int n = sscanf(line, "%lf %127s", &t_ms, state);
+        if (n <= 0) continue;
+        InjFrame fr;
+        if (n != 2 || t_ms < 0 || !parse_state(state, fr.word)) {
+            fprintf(stderr, "%s:%d: expected '<time ms> <state>'\n", path, ln);
+            fclose(f);
+            return false;
+        }
+        fr.t_us = lead_us + (uint32_t)(t_ms * 1000.0 + 0.5);
+        if (!out.empty() && fr.t_us < out.back().t_us) {
+            fprintf(stderr, "%s:%d: times must not go backwards\n", path, ln);
+            fclose(f);
+            return false;
+        }
+        out.push_back(fr);
+    }
+    fclose(f);
+    return true;
+}
+
+// ==========================================
+// 🚀 PART 3: MAIN
+// ==========================================
+
+int main(int argc, char **argv) {
+    const char *port = nullptr, *script = nullptr;
+    unsigned long baud = 921600;
+    double lead_ms = 100;
+    bool start = false, stay = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc) baud = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--lead") && i + 1 < argc) lead_ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--start")) start = true;
+        else if (!strcmp(argv[i], "--stay")) stay = true;
+        else if (!port) port = argv[i];
+        else script = argv[i];
+    }
+    if (!port || !script || !baud_constant(baud)) {
+        fprintf(stderr, "Usage: %s <serial port> <script> [-b 921600] [--start] [--lead ms] [--stay]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<InjFrame> frames;
+    if (!load_script(script, frames, (uint32_t)(lead_ms * 1000))) return 1;
+    if (frames.empty()) { fprintf(stderr, "%s: no frames\n", script); return 1; }
+
+    int fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) { perror(port); return 1; }
+    if (start) {
+        char cmd[32];
+        int n = snprintf(cmd, sizeof(cmd), "inject %lu\n", baud);
+        set_baud(fd, 115200);
+        if (write(fd, cmd, n) != n) perror("write");
+        tcdrain(fd);
+        usleep(150000); // Banner at 115200, then the adapter switches
+    }
+    if (!set_baud(fd, baud)) { perror("tcsetattr"); return 1; }
+
+    // Clock sync: the round trip tells how stale the adapter's clock reading is
+    TelemDecoder dec;
+    InjStatus st = {};
+    uint32_t tag = 0xC64A0001;
+    double t_sync = now_s();
+    send_frame(fd, TELEM_TYPE_INJ_SYNC, &tag, sizeof(tag));
+    bool synced = false;
+    while (read_status(fd, dec, st, 1.0)) if (st.tag == tag) { synced = true; break; }
+    if (!synced) {
+        fprintf(stderr, "No answer from the adapter (is it in 'inject' mode at %lu baud?)\n", baud);
+        return 1;
+    }
+    printf("Adapter clock %u us, round trip %.2f ms, queue %u frames\n", st.clock_us, (now_s() - t_sync) * 1000, st.ring_size);
+
+    // Clock back to 0: script time 0 is 'lead' ms from now
+    send_frame(fd, TELEM_TYPE_INJ_RESET, nullptr, 0);
+    size_t sent = 0;
+    uint32_t applied = 0, ring_size = st.ring_size;
+    double t_end = now_s() + (frames.back().t_us / 1e6) + 2.0;
+
+    while (now_s() < t_end) {
+        // Never queue more than the adapter has room for (frames still waiting = sent - applied)
+        while (sent < frames.size() && sent - applied + TELEM_INJ_MAX_FRAMES <= ring_size) {
+            size_t n = frames.size() - sent;
+            if (n > TELEM_INJ_MAX_FRAMES) n = TELEM_INJ_MAX_FRAMES;
+            send_frame(fd, TELEM_TYPE_INJ_FRAMES, &frames[sent], (uint8_t)(n * sizeof(InjFrame)));
+            sent += n;
+            if (sent == frames.size()) send_frame(fd, TELEM_TYPE_INJ_END, nullptr, 0);
+        }
+        if (read_status(fd, dec, st, 0.05)) {
+            applied = st.applied;
+            printf("\r t=%8.3f s  sent %zu/%zu  applied %u  underruns %u  late %u  ",
+                   st.clock_us / 1e6, sent, frames.size(), st.applied, st.underruns, st.late);
+            fflush(stdout);
+            if (st.applied >= frames.size()) break;
+        }
+    }
+
+    printf("\n\n=== INJECT RESULT ===\n");
+    printf(" Frames    : %u / %zu applied\n", st.applied, frames.size());
+    printf(" Underruns : %u (queue ran dry before the end)\n", st.underruns);
+    printf(" Overruns  : %u (queue full, frames lost)\n", st.overruns);
+    printf(" Late      : %u (max %.3f ms behind)\n", st.late, st.max_late_us / 1000.0);
+    printf(" Link      : %lu CRC errors, %lu bytes skipped\n", dec.crc_errors, dec.skipped);
+
+    if (!stay) send_frame(fd, TELEM_TYPE_INJ_EXIT, nullptr, 0);
+    tcdrain(fd);
+    close(fd);
+    return (st.applied == frames.size() && !st.underruns && !st.overruns && !st.late) ? 0 : 2;
+}
@@ -0,0 +1,443 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Pin Timing Simulator (host tool)
+// File: tools/pin_sim.cpp
+// Description: Runs DB9 pin edges through the SID POT and Amiga quadrature models of pinsim.h and
+//              reports the pointer position the computer decodes, lost counts and out-of-window pulses.
+//
+// Build: g++ -O2 -std=c++17 -o pin_sim tools/pin_sim.cpp
+// Usage: pin_sim edges.txt [--c64|--amiga] [--pal|--ntsc] [--sync-offset-us X Y]
+//        pin_sim --sweep [--c64|--amiga] [--pal|--ntsc] [--reports 40] [--interval-ms 8]
+//                [--jitter-us 1] [--axes xy|x|y] [--zigzag] [--csv]
+//   edges.txt  edge trace ('<time us> <LINE> <0|1>', see pinsim.h); edges at time 0 set the idle levels
+//   --sweep    generates what the firmware emits for every mouse speed (1-5) and every delta
+//              (-127..127), sent --reports times, and checks what the computer reads back
+//   --jitter-us spread of a C64 POT edge around the calibrated ISR latency
+//   --zigzag   alternates the sign of the delta on every report (direction changes)
+//   --csv      one SWEEP line per speed and delta instead of the per-speed summary
+// ==========================================
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "pinsim.h"
+
+using namespace pinsim;
+
+// ==========================================
+// 🧮 PART 1: FIRMWARE CONSTANTS (keep in sync with Globals.h / InputEngine.h)
+// ==========================================
+// Timer ticks are 0.1 us (10 MHz). C64_POT_SAFE_MODE window 64..191.
+
+struct PotCal {
+    double base_min_x, base_min_y, step_x, step_y;
+};
+
+static const PotCal CAL_PAL  = { 2450.0, 2440.0, 10.16689245, 10.14384171 };
+static const PotCal CAL_NTSC = { 2360.0, 2351.0, 9.794315054, 9.772109035 };
+
+#define FW_POT_MIN        64.0f
+#define FW_POT_MAX        191.0f
+#define FW_DELAY_OFF      10      // delayOffX/Y (ticks)
+#define FW_PULSE_LENGTH   150     // Amiga quadrature step (us)
+#define TICK_NS           100.0
+
+// BASE_MIN_X/Y + n * STEP is the delay the firmware aims at SID count n, so the calibrated delay
+// is taken as the middle of count 0: counting starts half a cycle before it.
+static double count_start_ns(double base_min, const Video &v) {
+    return base_min * TICK_NS - 0.5e9 / v.phi2_hz;
+}
+
+static float fw_mouse_multiplier(int speed) {
+    if (speed <= 1) return 0.25f;
+    if (speed == 2) return 0.50f;
+    if (speed == 3) return 1.00f;
+    if (speed == 4) return 1.50f;
+    return 2.00f;
+}
+
+// The firmware's 'final' step count for one report, with its fraction accumulator
+struct Scaler {
+    float mult, rem = 0;
+    int next(int d) {
+        float real = (float)d * mult + rem;
+        int fin = (int)real;
+        rem = real - fin;
+        return fin;
+    }
+};
+
+struct SweepOpts {
+    bool amiga = false;
+    const Video *video = &VIDEO_PAL;
+    int reports = 40;
+    double interval_ns = 8e6;
+    double jitter_ns = 1000.0;     // Spread of a POT edge around the calibrated latency (sync + timer ISR)
+    bool ax_x = true, ax_y = true;
+    bool zigzag = false;
+};
+
+struct SweepResult {
+    int64_t intended[2] = { 0, 0 };  // Counts the firmware meant to send (model orientation)
+    int64_t expected[2] = { 0, 0 };  // Counts the pins encode (C64: after the timer tick rounding)
+    int64_t decoded[2] = { 0, 0 };   // Counts the computer read
+    int64_t pending[2] = { 0, 0 };   // Amiga: steps the firmware still holds back / C64: the odd count the driver holds
+    uint64_t problems[2] = { 0, 0 }; // C64: early+late+empty pulses / Amiga: skipped states+overflows
+    SidAxisStats sid[2];
+    QuadAxisStats quad[2];
+};
+
+static uint32_t sim_rng = 1;
+
+// One interrupt's share: two of them (sync, then timer) stack up before every POT edge
+static double jitter(const SweepOpts &o) {
+    sim_rng = sim_rng * 1664525UL + 1013904223UL;
+    return o.jitter_ns * 0.5 * ((sim_rng >> 8) / 16777216.0 - 0.5);
+}
+
+static int delta_for(const SweepOpts &o, int delta, int i) {
+    return (o.zigzag && (i & 1)) ? -delta : delta;
+}
+
+
+// ==========================================
+// 🎛️ PART 2: C64 1351 GENERATOR
+// ==========================================
+// process_c64_mouse() moves delayOnX/Y per report; on every SID period handleInterrupt() arms
+// the ON timers, turnOnPotX/Y() pull the line up and the OFF timers release it 1 us later.
+// BASE_MIN_X/Y were measured on real machines, so the nominal ISR latency is part of them: the
+// model counts from the calibration and only the jitter on top of it moves the pulses.
+// 'expected' is the move the ON delay encodes in SID cycles, a wrap of the 64-191 window counted
+// as a 128-count turn of the 1351 position: what a perfect reader would get. The gap to 'intended'
+// is firmware drift (tick truncation, the 127-count window, the overshoot dropped on a wrap) and
+// is reported apart from what the SID and the driver lose.
+
+static SweepResult sweep_c64(const SweepOpts &o, int speed, int delta) {
+    const PotCal &cal = (o.video == &VIDEO_NTSC) ? CAL_NTSC : CAL_PAL;
+    const uint64_t min_x = (uint64_t)(cal.base_min_x + FW_POT_MIN * cal.step_x);
+    const uint64_t max_x = (uint64_t)(cal.base_min_x + FW_POT_MAX * cal.step_x);
+    const uint64_t min_y = (uint64_t)(cal.base_min_y + FW_POT_MIN * cal.step_y);
+    const uint64_t max_y = (uint64_t)(cal.base_min_y + FW_POT_MAX * cal.step_y);
+    uint64_t on_x = min_x, on_y = min_y;
+    Scaler sx{ fw_mouse_multiplier(speed) }, sy{ fw_mouse_multiplier(speed) };
+    const double cycle_ticks = 1e9 / o.video->phi2_hz / TICK_NS;
+    auto count_of = [&](uint64_t on, double base) { return (int64_t)floor(((double)on - base) / cycle_ticks + 0.5); };
+
+    SidPotModel::Config mc;
+    mc.video = *o.video;
+    mc.sync_to_count_ns[0] = count_start_ns(cal.base_min_x, *o.video);
+    mc.sync_to_count_ns[1] = count_start_ns(cal.base_min_y, *o.video);
+    SidPotModel model(mc);
+    SweepResult r;
+    sim_rng = (uint32_t)(speed * 1000 + delta + 128);
+
+    const double period_ns = 512.0 * 1e9 / o.video->phi2_hz;
+    const double lead_ns = 3 * o.video->frame_ns; // The driver has read a first position by then
+    const double end_ns = lead_ns + o.reports * o.interval_ns + 5 * o.video->frame_ns;
+    int next_report = 0;
+    std::vector<Edge> edges;
+    for (double t = period_ns; t < end_ns; t += period_ns) {
+        while (next_report < o.reports && lead_ns + next_report * o.interval_ns <= t) {
+            int d = delta_for(o, delta, next_report++);
+            int fx = sx.next(o.ax_x ? d : 0), fy = sy.next(o.ax_y ? d : 0);
+            r.intended[0] += fx;
+            r.intended[1] -= fy;
+            int64_t cx = count_of(on_x, cal.base_min_x), cy = count_of(on_y, cal.base_min_y);
+            int turn_x = 0, turn_y = 0;
+            float nx = (float)on_x + (float)cal.step_x * (float)fx;
+            if (nx > max_x) { nx = min_x; turn_x = 128; }
+            if (nx < min_x) { nx = max_x; turn_x = -128; }
+            on_x = (uint64_t)nx;
+            float ny = (float)on_y - (float)cal.step_y * (float)fy;
+            if (ny > max_y) { ny = min_y; turn_y = 128; }
+            if (ny < min_y) { ny = max_y; turn_y = -128; }
+            on_y = (uint64_t)ny;
+            r.expected[0] += count_of(on_x, cal.base_min_x) - cx + turn_x;
+            r.expected[1] += count_of(on_y, cal.base_min_y) - cy + turn_y;
+        }
+        uint64_t ts = (uint64_t)t;
+        double sync_isr = jitter(o);
+        uint64_t rx = ts + (uint64_t)(sync_isr + on_x * TICK_NS + jitter(o));
+        uint64_t ry = ts + (uint64_t)(sync_isr + on_y * TICK_NS + jitter(o));
+        uint64_t w = (uint64_t)(FW_DELAY_OFF * TICK_NS + jitter(o));
+        edges.clear();
+        edges.push_back({ ts, L_SYNC, 1 });
+        edges.push_back({ rx, L_POTX_DRV, 1 });
+        edges.push_back({ rx + w, L_POTX_DRV, 0 });
+        edges.push_back({ ry, L_POTY_DRV, 1 });
+        edges.push_back({ ry + w, L_POTY_DRV, 0 });
+        std::stable_sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.t_ns < b.t_ns; });
+        for (const Edge &e : edges) model.edge(e);
+    }
+    model.advance((uint64_t)end_ns);
+
+    for (int a = 0; a < 2; a++) {
+        r.sid[a] = model.axis(a);
+        r.decoded[a] = r.sid[a].decoded;
+        // The 1351 moves the pointer by 2 counts: an odd count left over is not a loss
+        int64_t left = r.expected[a] - r.decoded[a];
+        r.pending[a] = (left >= -1 && left <= 1) ? left : 0;
+        r.problems[a] = r.sid[a].early + r.sid[a].late + r.sid[a].empty;
+    }
+    return r;
+}
+
+
+// ==========================================
+// 🖱️ PART 3: AMIGA QUADRATURE GENERATOR
+// ==========================================
+// process_amiga_mouse() blocks for PULSE_LENGTH per step, X and Y interleaved; reports that
+// arrive meanwhile wait. A_Left()/A_Right() write the CURRENT QX to the pins and change QX
+// afterwards, so the pins always trail QX by the last step of the previous burst: that step is
+// reported as 'pending', not as lost.
+
+static const uint8_t FW_H[4]  = { 0, 0, 1, 1 };
+static const uint8_t FW_HQ[4] = { 0, 1, 1, 0 };
+
+static SweepResult sweep_amiga(const SweepOpts &o, int speed, int delta) {
+    AmigaQuadModel::Config mc;
+    mc.video = *o.video;
+    mc.sample_ns = 1e9 / o.video->color_clock_hz;
+    AmigaQuadModel model(mc);
+    SweepResult r;
+
+    int q[2] = { 3, 3 };     // QX, QY
+    int pins[2] = { 3, 3 };  // State on the pins
+    static const uint8_t LINE_H[2]  = { L_DOWN, L_UP };
+    static const uint8_t LINE_HQ[2] = { L_RIGHT, L_LEFT };
+    for (int a = 0; a < 2; a++) {
+        model.edge({ 0, LINE_H[a], FW_H[q[a]] });
+        model.edge({ 0, LINE_HQ[a], FW_HQ[q[a]] });
+    }
+
+    Scaler sx{ fw_mouse_multiplier(speed) }, sy{ fw_mouse_multiplier(speed) };
+    const uint64_t pulse_ns = FW_PULSE_LENGTH * 1000ULL;
+    uint64_t t = 0;
+
+    auto step = [&](int a, bool inc) {
+        if (q[a] != pins[a]) {
+            if (FW_H[q[a]] != FW_H[pins[a]]) model.edge({ t, LINE_H[a], FW_H[q[a]] });
+            if (FW_HQ[q[a]] != FW_HQ[pins[a]]) model.edge({ t, LINE_HQ[a], FW_HQ[q[a]] });
+            pins[a] = q[a];
+        }
+        t += pulse_ns;
+        q[a] = inc ? (q[a] + 1) & 3 : (q[a] + 3) & 3;
+    };
+
+    for (int i = 0; i < o.reports; i++) {
+        t = std::max(t, (uint64_t)(3 * o.video->frame_ns + i * o.interval_ns));
+        int d = delta_for(o, delta, i);
+        int fx = sx.next(o.ax_x ? d : 0), fy = sy.next(o.ax_y ? d : 0);
+        r.intended[0] -= fx; // A_Right (dx > 0) counts down
+        r.intended[1] -= fy; // A_Down (dy > 0) counts down
+        r.expected[0] -= fx;
+        r.expected[1] -= fy;
+        int xs = abs(fx), ys = abs(fy);
+        while ((xs | ys) != 0) {
+            if (xs) { step(0, fx < 0); xs--; }
+            if (ys) { step(1, fy < 0); ys--; }
+        }
+    }
+    model.advance(t + (uint64_t)(5 * o.video->frame_ns));
+
+    for (int a = 0; a < 2; a++) {
+        r.quad[a] = model.axis(a);
+        r.decoded[a] = r.quad[a].decoded;
+        int p = (q[a] - pins[a]) & 3;
+        r.pending[a] = (p == 1) ? 1 : (p == 3) ? -1 : 0;
+        r.problems[a] = r.quad[a].skipped + r.quad[a].overflows;
+    }
+    return r;
+}
+
+
+// ==========================================
+// 📊 PART 4: SWEEP REPORT
+// ==========================================
+
+static int64_t miss_of(const SweepResult &r, int a) {
+    return r.expected[a] - r.decoded[a] - r.pending[a];
+}
+
+#define SWEEP_SMALL 32 // Deltas a mouse really sends in play
+
+static void run_sweep(const SweepOpts &o, bool csv) {
+    const char *console = o.amiga ? "AMIGA" : "C64";
+    if (csv) {
+        printf("# tag,console,video,speed,delta,intended_x,expected_x,decoded_x,pending_x,intended_y,expected_y,decoded_y,pending_y,problems_x,problems_y\n");
+    } else {
+        printf("=== SWEEP %s %s: %d reports every %.1f ms, ISR jitter %.1f us, axes %s%s%s ===\n",
+               console, o.video->name, o.reports, o.interval_ns / 1e6, o.jitter_ns / 1e3,
+               o.ax_x ? "X" : "", o.ax_y ? "Y" : "", o.zigzag ? ", zigzag" : "");
+        if (o.amiga) printf(" SPEED  MULT  CLEAN UP TO  DELTAS LOST  WORST <=%d  WORST  SKIPPED  OVERFLOW FRAMES\n", SWEEP_SMALL);
+        else         printf(" SPEED  MULT  CLEAN UP TO  DELTAS LOST  WORST <=%d  WORST  DRIFT <=%d  ODD DROPPED  EARLY  LATE  EMPTY  OUTSIDE 64-191\n", SWEEP_SMALL, SWEEP_SMALL);
+    }
+
+    for (int speed = 1; speed <= 5; speed++) {
+        int clean = -1, lost = 0;
+        int64_t worst = 0, worst_small = 0, drift_small = 0;
+        uint64_t tot[5] = { 0, 0, 0, 0, 0 };
+        bool clean_run = true;
+        for (int mag = 0; mag <= 127; mag++) {
+            bool bad = false;
+            for (int sign = 1; sign >= -1; sign -= 2) {
+                if (mag == 0 && sign < 0) continue;
+                int delta = sign * mag;
+                SweepResult r = o.amiga ? sweep_amiga(o, speed, delta) : sweep_c64(o, speed, delta);
+                bool this_bad = false;
+                for (int a = 0; a < 2; a++) {
+                    int64_t m = miss_of(r, a);
+                    if (llabs(m) > llabs(worst)) worst = m;
+                    if (mag <= SWEEP_SMALL && llabs(m) > llabs(worst_small)) worst_small = m;
+                    int64_t drift = r.intended[a] - r.expected[a];
+                    if (mag <= SWEEP_SMALL && llabs(drift) > llabs(drift_small)) drift_small = drift;
+                    if (m != 0 || r.problems[a]) this_bad = true;
+                    if (o.amiga) {
+                        tot[0] += r.quad[a].skipped;
+                        tot[1] += r.quad[a].overflows;
+                    } else {
+                        tot[0] += r.sid[a].early;
+                        tot[1] += r.sid[a].late;
+                        tot[2] += r.sid[a].empty;
+                        tot[3] += r.sid[a].outside_safe;
+                        tot[4] += r.sid[a].odd_dropped;
+                    }
+                }
+                if (this_bad) lost++;
+                bad |= this_bad;
+                if (csv) {
+                    printf("SWEEP,%s,%s,%d,%d,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%llu,%llu\n", console, o.video->name, speed, delta,
+                           (long long)r.intended[0], (long long)r.expected[0], (long long)r.decoded[0], (long long)r.pending[0],
+                           (long long)r.intended[1], (long long)r.expected[1], (long long)r.decoded[1], (long long)r.pending[1],
+                           (unsigned long long)r.problems[0], (unsigned long long)r.problems[1]);
+                }
+            }
+            if (bad) clean_run = false;
+            if (clean_run) clean = mag;
+        }
+        if (csv) continue;
+        if (o.amiga) {
+            printf("   %d   %5.2f     %4d      %5d     %+7lld  %+6lld  %7llu  %9llu\n", speed, fw_mouse_multiplier(speed), clean, lost,
+                   (long long)worst_small, (long long)worst, (unsigned long long)tot[0], (unsigned long long)tot[1]);
+        } else {
+            printf("   %d   %5.2f     %4d      %5d     %+7lld  %+6lld    %+7lld     %8llu  %5llu %5llu  %5llu  %14llu\n", speed, fw_mouse_multiplier(speed), clean, lost,
+                   (long long)worst_small, (long long)worst, (long long)drift_small, (unsigned long long)tot[4],
+                   (unsigned long long)tot[0], (unsigned long long)tot[1], (unsigned long long)tot[2], (unsigned long long)tot[3]);
+        }
+    }
+    if (!csv) {
+        printf(" CLEAN UP TO = largest |delta| for which every smaller delta arrives exact (-1 = none)\n");
+        printf(" DELTAS LOST = deltas (of 255) where the computer's position differs from what the pins encode\n");
+        printf(" WORST = largest position error in counts (expected - decoded) after all reports\n");
+        if (!o.amiga) {
+            printf(" Expected = what the pulse delays encode; DRIFT = firmware counts the delays do not encode\n");
+            printf(" ODD DROPPED = frames where the 1351 driver dropped the odd count of a move (it steps by 2)\n");
+        }
+    }
+}
+
+
+// ==========================================
+// 📼 PART 5: TRACE REPLAY AND MAIN
+// ==========================================
+
+static void replay(const std::vector<Edge> &edges, const Video &video, int console, const double sync_us[2]) {
+    std::vector<Edge> sorted = edges;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Edge &a, const Edge &b) { return a.t_ns < b.t_ns; });
+    uint64_t end = sorted.empty() ? 0 : sorted.back().t_ns + (uint64_t)video.frame_ns;
+    printf(" %zu edges over %.3f s, %s timing\n", sorted.size(), end / 1e9, video.name);
+
+    if (console != 1) {
+        SidPotModel::Config mc;
+        mc.video = video;
+        const PotCal &cal = (&video == &VIDEO_NTSC) ? CAL_NTSC : CAL_PAL;
+        mc.sync_to_count_ns[0] = sync_us[0] >= 0 ? sync_us[0] * 1000.0 : count_start_ns(cal.base_min_x, video);
+        mc.sync_to_count_ns[1] = sync_us[1] >= 0 ? sync_us[1] * 1000.0 : count_start_ns(cal.base_min_y, video);
+        SidPotModel m(mc);
+        for (const Edge &e : sorted) if (e.t_ns) m.edge(e);
+        m.advance(end);
+        printf("\n=== C64 SID POT (counting starts %.1f / %.1f us after SYNC) ===\n",
+               mc.sync_to_count_ns[0] / 1e3, mc.sync_to_count_ns[1] / 1e3);
+        printf(" AXIS  PERIODS   PULSES  COUNTED  EARLY   LATE  EMPTY  SHORT  OUTSIDE 64-191  ODD DROPPED  POSITION\n");
+        for (int a = 0; a < 2; a++) {
+            const SidAxisStats &s = m.axis(a);
+            printf("  %c   %8llu %8llu %8llu %6llu %6llu %6llu %6llu  %14llu  %11llu  %+8lld\n", a ? 'Y' : 'X',
+                   (unsigned long long)s.periods, (unsigned long long)s.pulses, (unsigned long long)s.in_window,
+                   (unsigned long long)s.early, (unsigned long long)s.late, (unsigned long long)s.empty,
+                   (unsigned long long)s.short_pulses, (unsigned long long)s.outside_safe, (unsigned long long)s.odd_dropped,
+                   (long long)s.decoded);
+        }
+        printf(" Position in SID counts, 2 per pointer step of the 1351 driver\n");
+    }
+    if (console != 0) {
+        AmigaQuadModel::Config mc;
+        mc.video = video;
+        mc.sample_ns = 1e9 / video.color_clock_hz;
+        AmigaQuadModel m(mc);
+        for (const Edge &e : sorted) m.edge(e);
+        m.advance(end);
+        printf("\n=== AMIGA QUADRATURE (sampled every %.1f ns) ===\n", mc.sample_ns);
+        printf(" AXIS    STEPS  SKIPPED  FRAMES  OVERFLOWS   COUNTED  POSITION\n");
+        for (int a = 0; a < 2; a++) {
+            const QuadAxisStats &s = m.axis(a);
+            printf("  %c   %8llu %8llu %7llu %10llu  %+8lld  %+8lld\n", a ? 'Y' : 'X',
+                   (unsigned long long)s.steps, (unsigned long long)s.skipped, (unsigned long long)s.frames,
+                   (unsigned long long)s.overflows, (long long)s.counted, (long long)s.decoded);
+        }
+        printf(" Positive = left / up (QX, QY counting up)\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = nullptr;
+    bool sweep = false, csv = false;
+    int console = -1; // -1 both / from the trace header, 0 C64, 1 Amiga
+    const Video *video = nullptr;
+    double sync_us[2] = { -1, -1 };
+    SweepOpts o;
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (!strcmp(a, "--sweep")) sweep = true;
+        else if (!strcmp(a, "--csv")) csv = true;
+        else if (!strcmp(a, "--c64")) console = 0;
+        else if (!strcmp(a, "--amiga")) console = 1;
+        else if (!strcmp(a, "--pal")) video = &VIDEO_PAL;
+        else if (!strcmp(a, "--ntsc")) video = &VIDEO_NTSC;
+        else if (!strcmp(a, "--zigzag")) o.zigzag = true;
+        else if (!strcmp(a, "--reports") && i + 1 < argc) o.reports = atoi(argv[++i]);
+        else if (!strcmp(a, "--interval-ms") && i + 1 < argc) o.interval_ns = atof(argv[++i]) * 1e6;
+        else if (!strcmp(a, "--jitter-us") && i + 1 < argc) o.jitter_ns = atof(argv[++i]) * 1e3;
+        else if (!strcmp(a, "--axes") && i + 1 < argc) { const char *v = argv[++i]; o.ax_x = strchr(v, 'x'); o.ax_y = strchr(v, 'y'); }
+        else if (!strcmp(a, "--sync-offset-us") && i + 2 < argc) { sync_us[0] = atof(argv[++i]); sync_us[1] = atof(argv[++i]); }
+        else if (a[0] != '-') path = a;
+        else { sweep = false; path = nullptr; break; }
+    }
+    if (!sweep && !path) {
+        fprintf(stderr, "Usage: %s edges.txt [--c64|--amiga] [--pal|--ntsc] [--sync-offset-us X Y]\n"
+                        "       %s --sweep [--c64|--amiga] [--pal|--ntsc] [--reports N] [--interval-ms MS]\n"
+                        "                  [--jitter-us US] [--axes xy|x|y] [--zigzag] [--csv]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    if (sweep) {
+        o.video = video ? video : &VIDEO_PAL;
+        if (console < 0) {
+            o.amiga = false; run_sweep(o, csv);
+            if (!csv) printf("\n");
+            o.amiga = true;  run_sweep(o, csv);
+        } else {
+            o.amiga = console == 1;
+            run_sweep(o, csv);
+        }
+        return 0;
+    }
+
+    std::vector<Edge> edges;
+    const Video *trace_video = &VIDEO_PAL;
+    int trace_console = -1;
+    if (!load_edges(path, edges, &trace_video, &trace_console)) return 1;
+    printf("=== PIN TRACE %s ===\n", path);
+    replay(edges, video ? *video : *trace_video, console >= 0 ? console : trace_console, sync_us);
+    return 0;
+}
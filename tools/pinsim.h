@@ -0,0 +1,313 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Pin Timing Models (host library)
+// File: tools/pinsim.h
+// Description: Cycle-level models of the C64 SID POT sampling (1351 mouse) and of the Amiga
+//              Denise quadrature counters, fed with DB9 pin edges. Used by tools/pin_sim.cpp.
+// ==========================================
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace pinsim {
+
+// ==========================================
+// 📍 PART 1: EDGES AND VIDEO TIMING
+// ==========================================
+// Edge trace (text): one edge per line, '<time us> <LINE> <0|1>', '#' starts a comment.
+// Levels are electrical (1 = HIGH). Lines: the DB9 joystick lines, the C64 POT drive transistors
+// (POTX_DRV = GP4, POTY_DRV = GP6, 1 = pulling the POT line up) and SYNC (GP1, the SID cycle edge).
+
+enum Line : uint8_t {
+    L_UP, L_DOWN, L_LEFT, L_RIGHT, L_FIRE1, L_FIRE2, L_POTY, L_POTX_DRV, L_POTY_DRV, L_SYNC, L_COUNT
+};
+
+static const char *const LINE_NAMES[L_COUNT] = {
+    "UP", "DOWN", "LEFT", "RIGHT", "FIRE1", "FIRE2", "POTY", "POTX_DRV", "POTY_DRV", "SYNC"
+};
+
+struct Edge {
+    uint64_t t_ns;
+    uint8_t line;
+    uint8_t level;
+};
+
+struct Video {
+    const char *name;
+    double phi2_hz;         // SID / CPU clock
+    double frame_ns;        // One video frame: the driver reads the mouse once per frame
+    double color_clock_hz;  // Amiga colour clock (Denise samples the mouse lines with it)
+};
+
+// PAL: 312 lines x 63 cycles, NTSC: 263 lines x 65 cycles
+static const Video VIDEO_PAL  = { "PAL",  985248.0,  312.0 * 63.0 / 985248.0 * 1e9,  3546895.0 };
+static const Video VIDEO_NTSC = { "NTSC", 1022727.0, 263.0 * 65.0 / 1022727.0 * 1e9, 3579545.0 };
+
+inline int line_from_name(const char *s) {
+    for (int i = 0; i < L_COUNT; i++) if (!strcmp(s, LINE_NAMES[i])) return i;
+    return -1;
+}
+
+// Loads an edge trace; '# video PAL|NTSC' and '# console C64|AMIGA' header lines are reported back
+inline bool load_edges(const char *path, std::vector<Edge> &out, const Video **video, int *amiga) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[256];
+    int ln = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ln++;
+        char word[32], value[32];
+        if (sscanf(line, "# video %31s", value) == 1 && video) *video = strcmp(value, "NTSC") ? &VIDEO_PAL : &VIDEO_NTSC;
+        if (sscanf(line, "# console %31s", value) == 1 && amiga) *amiga = !strcmp(value, "AMIGA");
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        double t_us;
+        int level;
+        int n = sscanf(line, "%lf %31s %d", &t_us, word, &level);
+        if (n <= 0) continue;
+        int l = (n == 3) ? line_from_name(word) : -1;
+        if (l < 0 || t_us < 0) {
+            fprintf(stderr, "%s:%d: expected '<time us> <LINE> <0|1>'\n", path, ln);
+            fclose(f);
+            return false;
+        }
+        out.push_back({ (uint64_t)llround(t_us * 1000.0), (uint8_t)l, (uint8_t)(level != 0) });
+    }
+    fclose(f);
+    return true;
+}
+
+
+// ==========================================
+// 🎛️ PART 2: C64 SID POT MODEL (1351 MOUSE)
+// ==========================================
+// Every SID POT period is 512 cycles: 256 cycles with the POT lines grounded, 256 cycles of
+// counting. The counter stops at the first cycle where the line is above threshold; the value is
+// latched at the end of the period (255 = nothing seen). The SYNC edge marks the period and the
+// counting starts sync_to_count_ns later (pin_sim.cpp derives it from BASE_MIN_X/Y).
+// A pulse before the counting window is lost (the SID is still discharging the line), one after
+// it reads 255. The mouse driver reads the latched value once per frame and applies the 1351 rule
+// (MOVCHK in the 1351 manual): 7-bit difference to the last accepted value, sign-extended, halved.
+// A difference of -1, 0 or +1 is noise: no movement, the old value is kept. Otherwise the new
+// value is accepted and the odd count of the difference is dropped (a real 1351 steps by 2).
+// Positions are kept in SID counts (2 per pointer step) so they compare with the firmware's counts.
+
+struct SidAxisStats {
+    uint64_t periods = 0;       // SID periods seen (SYNC edges)
+    uint64_t pulses = 0;        // Drive pulses seen
+    uint64_t in_window = 0;     // Pulses that set the counter
+    uint64_t early = 0;         // Pulse during the discharge phase (lost)
+    uint64_t late = 0;          // Pulse after the 256-cycle window (reads 255)
+    uint64_t outside_safe = 0;  // Counter value outside [safe_lo, safe_hi]
+    uint64_t empty = 0;         // Period without a usable pulse while the mouse is active
+    uint64_t short_pulses = 0;  // Narrower than min_pulse_ns
+    uint64_t odd_dropped = 0;   // Frames where the driver dropped the odd count of a move
+    int64_t decoded = 0;        // Position seen by the 1351 driver (SID counts)
+};
+
+class SidPotModel {
+public:
+    struct Config {
+        Video video = VIDEO_PAL;
+        double sync_to_count_ns[2] = { 245000.0, 244000.0 };
+        double min_pulse_ns = 500.0;
+        int safe_lo = 64, safe_hi = 191;
+    };
+
+    explicit SidPotModel(const Config &c) : cfg(c), cycle_ns(1e9 / c.video.phi2_hz), next_frame_ns(c.video.frame_ns) {}
+
+    void edge(const Edge &e) {
+        advance(e.t_ns);
+        if (e.line == L_SYNC && e.level) {
+            for (int a = 0; a < 2; a++) close_period(a);
+            synced = true;
+            for (int a = 0; a < 2; a++) {
+                count_start[a] = (double)e.t_ns + cfg.sync_to_count_ns[a];
+                period_value[a] = -1;
+                ax[a].periods++;
+            }
+            return;
+        }
+        int a = (e.line == L_POTX_DRV) ? 0 : (e.line == L_POTY_DRV) ? 1 : -1;
+        if (a < 0) return;
+        if (e.level) { rise_ns[a] = e.t_ns; rising[a] = true; return; }
+        if (!rising[a]) return;
+        rising[a] = false;
+        on_pulse(a, rise_ns[a], e.t_ns - rise_ns[a]);
+    }
+
+    // Frames up to t_ns are read
+    void advance(uint64_t t_ns) {
+        while (next_frame_ns <= (double)t_ns) {
+            for (int a = 0; a < 2; a++) read_frame(a);
+            next_frame_ns += cfg.video.frame_ns;
+        }
+    }
+
+    const SidAxisStats &axis(int a) const { return ax[a]; }
+    double counts_per_cycle_ns() const { return cycle_ns; }
+
+    // Counts latched but not accepted by the driver yet (the +-1 it treats as noise)
+    int held(int a) const {
+        if (last_read[a] < 0) return 0;
+        return sext7(pot_reg[a] - last_read[a]);
+    }
+
+private:
+    Config cfg;
+    double cycle_ns;
+    double next_frame_ns;
+    bool synced = false;
+    double count_start[2] = { 0, 0 };
+    int period_value[2] = { -1, -1 };   // Counter of the running period (-1 = none yet)
+    int pot_reg[2] = { 255, 255 };      // Last latched value (what the CPU reads)
+    int last_read[2] = { -1, -1 };      // Last value the driver accepted
+    bool active[2] = { false, false };  // A pulse was seen once: empty periods count from here on
+    uint64_t rise_ns[2] = { 0, 0 };
+    bool rising[2] = { false, false };
+    SidAxisStats ax[2];
+
+    void on_pulse(int a, uint64_t rise, uint64_t width) {
+        if (!synced) return;
+        ax[a].pulses++;
+        active[a] = true;
+        if (width < cfg.min_pulse_ns) ax[a].short_pulses++;
+        double rel = (double)rise - count_start[a];
+        if (rel < 0) { ax[a].early++; return; }
+        int value = (int)(rel / cycle_ns);
+        if (value > 255) { ax[a].late++; return; }
+        if (period_value[a] >= 0) return; // Counter already stopped in this period
+        period_value[a] = value;
+        ax[a].in_window++;
+        if (value < cfg.safe_lo || value > cfg.safe_hi) ax[a].outside_safe++;
+    }
+
+    void close_period(int a) {
+        if (!synced) return;
+        if (period_value[a] < 0) {
+            if (active[a]) ax[a].empty++;
+            pot_reg[a] = 255;
+        } else {
+            pot_reg[a] = period_value[a];
+        }
+    }
+
+    static int sext7(int d) {
+        d &= 0x7F;
+        return d >= 64 ? d - 128 : d;
+    }
+
+    void read_frame(int a) {
+        int v = pot_reg[a];
+        if (last_read[a] < 0) { last_read[a] = v; return; }
+        int d = sext7(v - last_read[a]);
+        if (d >= -1 && d <= 1) return;     // Noise: keep the old value
+        if (d & 1) ax[a].odd_dropped++;
+        ax[a].decoded += 2 * (d >> 1);     // -3 -> -2 steps (arithmetic shift, ROR with carry set)
+        last_read[a] = v;
+    }
+};
+
+
+// ==========================================
+// 🖱️ PART 3: AMIGA QUADRATURE MODEL
+// ==========================================
+// Denise samples each axis pair (X: DOWN = H, RIGHT = HQ / Y: UP = V, LEFT = VQ) once per
+// sample_ns and counts one step per Gray-code move into an 8-bit counter. Two moves inside one
+// sample look like a jump of two states: direction unknown, both counts lost. The OS reads the
+// counter once per frame and takes the signed 8-bit difference, so more than 127 steps in one
+// frame wrap around and are read with the wrong size or sign.
+
+struct QuadAxisStats {
+    uint64_t steps = 0;       // Gray moves seen by the counter
+    uint64_t skipped = 0;     // Two-state jumps (2 counts lost each)
+    uint64_t frames = 0;
+    uint64_t overflows = 0;   // Frames with more than 127 steps (wrapped read)
+    int64_t counted = 0;      // Counter movement (what the hardware counted)
+    int64_t decoded = 0;      // Position after the per-frame 8-bit reads
+};
+
+class AmigaQuadModel {
+public:
+    struct Config {
+        Video video = VIDEO_PAL;
+        double sample_ns = 1e9 / 3546895.0;
+    };
+
+    explicit AmigaQuadModel(const Config &c) : cfg(c), next_frame_ns(c.video.frame_ns) {
+        for (int a = 0; a < 2; a++) { lv[a][0] = lv[a][1] = 1; sampled[a] = state(a); }
+    }
+
+    void edge(const Edge &e) {
+        int a = -1, bit = 0;
+        switch (e.line) {
+            case L_DOWN:  a = 0; bit = 0; break;
+            case L_RIGHT: a = 0; bit = 1; break;
+            case L_UP:    a = 1; bit = 0; break;
+            case L_LEFT:  a = 1; bit = 1; break;
+            default: break;
+        }
+        advance(e.t_ns);
+        if (a < 0) return;
+        lv[a][bit] = e.level;
+        if (e.t_ns == 0) { sampled[a] = state(a); return; } // Idle level, not a move
+        last_edge_idx[a] = (int64_t)floor(e.t_ns / cfg.sample_ns);
+        pending[a] = true;
+    }
+
+    void advance(uint64_t t_ns) {
+        while (next_frame_ns <= (double)t_ns) {
+            for (int a = 0; a < 2; a++) { settle(a, next_frame_ns); read_frame(a); }
+            next_frame_ns += cfg.video.frame_ns;
+        }
+        for (int a = 0; a < 2; a++) settle(a, (double)t_ns);
+    }
+
+    const QuadAxisStats &axis(int a) const { return ax[a]; }
+
+private:
+    Config cfg;
+    double next_frame_ns;
+    uint8_t lv[2][2];
+    int sampled[2];
+    bool pending[2] = { false, false };
+    int64_t last_edge_idx[2] = { -1, -1 };
+    uint8_t counter[2] = { 0, 0 };
+    uint8_t last_read[2] = { 0, 0 };
+    int64_t counted_at_read[2] = { 0, 0 };
+    QuadAxisStats ax[2];
+
+    // Gray position of the firmware's H/HQ tables: (L,L)=0 (L,H)=1 (H,H)=2 (H,L)=3
+    int state(int a) const {
+        static const int GRAY[4] = { 0, 1, 3, 2 }; // index = H << 1 | HQ
+        return GRAY[(lv[a][0] << 1) | lv[a][1]];
+    }
+
+    // The first sample after the last edge takes the new state
+    void settle(int a, double t_ns) {
+        if (!pending[a] || (int64_t)floor(t_ns / cfg.sample_ns) <= last_edge_idx[a]) return;
+        pending[a] = false;
+        int now = state(a);
+        int diff = (now - sampled[a]) & 3;
+        sampled[a] = now;
+        if (diff == 1)      { counter[a]++; ax[a].counted++; ax[a].steps++; }
+        else if (diff == 3) { counter[a]--; ax[a].counted--; ax[a].steps++; }
+        else if (diff == 2) ax[a].skipped++;
+    }
+
+    void read_frame(int a) {
+        int8_t d = (int8_t)(uint8_t)(counter[a] - last_read[a]);
+        int64_t real = ax[a].counted - counted_at_read[a];
+        if (real != d) ax[a].overflows++;
+        ax[a].decoded += d;
+        ax[a].frames++;
+        last_read[a] = counter[a];
+        counted_at_read[a] = ax[a].counted;
+    }
+};
+
+} // namespace pinsim
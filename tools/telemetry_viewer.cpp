@@ -0,0 +1,253 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Telemetry Viewer (Linux host tool)
+// File: tools/telemetry_viewer.cpp
+// Description: Decodes the firmware's binary telemetry stream live, draws a terminal
+//              dashboard and optionally logs every frame to a CSV file.
+//
+// Build: g++ -O2 -std=c++17 -o telemetry_viewer tools/telemetry_viewer.cpp
+// Usage: telemetry_viewer /dev/ttyUSB0 [-b 921600] [-o log.csv] [--start]
+//   --start   open the port at 115200, send 'telemetry <baud>' and switch over
+//   q / Ctrl-C quits and sends 'telemetry off' so the adapter goes back to text
+// ==========================================
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../USBtoC64/TelemetryProtocol.h"
+
+static volatile sig_atomic_t g_quit = 0;
+static void on_signal(int) { g_quit = 1; }
+
+static double now_s() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ==========================================
+// 🔌 PART 1: SERIAL PORT
+// ==========================================
+
+static speed_t baud_constant(unsigned long baud) {
+    switch (baud) {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default:      return 0;
+    }
+}
+
+static bool set_baud(int fd, unsigned long baud) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, baud_constant(baud));
+    cfsetospeed(&tio, baud_constant(baud));
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) return false;
+    tcflush(fd, TCIOFLUSH);
+    return true;
+}
+
+static void send_line(int fd, const char *line) {
+    if (write(fd, line, strlen(line)) < 0 || write(fd, "\n", 1) < 0) perror("write");
+    tcdrain(fd);
+}
+
+// ==========================================
+// 📊 PART 2: DASHBOARD
+// ==========================================
+
+struct Stats {
+    unsigned long frames = 0, lost = 0, drops = 0, reports = 0;
+    long mouse_x = 0, mouse_y = 0;
+    bool have_seq = false;
+    uint16_t last_seq = 0;
+    TelemState last = {};
+    // Latency over the current one-second window
+    unsigned long lat_n = 0;
+    double q_sum = 0, p_sum = 0;
+    unsigned q_max = 0, p_max = 0;
+    unsigned long win_frames = 0, win_reports = 0;
+    double win_start = 0;
+    // Values shown on screen (previous complete window)
+    double q_avg = 0, p_avg = 0, fps = 0, rps = 0;
+    unsigned q_peak = 0, p_peak = 0;
+};
+
+static const char *MODE_NAMES[] = { "PLAY", "SERVICE", "SNIFFER", "RAW", "TEST", "GPIO", "LAG", "COLOR", "AUTO", "INJECT", "BENCH" };
+static const char *WORD_NAMES[] = { "UP", "DOWN", "LEFT", "RIGHT", "F1", "F2", "F3", "UPALT", "AUTO",
+                                    "GREEN", "YELLOW", "RW", "FW", "PLAY" };
+static const char *PIN_NAMES[]  = { "UP", "DOWN", "LEFT", "RIGHT", "FIRE1", "FIRE2", "POTY", "C64SIG" };
+
+static void account(Stats &s, uint16_t seq, const TelemState &st) {
+    if (s.have_seq) s.lost += (uint16_t)(seq - s.last_seq - 1);
+    s.have_seq = true;
+    s.last_seq = seq;
+    s.last = st;
+    s.frames++;
+    s.win_frames++;
+    s.drops += st.drops;
+    s.reports += st.reports;
+    s.win_reports += st.reports;
+    s.mouse_x += st.mouse_dx;
+    s.mouse_y += st.mouse_dy;
+    if (st.reports) {
+        s.lat_n++;
+        s.q_sum += st.lat_queue_us;
+        s.p_sum += st.lat_pins_us;
+        if (st.lat_queue_us > s.q_max) s.q_max = st.lat_queue_us;
+        if (st.lat_pins_us > s.p_max) s.p_max = st.lat_pins_us;
+    }
+}
+
+static void roll_window(Stats &s, double t) {
+    double dt = t - s.win_start;
+    if (dt < 1.0) return;
+    s.fps = s.win_frames / dt;
+    s.rps = s.win_reports / dt;
+    s.q_avg = s.lat_n ? s.q_sum / s.lat_n : 0;
+    s.p_avg = s.lat_n ? s.p_sum / s.lat_n : 0;
+    s.q_peak = s.q_max;
+    s.p_peak = s.p_max;
+    s.lat_n = 0; s.q_sum = s.p_sum = 0; s.q_max = s.p_max = 0;
+    s.win_frames = s.win_reports = 0;
+    s.win_start = t;
+}
+
+static void draw(const Stats &s, const TelemDecoder &d, const char *port, unsigned long baud) {
+    const TelemState &st = s.last;
+    printf("\x1b[H\x1b[2J");
+    printf("==========================================\n");
+    printf("   USB -> DB9 TELEMETRY   %s @ %lu\n", port, baud);
+    printf("==========================================\n");
+    printf(" MODE   : %-8s  PORT: %s   DEVICE: %s%s\n",
+           st.mode < sizeof(MODE_NAMES) / sizeof(*MODE_NAMES) ? MODE_NAMES[st.mode] : "?",
+           (st.flags & TELEM_FLAG_AMIGA) ? "AMIGA" : "C64",
+           (st.flags & TELEM_FLAG_DEVICE) ? "PAD " : "",
+           (st.flags & TELEM_FLAG_MOUSE) ? "MOUSE" : "");
+    printf("------------------------------------------\n");
+    printf(" PINS   :");
+    for (int i = 0; i < 8; i++) printf(" %s%s\x1b[0m", (st.pins & (1 << i)) ? "\x1b[7m" : "", PIN_NAMES[i]);
+    printf("\n WORD   : 0x%04X ", st.word);
+    for (int i = 0; i < 14; i++) if (st.word & (1 << i)) printf("[%s] ", WORD_NAMES[i]);
+    printf("\n MOUSE  : X %+6ld  Y %+6ld  (total counts)\n", s.mouse_x, s.mouse_y);
+    printf("------------------------------------------\n");
+    printf(" LATENCY (1 s window)      avg      max\n");
+    printf("  USB -> loop dequeue  : %6.0f us %6u us\n", s.q_avg, s.q_peak);
+    printf("  dequeue -> pins      : %6.0f us %6u us\n", s.p_avg, s.p_peak);
+    printf("------------------------------------------\n");
+    printf(" FRAMES : %lu (%.0f/s)  REPORTS: %.0f/s\n", s.frames, s.fps, s.rps);
+    printf(" LOST   : %lu seq gaps | %lu UART drops | %lu CRC errors | %lu bytes skipped\n",
+           s.lost, s.drops, d.crc_errors, d.skipped);
+    printf("------------------------------------------\n");
+    printf(" q = quit\n");
+    fflush(stdout);
+}
+
+// ==========================================
+// 🚀 PART 3: MAIN
+// ==========================================
+
+int main(int argc, char **argv) {
+    const char *port = nullptr, *csv_path = nullptr;
+    unsigned long baud = 921600;
+    bool start = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc) baud = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) csv_path = argv[++i];
+        else if (!strcmp(argv[i], "--start")) start = true;
+        else if (argv[i][0] != '-') port = argv[i];
+        else { port = nullptr; break; }
+    }
+    if (!port || !baud_constant(baud)) {
+        fprintf(stderr, "Usage: %s <serial port> [-b 921600] [-o log.csv] [--start]\n", argv[0]);
+        return 1;
+    }
+
+    int fd = open(port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) { perror(port); return 1; }
+    if (start) {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "telemetry %lu", baud);
+        set_baud(fd, 115200);
+        send_line(fd, cmd);
+        usleep(100000); // The firmware prints its banner at 115200, then switches
+    }
+    if (!set_baud(fd, baud)) { perror("tcsetattr"); return 1; }
+
+    FILE *csv = nullptr;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) { perror(csv_path); return 1; }
+        fprintf(csv, "host_s,seq,t_us,word,pins,mode,lat_queue_us,lat_pins_us,mouse_dx,mouse_dy,reports,drops,flags\n");
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // Keys without Enter (for 'q')
+    termios tty_old, tty_raw;
+    bool tty = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &tty_old) == 0;
+    if (tty) {
+        tty_raw = tty_old;
+        tty_raw.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &tty_raw);
+    }
+
+    TelemDecoder dec;
+    Stats stats;
+    double t0 = now_s(), last_draw = 0;
+    stats.win_start = t0;
+    uint8_t rx[4096];
+
+    while (!g_quit) {
+        pollfd fds[2] = { { fd, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+        poll(fds, tty ? 2 : 1, 50);
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t got = read(fd, rx, sizeof(rx));
+            if (got < 0 && errno != EAGAIN) { perror("read"); break; }
+            double t = now_s();
+            for (ssize_t i = 0; i < got; i++) {
+                if (!dec.push(rx[i])) continue;
+                if (dec.type() != TELEM_TYPE_STATE || dec.len() < sizeof(TelemState)) continue;
+                TelemState st;
+                memcpy(&st, dec.payload(), sizeof(st));
+                account(stats, dec.seq(), st);
+                if (csv) {
+                    fprintf(csv, "%.6f,%u,%u,%u,%u,%u,%u,%u,%d,%d,%u,%u,%u\n", t - t0, dec.seq(), st.t_us, st.word,
+                            st.pins, st.mode, st.lat_queue_us, st.lat_pins_us, st.mouse_dx, st.mouse_dy,
+                            st.reports, st.drops, st.flags);
+                }
+            }
+        }
+        if (tty && (fds[1].revents & POLLIN)) {
+            char c;
+            if (read(STDIN_FILENO, &c, 1) == 1 && (c == 'q' || c == 'Q')) g_quit = 1;
+        }
+
+        double t = now_s();
+        roll_window(stats, t);
+        if (t - last_draw >= 0.1) { draw(stats, dec, port, baud); last_draw = t; }
+    }
+
+    send_line(fd, "telemetry off");
+    if (tty) tcsetattr(STDIN_FILENO, TCSANOW, &tty_old);
+    if (csv) fclose(csv);
+    close(fd);
+    printf("\n%lu frames decoded%s%s\n", stats.frames, csv_path ? ", log saved to " : "", csv_path ? csv_path : "");
+    return 0;
+}
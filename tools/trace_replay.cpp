@@ -0,0 +1,272 @@
+// ==========================================
+// USB to C64/Amiga Adapter - Trace Replay (host tool)
+// File: tools/trace_replay.cpp
+// Description: Replays a configurator trace (.uct, see TRACE_FORMAT.md) through the firmware's own
+//              process_joystick() (InputEngine.h, built with the tools/host shims), prints the decoded
+//              joystick states and times the decoder.
+//
+// Build: g++ -O2 -std=c++17 -I tools/host -isystem USBtoC64 [-I <folder with JoystickMapping.h>] -o trace_replay tools/trace_replay.cpp
+// Usage: trace_replay trace.uct [--dump] [--all] [--bench 100] [--profile N] [--html] [--debounce fast|full]
+//   --dump      print every report as hex
+//   --all       print the decoded state of every report, not only the changes
+//   --bench     decode the whole trace N times and report ns per report
+//   --profile   decode with PROFILES[N] (default: the VID/PID match, as usb_match_profile() without a fingerprint)
+//   --html      decode with the JoystickMapping.h rules (needs one on the include path)
+//   --debounce  run the glitch filter as the 'debounce' command would (default OFF)
+// ==========================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "InputEngine.h"
+
+// CLI commands ServiceTools.h forwards to modules outside the decode path
+void usb_apply_focus_profile(const PadConfig &) {}
+void print_usb_devices() {}
+void run_power_benchmark(uint32_t) {}
+bool telemetry_start(uint32_t) { return false; }
+void telemetry_stop() {}
+bool inject_start(uint32_t) { return false; }
+void inject_service() {}
+
+// ==========================================
+// 📼 PART 1: TRACE FILE
+// ==========================================
+
+#define TRACE_MAGIC        "UCT1"
+#define TRACE_VERSION      1
+#define TRACE_REC_FULL     0
+#define TRACE_REC_DELTA    1
+#define TRACE_FLAG_REPORT_ID 0x0001
+
+struct Report {
+    uint64_t t_us;                // Since the first report
+    std::vector<uint8_t> data;
+    bool delta;                   // Stored as a delta record
+};
+
+struct Trace {
+    uint16_t vid = 0, pid = 0, flags = 0;
+    uint32_t count = 0, duration_us = 0;
+    std::string name;
+    std::vector<Report> reports;
+    size_t file_bytes = 0;
+};
+
+struct Reader {
+    const std::vector<uint8_t> &b;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint8_t u8() {
+        if (pos >= b.size()) { ok = false; return 0; }
+        return b[pos++];
+    }
+    uint16_t u16() { uint16_t lo = u8(); return (uint16_t)(lo | (u8() << 8)); }
+    uint32_t u32() { uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16); }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t c = u8();
+            v |= (uint64_t)(c & 0x7F) << shift;
+            if (!(c & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+static bool load_trace(const char *path, Trace &tr) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+    fclose(f);
+    tr.file_bytes = buf.size();
+
+    Reader r{ buf };
+    char magic[4];
+    for (char &c : magic) c = (char)r.u8();
+    if (!r.ok || memcmp(magic, TRACE_MAGIC, 4) != 0) { fprintf(stderr, "%s: not a .uct trace\n", path); return false; }
+    uint16_t version = r.u16();
+    if (version != TRACE_VERSION) { fprintf(stderr, "%s: trace version %u not supported\n", path, version); return false; }
+    tr.vid = r.u16();
+    tr.pid = r.u16();
+    tr.flags = r.u16();
+    tr.count = r.u32();
+    tr.duration_us = r.u32();
+    uint8_t name_len = r.u8();
+    for (int i = 0; i < name_len; i++) tr.name += (char)r.u8();
+
+    uint64_t t = 0;
+    std::vector<uint8_t> prev;
+    for (uint32_t i = 0; i < tr.count && r.ok; i++) {
+        Report rep;
+        t += r.varint();
+        rep.t_us = t;
+        uint8_t kind = r.u8();
+        if (kind == TRACE_REC_FULL) {
+            uint8_t len = r.u8();
+            for (int k = 0; k < len; k++) rep.data.push_back(r.u8());
+            rep.delta = false;
+        } else if (kind == TRACE_REC_DELTA && !prev.empty()) {
+            rep.data = prev;
+            size_t mask_len = (prev.size() + 7) / 8;
+            std::vector<uint8_t> mask(mask_len);
+            for (auto &m : mask) m = r.u8();
+            for (size_t k = 0; k < prev.size(); k++) {
+                if (mask[k / 8] & (1 << (k % 8))) rep.data[k] = r.u8();
+            }
+            rep.delta = true;
+        } else {
+            fprintf(stderr, "%s: bad record %u (kind %u)\n", path, i, kind);
+            return false;
+        }
+        prev = rep.data;
+        tr.reports.push_back(std::move(rep));
+    }
+    if (!r.ok) { fprintf(stderr, "%s: truncated after %zu of %u reports\n", path, tr.reports.size(), tr.count); return false; }
+    return true;
+}
+
+// ==========================================
+// 🕹️ PART 2: DECODER REPLAY
+// ==========================================
+
+// The decoder the adapter runs: process_joystick() on a fresh DevState, in play mode, with the
+// replay clock at the report's time stamp (autofire and the filters read millis()).
+struct Replay {
+    const PadConfig *prof = nullptr;
+    DevState ds = {};
+};
+
+static void replay_begin(Replay &rp, const PadConfig &prof, bool html, DebounceMode deb) {
+    current_mode = MODE_PLAY;
+    device_connected = true;
+    active_output_mode = OUT_JOYSTICK;
+    use_html_configurator = html;
+    debounce_mode = deb;
+    build_debounce_masks();
+    build_stick_tables();
+    rp.prof = &prof;
+    memset(&rp.ds, 0, sizeof(rp.ds));
+}
+
+static uint16_t replay_report(Replay &rp, const Report &rep) {
+    host_time_us = rep.t_us;
+    process_joystick(*rp.prof, rp.ds, rep.data.data(), (int)rep.data.size());
+    return rp.ds.word;
+}
+
+// usb_match_profile() without the fingerprint (a trace has no report descriptor)
+static int match_profile(uint16_t vid, uint16_t pid) {
+    for (int i = 0; i < NUM_PROFILES; i++) {
+        if (PROFILES[i].vid == vid && PROFILES[i].pid == pid) return i;
+    }
+    return -1;
+}
+
+static void print_word(uint64_t t_us, uint16_t w) {
+    printf("%10.3f ms  %s%s%s%s%s%s%s%s%s%s%s%s%s%s\n", t_us / 1000.0,
+           (w & JS_UP) ? "UP " : "", (w & JS_DOWN) ? "DOWN " : "", (w & JS_LEFT) ? "LEFT " : "", (w & JS_RIGHT) ? "RIGHT " : "",
+           (w & JS_FIRE1) ? "FIRE1 " : "", (w & JS_FIRE2) ? "FIRE2 " : "", (w & JS_FIRE3) ? "FIRE3 " : "",
+           (w & JS_UP_ALT) ? "UP_ALT " : "", (w & JS_AUTO) ? "[AUTOFIRE] " : "",
+           (w & JS_FACE3) ? "GREEN " : "", (w & JS_FACE4) ? "YELLOW " : "", (w & JS_SHOULDER_L) ? "REW " : "",
+           (w & JS_SHOULDER_R) ? "FWD " : "", (w & JS_START) ? "PLAY " : "");
+}
+
+// ==========================================
+// 🚀 PART 3: MAIN
+// ==========================================
+
+int main(int argc, char **argv) {
+    const char *path = nullptr;
+    bool dump = false, all = false, html = false;
+    int bench = 100, profile = -1;
+    DebounceMode deb = DEB_OFF;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--dump")) dump = true;
+        else if (!strcmp(argv[i], "--all")) all = true;
+        else if (!strcmp(argv[i], "--html")) html = true;
+        else if (!strcmp(argv[i], "--bench") && i + 1 < argc) bench = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc) profile = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--debounce") && i + 1 < argc) {
+            const char *m = argv[++i];
+            deb = !strcmp(m, "full") ? DEB_FULL : !strcmp(m, "fast") ? DEB_FAST : DEB_OFF;
+        }
+        else if (argv[i][0] != '-') path = argv[i];
+        else { path = nullptr; break; }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s trace.uct [--dump] [--all] [--bench N] [--profile N] [--html] [--debounce fast|full]\n", argv[0]);
+        return 1;
+    }
+
+    Trace tr;
+    if (!load_trace(path, tr)) return 1;
+
+    size_t deltas = 0;
+    for (const Report &rep : tr.reports) deltas += rep.delta;
+    double secs = tr.duration_us / 1e6;
+    printf("=== TRACE %s ===\n", path);
+    printf(" Device   : %s (VID %u / PID %u)%s\n", tr.name.c_str(), tr.vid, tr.pid,
+           (tr.flags & TRACE_FLAG_REPORT_ID) ? ", report ID in byte 0" : "");
+    printf(" Reports  : %u over %.3f s (%.0f Hz)\n", tr.count, secs, secs > 0 ? (tr.count - 1) / secs : 0.0);
+    printf(" Encoding : %zu full + %zu delta records, %zu bytes (%.1f B/report)\n",
+           tr.reports.size() - deltas, deltas, tr.file_bytes, tr.count ? (double)tr.file_bytes / tr.count : 0.0);
+
+    if (dump) {
+        for (const Report &rep : tr.reports) {
+            printf("%10.3f ms %c", rep.t_us / 1000.0, rep.delta ? ' ' : '*');
+            for (uint8_t b : rep.data) printf(" %02X", b);
+            printf("\n");
+        }
+    }
+
+#if !HAS_HTML_CONFIGURATOR
+    if (html) { fprintf(stderr, "--html: no JoystickMapping.h (custom mode) on the include path\n"); return 1; }
+#endif
+    if (profile < 0 && !html) profile = match_profile(tr.vid, tr.pid);
+    if (profile >= NUM_PROFILES) { fprintf(stderr, "--profile: %d profiles (0..%d)\n", NUM_PROFILES, NUM_PROFILES - 1); return 1; }
+    if (profile < 0 && !html) {
+        printf("\n(no profile for VID %u / PID %u: pick one with --profile N, or --html)\n", tr.vid, tr.pid);
+        return 0;
+    }
+    // In HTML mode the profile only adds its report-ID multiplexing (--profile), as the slot's map does
+    PadConfig html_prof = PadConfig();
+    html_prof.name = "none";
+    const PadConfig &prof = profile >= 0 ? PROFILES[profile] : html_prof;
+    static const char *DEB_NAMES[] = { "OFF", "FAST", "FULL" };
+
+    printf("\n=== DECODED (%s, debounce %s) ===\n", html ? "JoystickMapping.h" : prof.name, DEB_NAMES[deb]);
+    Replay rp;
+    replay_begin(rp, prof, html, deb);
+    uint16_t last = 0;
+    size_t changes = 0;
+    for (size_t i = 0; i < tr.reports.size(); i++) {
+        uint16_t w = replay_report(rp, tr.reports[i]);
+        if (all || i == 0 || w != last) {
+            print_word(tr.reports[i].t_us, w);
+            if (i) changes++;
+        }
+        last = w;
+    }
+    printf(" %zu state changes\n", changes);
+
+    if (bench > 0 && !tr.reports.empty()) {
+        volatile unsigned sink = 0;
+        replay_begin(rp, prof, html, deb);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int k = 0; k < bench; k++) {
+            for (const Report &rep : tr.reports) sink = sink + replay_report(rp, rep);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        printf(" Decoder  : %.1f ns/report on this host (%d passes)\n", ns / ((double)bench * tr.reports.size()), bench);
+    }
+    return 0;
+}